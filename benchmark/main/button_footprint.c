@@ -0,0 +1,313 @@
+/*
+ * Memory footprint benchmark for the button component (on target)
+ *
+ * Creates 1..N buttons, N being the free pins of the target (at most 16),
+ * on the timer service runtime and on a dedicated engine, and reports per
+ * configuration:
+ *  - heap bytes taken by the buttons (total and per button)
+ *  - kernel objects created (timers, mutexes, tasks)
+ *  - timer service queue usage during a bounce storm on every pin
+ *
+ * Each result is one "BENCH {json}" line, the same format as
+ * test/bench_footprint.py on the host, so CI can diff runs across commits.
+ *
+ * The pins are driven as INPUT_OUTPUT, so no wiring is needed. The storm is
+ * generated from a task that outranks the timer service task on its core,
+ * so every timer command posted from the GPIO ISR stays queued until the
+ * storm ends; the queue usage is therefore the number of accepted commands,
+ * and the rejected ones are reported as overflows.
+ */
+#include <stdio.h>
+#include <inttypes.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/timers.h"
+#include "freertos/semphr.h"
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include "esp_rom_sys.h"
+#include "esp_log.h"
+#include "button_longpress.h"
+
+static const char *TAG = "BTN_FOOTPRINT";
+
+#define BENCH_STORM_EDGES 20
+
+/*
+ * Candidate pins per target: no strapping, flash, PSRAM, USB or console UART
+ * pins. Pins the target cannot drive are dropped at startup, see
+ * bench_select_pins().
+ */
+static const gpio_num_t s_candidate_pins[] = {
+#if CONFIG_IDF_TARGET_ESP32
+    GPIO_NUM_4, GPIO_NUM_5, GPIO_NUM_13, GPIO_NUM_14, GPIO_NUM_18, GPIO_NUM_19, GPIO_NUM_21, GPIO_NUM_22,
+    GPIO_NUM_23, GPIO_NUM_25, GPIO_NUM_26, GPIO_NUM_27,
+#if !CONFIG_SPIRAM
+    GPIO_NUM_16, GPIO_NUM_17,
+#endif
+#if !CONFIG_RTC_CLK_SRC_EXT_CRYS
+    GPIO_NUM_32, GPIO_NUM_33,
+#endif
+#elif CONFIG_IDF_TARGET_ESP32S2
+    GPIO_NUM_1, GPIO_NUM_2, GPIO_NUM_3, GPIO_NUM_4, GPIO_NUM_5, GPIO_NUM_6, GPIO_NUM_7, GPIO_NUM_8,
+    GPIO_NUM_9, GPIO_NUM_10, GPIO_NUM_11, GPIO_NUM_12, GPIO_NUM_13, GPIO_NUM_14, GPIO_NUM_17, GPIO_NUM_18,
+#elif CONFIG_IDF_TARGET_ESP32S3
+    GPIO_NUM_1, GPIO_NUM_2, GPIO_NUM_4, GPIO_NUM_5, GPIO_NUM_6, GPIO_NUM_7, GPIO_NUM_8, GPIO_NUM_9,
+    GPIO_NUM_10, GPIO_NUM_11, GPIO_NUM_12, GPIO_NUM_13, GPIO_NUM_14, GPIO_NUM_17, GPIO_NUM_18, GPIO_NUM_21,
+#elif CONFIG_IDF_TARGET_ESP32C3
+    GPIO_NUM_0, GPIO_NUM_1, GPIO_NUM_3, GPIO_NUM_4, GPIO_NUM_5, GPIO_NUM_6, GPIO_NUM_7, GPIO_NUM_10,
+#elif CONFIG_IDF_TARGET_ESP32C6
+    GPIO_NUM_0, GPIO_NUM_1, GPIO_NUM_2, GPIO_NUM_3, GPIO_NUM_6, GPIO_NUM_7, GPIO_NUM_10, GPIO_NUM_11,
+    GPIO_NUM_18, GPIO_NUM_19, GPIO_NUM_20, GPIO_NUM_21, GPIO_NUM_22, GPIO_NUM_23,
+#elif CONFIG_IDF_TARGET_ESP32H2
+    GPIO_NUM_0, GPIO_NUM_1, GPIO_NUM_4, GPIO_NUM_5, GPIO_NUM_10, GPIO_NUM_11, GPIO_NUM_12, GPIO_NUM_13,
+    GPIO_NUM_14, GPIO_NUM_22,
+#else
+    /* Unknown target: low pins, which every target has */
+    GPIO_NUM_4, GPIO_NUM_5, GPIO_NUM_6, GPIO_NUM_7,
+#endif
+};
+
+#define BENCH_MAX_BUTTONS (sizeof(s_candidate_pins) / sizeof(s_candidate_pins[0]))
+
+static gpio_num_t s_pins[BENCH_MAX_BUTTONS];
+static size_t s_pin_count;
+
+/*
+ * The storm must run on the core of the timer service task to keep it from
+ * draining its queue. The engine goes to the other core when there is one.
+ */
+#if CONFIG_FREERTOS_UNICORE
+#define BENCH_STORM_CORE 0
+#define BENCH_ENGINE_CORE 0
+#else
+#if defined(CONFIG_FREERTOS_TIMER_SERVICE_TASK_CORE_AFFINITY) && CONFIG_FREERTOS_TIMER_SERVICE_TASK_CORE_AFFINITY >= 0
+#define BENCH_STORM_CORE CONFIG_FREERTOS_TIMER_SERVICE_TASK_CORE_AFFINITY
+#else
+#define BENCH_STORM_CORE 0
+#endif
+#define BENCH_ENGINE_CORE (BENCH_STORM_CORE == 0 ? 1 : 0)
+#endif
+
+typedef struct {
+    uint32_t timers;
+    uint32_t mutexes;
+    uint32_t tasks;
+    uint32_t timer_commands;
+    uint32_t timer_queue_overflows;
+} bench_counters_t;
+
+static volatile bench_counters_t s_counters;
+
+/* Linker wrappers, see CMakeLists.txt */
+
+#if tskKERNEL_VERSION_MAJOR > 10 || (tskKERNEL_VERSION_MAJOR == 10 && tskKERNEL_VERSION_MINOR >= 5)
+typedef BaseType_t bench_auto_reload_t;
+#else
+typedef UBaseType_t bench_auto_reload_t;
+#endif
+
+TimerHandle_t __real_xTimerCreate(const char *name, TickType_t period, bench_auto_reload_t auto_reload,
+                                  void *id, TimerCallbackFunction_t cb);
+
+TimerHandle_t __wrap_xTimerCreate(const char *name, TickType_t period, bench_auto_reload_t auto_reload,
+                                  void *id, TimerCallbackFunction_t cb)
+{
+    TimerHandle_t timer = __real_xTimerCreate(name, period, auto_reload, id, cb);
+    if (timer != NULL) {
+        s_counters.timers++;
+    }
+    return timer;
+}
+
+QueueHandle_t __real_xQueueCreateMutex(const uint8_t type);
+
+QueueHandle_t __wrap_xQueueCreateMutex(const uint8_t type)
+{
+    QueueHandle_t mutex = __real_xQueueCreateMutex(type);
+    if (mutex != NULL) {
+        s_counters.mutexes++;
+    }
+    return mutex;
+}
+
+BaseType_t __real_xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, const uint32_t stack,
+                                          void *arg, UBaseType_t prio, TaskHandle_t *handle, const BaseType_t core);
+
+BaseType_t __wrap_xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, const uint32_t stack,
+                                          void *arg, UBaseType_t prio, TaskHandle_t *handle, const BaseType_t core)
+{
+    BaseType_t ret = __real_xTaskCreatePinnedToCore(fn, name, stack, arg, prio, handle, core);
+    if (ret == pdPASS) {
+        s_counters.tasks++;
+    }
+    return ret;
+}
+
+static BaseType_t bench_count_command(BaseType_t ret)
+{
+    if (ret == pdPASS) {
+        s_counters.timer_commands++;
+    } else {
+        s_counters.timer_queue_overflows++;
+    }
+    return ret;
+}
+
+#if tskKERNEL_VERSION_MAJOR > 10 || (tskKERNEL_VERSION_MAJOR == 10 && tskKERNEL_VERSION_MINOR >= 5)
+BaseType_t __real_xTimerGenericCommandFromTask(TimerHandle_t timer, const BaseType_t cmd, const TickType_t value,
+                                               BaseType_t *const woken, const TickType_t wait);
+BaseType_t __real_xTimerGenericCommandFromISR(TimerHandle_t timer, const BaseType_t cmd, const TickType_t value,
+                                              BaseType_t *const woken, const TickType_t wait);
+
+BaseType_t __wrap_xTimerGenericCommandFromTask(TimerHandle_t timer, const BaseType_t cmd, const TickType_t value,
+                                               BaseType_t *const woken, const TickType_t wait)
+{
+    return bench_count_command(__real_xTimerGenericCommandFromTask(timer, cmd, value, woken, wait));
+}
+
+BaseType_t IRAM_ATTR __wrap_xTimerGenericCommandFromISR(TimerHandle_t timer, const BaseType_t cmd, const TickType_t value,
+                                                        BaseType_t *const woken, const TickType_t wait)
+{
+    return bench_count_command(__real_xTimerGenericCommandFromISR(timer, cmd, value, woken, wait));
+}
+#else
+BaseType_t __real_xTimerGenericCommand(TimerHandle_t timer, const BaseType_t cmd, const TickType_t value,
+                                       BaseType_t *const woken, const TickType_t wait);
+
+BaseType_t IRAM_ATTR __wrap_xTimerGenericCommand(TimerHandle_t timer, const BaseType_t cmd, const TickType_t value,
+                                                 BaseType_t *const woken, const TickType_t wait)
+{
+    return bench_count_command(__real_xTimerGenericCommand(timer, cmd, value, woken, wait));
+}
+#endif
+
+static void bench_reset_counters(void)
+{
+    s_counters = (bench_counters_t) {0};
+}
+
+typedef struct {
+    size_t count;
+    TaskHandle_t caller;
+} bench_storm_t;
+
+static void bench_storm_task(void *arg)
+{
+    bench_storm_t *storm = arg;
+
+    /* Nothing below yields, so the timer service task cannot drain its queue */
+    for (int edge = 0; edge < BENCH_STORM_EDGES; edge++) {
+        for (size_t i = 0; i < storm->count; i++) {
+            gpio_set_level(s_pins[i], (edge + 1) & 1);
+        }
+        esp_rom_delay_us(5);
+    }
+    xTaskNotifyGive(storm->caller);
+    vTaskDelete(NULL);
+}
+
+static void bench_run(const char *runtime, button_engine_handle_t engine, size_t count)
+{
+    button_handle_t buttons[BENCH_MAX_BUTTONS];
+
+    for (size_t i = 0; i < count; i++) {
+        gpio_reset_pin(s_pins[i]);
+    }
+
+    bench_reset_counters();
+    size_t free_before = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+
+    for (size_t i = 0; i < count; i++) {
+        button_config_t config = {
+            .gpio_num = s_pins[i],
+            .active_level = 1,
+            .debounce_time_ms = 20,
+            .long_press_time_ms = 1000,
+            .double_click_time_ms = 300,
+            .engine = engine,
+        };
+        buttons[i] = button_create(&config);
+        if (buttons[i] == NULL) {
+            ESP_LOGE(TAG, "Failed to create button %u", (unsigned)i);
+            while (i-- > 0) {
+                button_delete(buttons[i]);
+            }
+            return;
+        }
+        /* Drive the pin from software, the pull-down keeps it released */
+        gpio_set_direction(s_pins[i], GPIO_MODE_INPUT_OUTPUT);
+        gpio_set_level(s_pins[i], 0);
+    }
+
+    size_t heap_bytes = free_before - heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    bench_counters_t created = s_counters;
+
+    /* Let the initial debounce settle before the storm */
+    vTaskDelay(pdMS_TO_TICKS(100));
+    bench_reset_counters();
+
+    bench_storm_t storm = {.count = count, .caller = xTaskGetCurrentTaskHandle()};
+    xTaskCreatePinnedToCore(bench_storm_task, "bench_storm", 2048, &storm, configMAX_PRIORITIES - 1, NULL,
+                            BENCH_STORM_CORE);
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    bench_counters_t storm_counters = s_counters;
+
+    vTaskDelay(pdMS_TO_TICKS(2000));
+    for (size_t i = 0; i < count; i++) {
+        button_delete(buttons[i]);
+        gpio_reset_pin(s_pins[i]);
+    }
+    /* Timers are freed by the timer service task */
+    vTaskDelay(pdMS_TO_TICKS(100));
+
+    uint32_t kernel_objects = created.timers + created.mutexes + created.tasks;
+    printf("BENCH {\"bench\": \"footprint\", \"buttons\": %u, \"heap_bytes\": %u, \"heap_per_button\": %u, "
+           "\"kernel_objects\": %" PRIu32 ", \"kernel_objects_per_button\": %.2f, \"runtime\": \"%s\", "
+           "\"target\": \"%s\", \"timer_queue_overflows\": %" PRIu32 ", \"timer_queue_peak\": %" PRIu32 "}\n",
+           (unsigned)count, (unsigned)heap_bytes, (unsigned)(heap_bytes / count),
+           kernel_objects, (double)kernel_objects / count, runtime,
+           CONFIG_IDF_TARGET, storm_counters.timer_queue_overflows, storm_counters.timer_commands);
+}
+
+static void bench_select_pins(void)
+{
+    for (size_t i = 0; i < BENCH_MAX_BUTTONS; i++) {
+        if (GPIO_IS_VALID_OUTPUT_GPIO(s_candidate_pins[i])) {
+            s_pins[s_pin_count++] = s_candidate_pins[i];
+        }
+    }
+}
+
+void app_main(void)
+{
+    bench_select_pins();
+    if (s_pin_count == 0) {
+        ESP_LOGE(TAG, "No usable pins on %s", CONFIG_IDF_TARGET);
+        return;
+    }
+
+    /* Install the interrupt up front so it is not counted against the first button */
+    if (button_isr_install(0) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to install the GPIO interrupt");
+        return;
+    }
+
+    for (size_t count = 1; count <= s_pin_count; count++) {
+        bench_run("timer_service", NULL, count);
+    }
+
+    button_engine_config_t engine_cfg = BUTTON_ENGINE_CONFIG_DEFAULT();
+    engine_cfg.core_id = BENCH_ENGINE_CORE;
+    button_engine_handle_t engine = button_engine_create(&engine_cfg);
+    if (engine == NULL) {
+        ESP_LOGE(TAG, "Failed to create button engine");
+        return;
+    }
+    for (size_t count = 1; count <= s_pin_count; count++) {
+        bench_run("engine", engine, count);
+    }
+    button_engine_delete(engine);
+
+    printf("BENCH_DONE\n");
+}
@@ -0,0 +1,148 @@
+/**
+ * @file button_gesture.c
+ * @brief Gesture recognizer compiled into a deterministic transition table
+ */
+
+#include "sdkconfig.h"
+
+#if !CONFIG_BUTTON_LONGPRESS_LOG
+#define LOG_LOCAL_LEVEL ESP_LOG_NONE
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include "button_gesture.h"
+#include "esp_log.h"
+
+static const char *TAG = "BTN_GESTURE";
+
+#define GESTURE_NO_STATE    0xFF
+
+/**
+ * @brief Compile gesture patterns into a transition table
+ *
+ * The patterns are first inserted into a trie. A breadth-first pass then
+ * computes the failure link of every state, the longest proper suffix that
+ * is also a trie prefix, and fills each missing transition with the one of
+ * that suffix, which yields a complete automaton over the token stream.
+ * 
+ * @param gestures Gesture patterns
+ * @param count Number of gestures
+ * @param out Receives the compiled recognizer
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t button_gesture_compile(const button_gesture_t *gestures, uint8_t count, button_gesture_dfa_t **out)
+{
+    if (gestures == NULL || count == 0 || count > BUTTON_MAX_GESTURES || out == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    /* Validate patterns and bound the number of states */
+    size_t total_tokens = 0;
+    for (uint8_t g = 0; g < count; g++) {
+        if (gestures[g].tokens == NULL || gestures[g].length == 0) {
+            ESP_LOGE(TAG, "Gesture %d is empty", g);
+            return ESP_ERR_INVALID_ARG;
+        }
+        for (uint8_t i = 0; i < gestures[g].length; i++) {
+            if (gestures[g].tokens[i] >= BUTTON_GESTURE_TOKEN_MAX) {
+                ESP_LOGE(TAG, "Gesture %d has an invalid token", g);
+                return ESP_ERR_INVALID_ARG;
+            }
+        }
+        total_tokens += gestures[g].length;
+    }
+    
+    if (total_tokens > BUTTON_GESTURE_MAX_TOKENS) {
+        ESP_LOGE(TAG, "Too many gesture tokens: %d", (int)total_tokens);
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    /* One allocation holds the recognizer, the table and the accept masks */
+    size_t max_states = total_tokens + 1;
+    button_gesture_dfa_t *dfa = calloc(1, sizeof(button_gesture_dfa_t) +
+                                          max_states * sizeof(uint32_t) +
+                                          max_states * BUTTON_GESTURE_TOKEN_MAX);
+    if (dfa == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    dfa->accept = (uint32_t *)(dfa + 1);
+    dfa->next = (uint8_t (*)[BUTTON_GESTURE_TOKEN_MAX])(dfa->accept + max_states);
+    memset(dfa->next, GESTURE_NO_STATE, max_states * BUTTON_GESTURE_TOKEN_MAX);
+    
+    /* Build the trie, state 0 is the root */
+    dfa->state_count = 1;
+    for (uint8_t g = 0; g < count; g++) {
+        uint8_t state = 0;
+        for (uint8_t i = 0; i < gestures[g].length; i++) {
+            uint8_t token = gestures[g].tokens[i];
+            if (dfa->next[state][token] == GESTURE_NO_STATE) {
+                dfa->next[state][token] = dfa->state_count++;
+            }
+            state = dfa->next[state][token];
+        }
+        dfa->accept[state] |= 1UL << g;
+    }
+    
+    /* Breadth-first pass: failure links and missing transitions */
+    uint8_t fail[BUTTON_GESTURE_MAX_TOKENS + 1];
+    uint8_t queue[BUTTON_GESTURE_MAX_TOKENS + 1];
+    uint8_t head = 0;
+    uint8_t tail = 0;
+    
+    for (uint8_t token = 0; token < BUTTON_GESTURE_TOKEN_MAX; token++) {
+        uint8_t child = dfa->next[0][token];
+        if (child == GESTURE_NO_STATE) {
+            dfa->next[0][token] = 0;
+        } else {
+            fail[child] = 0;
+            queue[tail++] = child;
+        }
+    }
+    
+    while (head < tail) {
+        uint8_t state = queue[head++];
+        
+        /* A state also completes every gesture that ends in its suffix */
+        dfa->accept[state] |= dfa->accept[fail[state]];
+        
+        for (uint8_t token = 0; token < BUTTON_GESTURE_TOKEN_MAX; token++) {
+            uint8_t child = dfa->next[state][token];
+            if (child == GESTURE_NO_STATE) {
+                dfa->next[state][token] = dfa->next[fail[state]][token];
+            } else {
+                fail[child] = dfa->next[fail[state]][token];
+                queue[tail++] = child;
+            }
+        }
+    }
+    
+    /* The stream starts after an implicit gap */
+    dfa->state = dfa->next[0][BUTTON_GESTURE_GAP];
+    
+    *out = dfa;
+    return ESP_OK;
+}
+
+/**
+ * @brief Feed one token to the recognizer
+ * 
+ * @param dfa Compiled recognizer
+ * @param token Token produced by the button
+ * @return Bitmask of gestures completed by this token
+ */
+uint32_t button_gesture_feed(button_gesture_dfa_t *dfa, button_gesture_token_t token)
+{
+    dfa->state = dfa->next[dfa->state][token];
+    return dfa->accept[dfa->state];
+}
+
+/**
+ * @brief Free a compiled recognizer
+ * 
+ * @param dfa Compiled recognizer
+ */
+void button_gesture_free(button_gesture_dfa_t *dfa)
+{
+    free(dfa);
+}
@@ -3,16 +3,51 @@
  * @brief Implementation of button handling with debounce, long press, and double-click detection
  */
 
+#include "sdkconfig.h"
+
+/* Logging compiled out: every ESP_LOGx below folds to nothing */
+#if !CONFIG_BUTTON_LONGPRESS_LOG
+#define LOG_LOCAL_LEVEL ESP_LOG_NONE
+#endif
+
+#include <stdatomic.h>
 #include "button_longpress.h"
+#include "button_gesture.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/timers.h"
 #include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include "freertos/stream_buffer.h"
 #include "driver/gpio.h"
 
+#include "esp_intr_alloc.h"
+#include "esp_heap_caps.h"
+
+#if CONFIG_BUTTON_LONGPRESS_SHARED_ISR || CONFIG_BUTTON_LONGPRESS_PM
+#include "hal/gpio_ll.h"
+#include "soc/soc_caps.h"
+#endif
+
+#if CONFIG_BUTTON_LONGPRESS_PM
+#include "esp_pm.h"
+#include "esp_sleep.h"
+#endif
+
 static const char *TAG = "BTN";
 
+ESP_EVENT_DEFINE_BASE(BUTTON_LONGPRESS_EVENT);
+
+#if CONFIG_BUTTON_LONGPRESS_ISR_IRAM
+/* Objects read by the ISR must stay reachable while the flash cache is disabled */
+#define BUTTON_ISR_MEM_CAPS         (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+#define BUTTON_ISR_DEFAULT_FLAGS    ESP_INTR_FLAG_IRAM
+#else
+#define BUTTON_ISR_MEM_CAPS         MALLOC_CAP_DEFAULT
+#define BUTTON_ISR_DEFAULT_FLAGS    0
+#endif
+
 /* Macro for argument validation */
 #define CHECK_ARG(ARG) do { \
     if (!(ARG)) { \
@@ -21,8 +56,232 @@ static const char *TAG = "BTN";
     } \
 } while (0)
 
-/* Button instance structure */
+/* Runtime state of a chord */
+typedef struct {
+    TickType_t start_tick;              /*!< First hold press (hold chord) or click press (click chord) */
+    bool armed;                         /*!< Click buttons pressed while hold buttons were held */
+    bool reported;                      /*!< Hold chord reported, cleared when a member is released */
+} button_chord_state_t;
+
+/* Button group structure */
+typedef struct {
+    atomic_uint_least64_t pressed_mask; /*!< Debounced pressed state, one bit per member */
+    atomic_uint_least64_t suppress_mask; /*!< Members whose events are suppressed until release */
+    uint64_t member_mask;               /*!< Bits in use by member buttons */
+    button_chord_t chords[BUTTON_GROUP_MAX_CHORDS]; /*!< Chord definitions */
+    button_chord_state_t chord_state[BUTTON_GROUP_MAX_CHORDS]; /*!< Chord runtime state */
+    uint8_t chord_count;                /*!< Number of chords */
+    button_event_cb_t chord_callback;   /*!< Chord event callback */
+    void *chord_ctx;                    /*!< User context for chord callback */
+    struct button_engine *shards[BUTTON_GROUP_MAX_SHARDS]; /*!< Engines new members are spread over */
+    struct button_dev *members[BUTTON_GROUP_MAX_BUTTONS]; /*!< Member buttons by bit index */
+    uint8_t shard_count;                /*!< Number of shards, 0 if not sharded */
+    portMUX_TYPE lock;                  /*!< Protects member_mask, members, chords and shards */
+} button_group_t;
+
+/* Click state machine states, finer grained than button_state_t */
+typedef enum {
+    BUTTON_FSM_IDLE,                    /*!< Released, nothing pending */
+    BUTTON_FSM_DOWN,                    /*!< First press held, may still become a click */
+    BUTTON_FSM_WAIT,                    /*!< Released after one click, double click window open */
+    BUTTON_FSM_DOWN2,                   /*!< Second press held, double click on release */
+    BUTTON_FSM_DOUBLE_DOWN,             /*!< Double click reported on press, still held */
+    BUTTON_FSM_DOUBLE,                  /*!< Released after a double click */
+    BUTTON_FSM_HELD,                    /*!< Auto-repeating, no longer a click */
+    BUTTON_FSM_LONG,                    /*!< Held past the long press threshold */
+    BUTTON_FSM_MAX
+} button_fsm_state_t;
+
+/* Click state machine inputs */
+typedef enum {
+    BUTTON_INPUT_PRESS,                 /*!< Debounced press */
+    BUTTON_INPUT_PRESS_DC,              /*!< Debounced press, double clicks reported on press */
+    BUTTON_INPUT_RELEASE,               /*!< Debounced release */
+    BUTTON_INPUT_CANCEL,                /*!< Release of a press owned by a chord */
+    BUTTON_INPUT_LONG,                  /*!< Long press threshold reached */
+    BUTTON_INPUT_REPEAT,                /*!< Auto-repeat reported */
+    BUTTON_INPUT_TIMEOUT,               /*!< Double click timer expired */
+    BUTTON_INPUT_MAX
+} button_fsm_input_t;
+
+/* Transition actions, executed in the order listed */
+#define BUTTON_ACT_WINDOW_START  (1U << 0)  /*!< Open the double click window */
+#define BUTTON_ACT_WINDOW_STOP   (1U << 1)  /*!< Close the double click window */
+#define BUTTON_ACT_GAP_ARM       (1U << 2)  /*!< Start measuring the gesture gap */
+#define BUTTON_ACT_GAP_STOP      (1U << 3)  /*!< Stop measuring the gesture gap */
+#define BUTTON_ACT_UNSUPPRESS    (1U << 4)  /*!< Hand the button back from its chord */
+#define BUTTON_ACT_FEED_SHORT    (1U << 5)  /*!< Feed a short press to the gesture recognizer */
+#define BUTTON_ACT_EMIT_CLICK    (1U << 6)  /*!< Report BUTTON_EVENT_CLICK */
+#define BUTTON_ACT_EMIT_DOUBLE   (1U << 7)  /*!< Report BUTTON_EVENT_DOUBLE_CLICK */
+#define BUTTON_ACT_EMIT_LONG     (1U << 8)  /*!< Report BUTTON_EVENT_LONG_PRESS */
+#define BUTTON_ACT_FEED_LONG     (1U << 9)  /*!< Feed a long press to the gesture recognizer */
+#define BUTTON_ACT_FEED_GAP      (1U << 10) /*!< Feed a gap to the gesture recognizer */
+
+/* Release that ends the click sequence */
+#define BUTTON_ACT_RELEASE_END   (BUTTON_ACT_FEED_SHORT | BUTTON_ACT_GAP_ARM)
+/* Release of a press owned by a chord */
+#define BUTTON_ACT_CANCEL        (BUTTON_ACT_UNSUPPRESS | BUTTON_ACT_GAP_ARM)
+/* Long press reached */
+#define BUTTON_ACT_LONG          (BUTTON_ACT_EMIT_LONG | BUTTON_ACT_FEED_LONG)
+
+/* Click state machine transition */
 typedef struct {
+    uint8_t next;                       /*!< Next button_fsm_state_t */
+    uint16_t actions;                   /*!< BUTTON_ACT_* flags */
+} button_fsm_transition_t;
+
+#define T(next, actions) { BUTTON_FSM_##next, (actions) }
+
+/* Without double click detection a first release is a click right away */
+#if CONFIG_BUTTON_LONGPRESS_DOUBLE_CLICK
+#define BUTTON_RELEASE_FIRST T(WAIT, BUTTON_ACT_FEED_SHORT | BUTTON_ACT_WINDOW_START)
+#else
+#define BUTTON_RELEASE_FIRST T(IDLE, BUTTON_ACT_FEED_SHORT | BUTTON_ACT_EMIT_CLICK)
+#endif
+
+/*
+ * Transition table indexed by state and input. Const, so it is placed in
+ * flash and every input costs one lookup and a fixed sequence of actions.
+ * Impossible combinations (e.g. a press while pressed) keep the state.
+ */
+static const button_fsm_transition_t s_fsm_table[BUTTON_FSM_MAX][BUTTON_INPUT_MAX] = {
+    [BUTTON_FSM_IDLE] = {
+        [BUTTON_INPUT_PRESS]    = T(DOWN, BUTTON_ACT_GAP_STOP),
+        [BUTTON_INPUT_PRESS_DC] = T(DOWN, BUTTON_ACT_GAP_STOP),
+        [BUTTON_INPUT_RELEASE]  = T(IDLE, 0),
+        [BUTTON_INPUT_CANCEL]   = T(IDLE, 0),
+        [BUTTON_INPUT_LONG]     = T(IDLE, 0),
+        [BUTTON_INPUT_REPEAT]   = T(IDLE, 0),
+        [BUTTON_INPUT_TIMEOUT]  = T(IDLE, BUTTON_ACT_FEED_GAP),
+    },
+    [BUTTON_FSM_DOWN] = {
+        [BUTTON_INPUT_PRESS]    = T(DOWN, 0),
+        [BUTTON_INPUT_PRESS_DC] = T(DOWN, 0),
+        [BUTTON_INPUT_RELEASE]  = BUTTON_RELEASE_FIRST,
+        [BUTTON_INPUT_CANCEL]   = T(IDLE, BUTTON_ACT_CANCEL),
+        [BUTTON_INPUT_LONG]     = T(LONG, BUTTON_ACT_LONG),
+        [BUTTON_INPUT_REPEAT]   = T(HELD, 0),
+        [BUTTON_INPUT_TIMEOUT]  = T(DOWN, 0),
+    },
+    [BUTTON_FSM_WAIT] = {
+        [BUTTON_INPUT_PRESS]    = T(DOWN2, BUTTON_ACT_WINDOW_STOP),
+        [BUTTON_INPUT_PRESS_DC] = T(DOUBLE_DOWN, BUTTON_ACT_WINDOW_STOP | BUTTON_ACT_EMIT_DOUBLE),
+        [BUTTON_INPUT_RELEASE]  = T(WAIT, 0),
+        [BUTTON_INPUT_CANCEL]   = T(WAIT, 0),
+        [BUTTON_INPUT_LONG]     = T(WAIT, 0),
+        [BUTTON_INPUT_REPEAT]   = T(WAIT, 0),
+        [BUTTON_INPUT_TIMEOUT]  = T(IDLE, BUTTON_ACT_EMIT_CLICK | BUTTON_ACT_FEED_GAP),
+    },
+    [BUTTON_FSM_DOWN2] = {
+        [BUTTON_INPUT_PRESS]    = T(DOWN2, 0),
+        [BUTTON_INPUT_PRESS_DC] = T(DOWN2, 0),
+        [BUTTON_INPUT_RELEASE]  = T(DOUBLE, BUTTON_ACT_RELEASE_END | BUTTON_ACT_EMIT_DOUBLE),
+        [BUTTON_INPUT_CANCEL]   = T(IDLE, BUTTON_ACT_CANCEL),
+        [BUTTON_INPUT_LONG]     = T(LONG, BUTTON_ACT_LONG),
+        [BUTTON_INPUT_REPEAT]   = T(HELD, 0),
+        [BUTTON_INPUT_TIMEOUT]  = T(DOWN2, 0),
+    },
+    [BUTTON_FSM_DOUBLE_DOWN] = {
+        [BUTTON_INPUT_PRESS]    = T(DOUBLE_DOWN, 0),
+        [BUTTON_INPUT_PRESS_DC] = T(DOUBLE_DOWN, 0),
+        [BUTTON_INPUT_RELEASE]  = T(DOUBLE, BUTTON_ACT_RELEASE_END),
+        [BUTTON_INPUT_CANCEL]   = T(IDLE, BUTTON_ACT_CANCEL),
+        [BUTTON_INPUT_LONG]     = T(LONG, BUTTON_ACT_LONG),
+        [BUTTON_INPUT_REPEAT]   = T(DOUBLE_DOWN, 0),
+        [BUTTON_INPUT_TIMEOUT]  = T(DOUBLE_DOWN, 0),
+    },
+    [BUTTON_FSM_DOUBLE] = {
+        [BUTTON_INPUT_PRESS]    = T(DOWN, BUTTON_ACT_GAP_STOP),
+        [BUTTON_INPUT_PRESS_DC] = T(DOWN, BUTTON_ACT_GAP_STOP),
+        [BUTTON_INPUT_RELEASE]  = T(DOUBLE, 0),
+        [BUTTON_INPUT_CANCEL]   = T(DOUBLE, 0),
+        [BUTTON_INPUT_LONG]     = T(DOUBLE, 0),
+        [BUTTON_INPUT_REPEAT]   = T(DOUBLE, 0),
+        [BUTTON_INPUT_TIMEOUT]  = T(DOUBLE, BUTTON_ACT_FEED_GAP),
+    },
+    [BUTTON_FSM_HELD] = {
+        [BUTTON_INPUT_PRESS]    = T(HELD, 0),
+        [BUTTON_INPUT_PRESS_DC] = T(HELD, 0),
+        [BUTTON_INPUT_RELEASE]  = T(IDLE, BUTTON_ACT_RELEASE_END),
+        [BUTTON_INPUT_CANCEL]   = T(IDLE, BUTTON_ACT_CANCEL),
+        [BUTTON_INPUT_LONG]     = T(LONG, BUTTON_ACT_LONG),
+        [BUTTON_INPUT_REPEAT]   = T(HELD, 0),
+        [BUTTON_INPUT_TIMEOUT]  = T(HELD, 0),
+    },
+    [BUTTON_FSM_LONG] = {
+        [BUTTON_INPUT_PRESS]    = T(LONG, 0),
+        [BUTTON_INPUT_PRESS_DC] = T(LONG, 0),
+        [BUTTON_INPUT_RELEASE]  = T(IDLE, BUTTON_ACT_GAP_ARM),
+        [BUTTON_INPUT_CANCEL]   = T(IDLE, BUTTON_ACT_CANCEL),
+        [BUTTON_INPUT_LONG]     = T(LONG, 0),
+        [BUTTON_INPUT_REPEAT]   = T(LONG, 0),
+        [BUTTON_INPUT_TIMEOUT]  = T(LONG, 0),
+    },
+};
+
+#undef BUTTON_RELEASE_FIRST
+#undef T
+
+/* Public state reported for each state machine state */
+static const uint8_t s_fsm_public_state[BUTTON_FSM_MAX] = {
+    [BUTTON_FSM_IDLE] = BUTTON_STATE_IDLE,
+    [BUTTON_FSM_DOWN] = BUTTON_STATE_PRESSED,
+    [BUTTON_FSM_WAIT] = BUTTON_STATE_IDLE,
+    [BUTTON_FSM_DOWN2] = BUTTON_STATE_PRESSED,
+    [BUTTON_FSM_DOUBLE_DOWN] = BUTTON_STATE_DOUBLE_CLICK,
+    [BUTTON_FSM_DOUBLE] = BUTTON_STATE_DOUBLE_CLICK,
+    [BUTTON_FSM_HELD] = BUTTON_STATE_PRESSED,
+    [BUTTON_FSM_LONG] = BUTTON_STATE_LONG_PRESS,
+};
+
+/* Per-button deadlines, software timers or engine deadlines */
+typedef enum {
+    BUTTON_TIMER_DEBOUNCE,              /*!< Debounce */
+#if CONFIG_BUTTON_LONGPRESS_LONG_PRESS
+    BUTTON_TIMER_HOLD,                  /*!< Single deadline for long press and hold stages */
+#endif
+#if CONFIG_BUTTON_LONGPRESS_DOUBLE_CLICK
+    BUTTON_TIMER_DOUBLE_CLICK,          /*!< Double click detection and gesture gaps */
+#endif
+    BUTTON_TIMER_MAX
+} button_timer_id_t;
+
+/* Start a timer with its configured period */
+#define BUTTON_TIMER_DEFAULT_PERIOD 0
+
+/*
+ * Dedicated engine task running its buttons instead of the timer service task.
+ *
+ * The state scanned on every wake-up is kept per slot in structure-of-arrays
+ * form: one bit per button for pending edges and armed deadlines, and one
+ * packed deadline array per timer, so a scan only touches the bitmaps and
+ * the deadlines that are actually armed, never the button objects.
+ *
+ * Only the scan state is packed. The FSM state, the pressed flag and the
+ * configuration stay in button_dev_t: the handlers are shared with the timer
+ * service runtime, and they read that state only for the buttons that have
+ * an edge or a due deadline, so packing it would not shorten the scan. A
+ * per-button cost of a few bytes would need per-engine copies of the whole
+ * configuration and handler set, which this component does not provide.
+ * The arrays are sized for BUTTON_ENGINE_MAX_BUTTONS slots whatever the
+ * number of buttons: on a 32-bit target 768 bytes of deadlines and 256 bytes
+ * of slot pointers.
+ */
+typedef struct button_engine {
+    TaskHandle_t task;                  /*!< Engine task */
+    SemaphoreHandle_t mutex;            /*!< Recursive, protects the slots while the task runs them */
+    uint64_t used;                      /*!< Occupied slots */
+    atomic_uint_least64_t edge_pending; /*!< GPIO edges not yet picked up, set by the ISR */
+    uint64_t armed[BUTTON_TIMER_MAX];   /*!< Armed deadlines per timer */
+    TickType_t deadlines[BUTTON_TIMER_MAX][BUTTON_ENGINE_MAX_BUTTONS]; /*!< Deadlines in ticks */
+    struct button_dev *slots[BUTTON_ENGINE_MAX_BUTTONS]; /*!< Button in each slot */
+    uint16_t button_count;              /*!< Number of buttons run by the engine */
+    volatile bool stopping;             /*!< Set by button_engine_delete() */
+    SemaphoreHandle_t stopped;          /*!< Given by the task as it exits, taken by button_engine_delete() */
+} button_engine_t;
+
+/* Button instance structure */
+typedef struct button_dev {
     /* Configuration */
     gpio_num_t gpio_num;                /*!< GPIO number for button */
     bool active_level;                  /*!< Button active level */
@@ -30,454 +289,2784 @@ typedef struct {
     uint32_t long_press_time_ms;        /*!< Long press time in milliseconds */
     uint32_t double_click_time_ms;      /*!< Double click time in milliseconds */
     void (*callback)(button_event_t);   /*!< Callback function */
+    bool double_click_on_press;         /*!< Report double click on second press */
+    uint32_t hold_stages_ms[BUTTON_MAX_HOLD_STAGES]; /*!< Ascending hold stage thresholds */
+    uint8_t hold_stage_count;           /*!< Number of hold stages */
+    button_event_cb_t event_callback;   /*!< Extended callback function */
+    void *user_ctx;                     /*!< User context for extended callback */
+    uint32_t repeat_interval_ms;        /*!< Initial auto-repeat interval, 0 if disabled */
+    uint32_t repeat_delay_ms;           /*!< Hold time before the first repeat, 0 to follow long_press_time_ms */
+    uint32_t repeat_min_interval_ms;    /*!< Shortest auto-repeat interval */
+    uint8_t repeat_accel_percent;       /*!< Interval reduction per repeat in percent */
+    uint32_t hold_progress_interval_ms; /*!< Hold progress interval, 0 if disabled */
+    button_sink_t sink;                 /*!< Event sink */
+    button_group_t *group;              /*!< Group the button belongs to, or NULL */
+    int8_t group_index;                 /*!< Bit index in the group, -1 if no group */
+    button_gesture_dfa_t *gestures;     /*!< Compiled gesture recognizer, or NULL */
     
     /* State */
-    button_state_t state;               /*!< Current button state */
+    bool suspended;                     /*!< Interrupt off and deadlines stopped by button_suspend() */
+    uint8_t fsm_state;                  /*!< Click state machine state (button_fsm_state_t) */
     bool is_pressed;                    /*!< Current physical button state */
-    bool waiting_for_double_click;      /*!< Flag indicating waiting for second click */
-    uint8_t click_count;                /*!< Counter for click sequences */
+    bool long_press_reported;           /*!< Long press already reported for this hold */
+    uint8_t next_hold_stage;            /*!< Index of the next hold stage to report */
+    TickType_t press_tick;              /*!< Tick count when the press was confirmed */
+    uint32_t repeat_next_ms;            /*!< Hold time of the next auto-repeat */
+    uint32_t repeat_cur_interval_ms;    /*!< Current (accelerated) auto-repeat interval */
+    uint32_t repeat_count;              /*!< Auto-repeats reported in this hold */
+    uint32_t progress_next_ms;          /*!< Hold time of the next progress event */
+    atomic_uint_least32_t latched_mask; /*!< Events pending for button_consume_events() */
+#if CONFIG_BUTTON_LONGPRESS_ANTI_NOISE
+    uint32_t last_event_ms;             /*!< Time of the last accepted level change, for the anti-noise filter */
+#endif
+#if CONFIG_BUTTON_LONGPRESS_PM
+    atomic_uint pm_armed;               /*!< Pending deadlines (bit per button_timer_id_t) */
+    atomic_bool pm_locked;              /*!< This button holds a reference on s_pm_lock */
+#endif
+#if CONFIG_BUTTON_LONGPRESS_STATS
+    volatile uint32_t sink_drops;       /*!< Records dropped by a full sink, written by the dispatch path only */
+    atomic_uint_least32_t latched_counts[BUTTON_EVENT_MAX]; /*!< Pending occurrences per event */
+#endif
+    
+    /* Timers */
+    TimerHandle_t timers[BUTTON_TIMER_MAX]; /*!< Software timers, NULL on an engine */
+    
+    /* Engine */
+    button_engine_t *engine;            /*!< Engine running the button, NULL for the timer service task */
+    int8_t engine_slot;                 /*!< Slot in the engine, -1 if none */
+    
+    /* Synchronization */
+#if CONFIG_BUTTON_LONGPRESS_SPINLOCK
+    portMUX_TYPE lock;                  /*!< Spinlock for thread safety */
+    uint8_t timers_to_start;            /*!< Timer commands deferred until the lock is released */
+    uint8_t timers_to_stop;
+    bool timers_flushing;               /*!< A task is issuing the deferred commands */
+    TickType_t timer_periods[BUTTON_TIMER_MAX]; /*!< Periods of the deferred starts */
+#else
+    SemaphoreHandle_t mutex;            /*!< Mutex for thread safety */
+#endif
+} button_dev_t;
+
+/**
+ * @brief Create the per-button lock
+ */
+static bool button_lock_init(button_dev_t *btn)
+{
+#if CONFIG_BUTTON_LONGPRESS_SPINLOCK
+    portMUX_INITIALIZE(&btn->lock);
+    return true;
+#else
+    btn->mutex = xSemaphoreCreateMutex();
+    return btn->mutex != NULL;
+#endif
+}
+
+/**
+ * @brief Delete the per-button lock
+ */
+static void button_lock_deinit(button_dev_t *btn)
+{
+#if !CONFIG_BUTTON_LONGPRESS_SPINLOCK
+    if (btn->mutex) {
+        vSemaphoreDelete(btn->mutex);
+    }
+#endif
+}
+
+/**
+ * @brief Take the per-button lock
+ *
+ * @return true if taken, false on mutex error
+ */
+static inline bool button_lock(button_dev_t *btn)
+{
+#if CONFIG_BUTTON_LONGPRESS_SPINLOCK
+    portENTER_CRITICAL(&btn->lock);
+    return true;
+#else
+    return xSemaphoreTake(btn->mutex, portMAX_DELAY) == pdTRUE;
+#endif
+}
+
+/**
+ * @brief Release the per-button lock
+ *
+ * In spinlock mode the timer commands recorded while the lock was held are
+ * issued here, since kernel calls are not allowed inside a critical section.
+ *
+ * The timer service task and user tasks (setters, suspend/resume) both
+ * unlock, so only one of them flushes at a time: a task that finds another
+ * flush running leaves its commands to it, and the flusher re-checks for
+ * new ones before giving up the role. Commands thus reach the timer queue
+ * in lock order, and the last start or stop recorded for a timer wins.
+ */
+static inline void button_unlock(button_dev_t *btn)
+{
+#if CONFIG_BUTTON_LONGPRESS_SPINLOCK
+    if (btn->timers_flushing) {
+        portEXIT_CRITICAL(&btn->lock);
+        return;
+    }
+    btn->timers_flushing = true;
+    
+    while (btn->timers_to_start != 0 || btn->timers_to_stop != 0) {
+        uint8_t start = btn->timers_to_start;
+        uint8_t stop = btn->timers_to_stop;
+        TickType_t periods[BUTTON_TIMER_MAX];
+        
+        for (int id = 0; id < BUTTON_TIMER_MAX; id++) {
+            periods[id] = btn->timer_periods[id];
+        }
+        btn->timers_to_start = 0;
+        btn->timers_to_stop = 0;
+        portEXIT_CRITICAL(&btn->lock);
+        
+        for (int id = 0; id < BUTTON_TIMER_MAX; id++) {
+            if (stop & (1U << id)) {
+                xTimerStop(btn->timers[id], 0);
+            } else if (start & (1U << id)) {
+                xTimerChangePeriod(btn->timers[id], periods[id], 0);
+            }
+        }
+        
+        portENTER_CRITICAL(&btn->lock);
+    }
+    
+    btn->timers_flushing = false;
+    portEXIT_CRITICAL(&btn->lock);
+#else
+    xSemaphoreGive(btn->mutex);
+#endif
+}
+
+/* Waiter in button_wait_event() (on the waiting task's stack) or button_wait_event_async() */
+typedef button_wait_t button_waiter_t;
+
+/* GPIO interrupt installed by button_isr_install() or the first button_create() */
+static bool s_isr_installed = false;
+
+#if CONFIG_BUTTON_LONGPRESS_SHARED_ISR
+/* Button on each pin, dispatched by the shared GPIO interrupt handler */
+static button_dev_t *s_pin_buttons[GPIO_NUM_MAX];
+static intr_handle_t s_isr_handle = NULL;
+static portMUX_TYPE s_isr_lock = portMUX_INITIALIZER_UNLOCKED;
+#endif
+
+#if CONFIG_BUTTON_LONGPRESS_PM
+/* No-light-sleep lock, referenced once by each button with a pending deadline */
+static esp_pm_lock_handle_t s_pm_lock = NULL;
+static portMUX_TYPE s_pm_init_lock = portMUX_INITIALIZER_UNLOCKED;
+#endif
+
+/* Tasks blocked in button_wait_event() */
+static button_waiter_t *s_waiters = NULL;
+static portMUX_TYPE s_waiters_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/* s_waiters != NULL, read by the dispatch path of every engine without the lock,
+ * so shards only meet on s_waiters_lock while a wait is registered */
+static atomic_bool s_waiters_pending = false;
+
+/* Single timer for the nearest button_wait_event_async() deadline */
+static TimerHandle_t s_wait_timer = NULL;
+
+/* Stream buffer sinks and the one task writing each, NULL engine for the timer service task */
+static struct {
+    StreamBufferHandle_t buffer;
+    button_engine_t *engine;
+    uint16_t users;
+} s_stream_sinks[BUTTON_MAX_STREAM_SINKS];
+static portMUX_TYPE s_stream_sinks_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief Check whether a waiter is interested in an event
+ */
+static bool button_waiter_matches(const button_waiter_t *waiter, const button_event_info_t *info)
+{
+    if (!(waiter->event_mask & BUTTON_EVENT_MASK(info->event))) {
+        return false;
+    }
+    if (waiter->handles == NULL) {
+        return true;
+    }
+    for (size_t i = 0; i < waiter->count; i++) {
+        if (waiter->handles[i] == info->button) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Publish whether any waiter is registered, must be called inside s_waiters_lock
+ */
+static inline void button_waiters_update(void)
+{
+    atomic_store_explicit(&s_waiters_pending, s_waiters != NULL, memory_order_release);
+}
+
+/**
+ * @brief Check without the lock whether an event may have waiters
+ */
+static inline bool button_waiters_pending(void)
+{
+    return atomic_load_explicit(&s_waiters_pending, memory_order_acquire);
+}
+
+/**
+ * @brief Remove a waiter from the list, must be called inside s_waiters_lock
+ *
+ * @return true if the waiter was still linked
+ */
+static bool button_waiter_unlink(button_waiter_t *waiter)
+{
+    button_waiter_t **link = &s_waiters;
+    while (*link != NULL && *link != waiter) {
+        link = &(*link)->next;
+    }
+    if (*link == NULL) {
+        return false;
+    }
+    *link = waiter->next;
+    button_waiters_update();
+    return true;
+}
+
+/**
+ * @brief Signal or run the callback of each waiter in a detached list, in order
+ *
+ * A waiter's storage stays valid until it is woken, but not after, so its
+ * link and fields are read first.
+ *
+ * @param info The event, or NULL for timed out asynchronous waits
+ */
+static void button_wake_list(button_waiter_t *list, const button_event_info_t *info)
+{
+    while (list != NULL) {
+        SemaphoreHandle_t signal = list->signal;
+        button_wait_cb_t callback = list->callback;
+        void *ctx = list->ctx;
+        list = list->next;
+        
+        if (callback != NULL) {
+            callback(info, ctx);
+        } else {
+            xSemaphoreGive(signal);
+        }
+    }
+}
+
+/**
+ * @brief Hand an event to every waiter waiting for it
+ *
+ * All matching waiters are completed and moved to a private list in one
+ * pass before any of them is woken. A callback may register a new wait
+ * (a coroutine awaiting its next event); that waiter is not in the private
+ * list and cannot be completed with the event that resumed it.
+ */
+static void button_notify_waiters(const button_event_info_t *info)
+{
+    button_waiter_t *woken = NULL;
+    button_waiter_t **tail = &woken;
+    
+    portENTER_CRITICAL(&s_waiters_lock);
+    button_waiter_t **link = &s_waiters;
+    while (*link != NULL) {
+        button_waiter_t *waiter = *link;
+        if (button_waiter_matches(waiter, info)) {
+            if (waiter->out != NULL) {
+                *waiter->out = *info;
+            }
+            waiter->done = true;
+            *link = waiter->next;
+            waiter->next = NULL;
+            *tail = waiter;
+            tail = &waiter->next;
+        } else {
+            link = &waiter->next;
+        }
+    }
+    button_waiters_update();
+    portEXIT_CRITICAL(&s_waiters_lock);
+    
+    button_wake_list(woken, info);
+}
+
+/**
+ * @brief Arm the wait timer for the nearest asynchronous wait deadline
+ *
+ * Runs only in the timer service task, so concurrent re-arms cannot reorder.
+ * With no deadline pending the one-shot timer is left to expire harmlessly.
+ */
+static void button_wait_timer_arm(void *unused, uint32_t unused2)
+{
+    TickType_t now = xTaskGetTickCount();
+    TickType_t nearest = portMAX_DELAY;
+    bool pending = false;
+    
+    portENTER_CRITICAL(&s_waiters_lock);
+    for (button_waiter_t *waiter = s_waiters; waiter != NULL; waiter = waiter->next) {
+        if (waiter->timed) {
+            TickType_t remaining = (int32_t)(waiter->deadline - now) > 0 ? waiter->deadline - now : 0;
+            if (!pending || remaining < nearest) {
+                nearest = remaining;
+                pending = true;
+            }
+        }
+    }
+    portEXIT_CRITICAL(&s_waiters_lock);
+    
+    if (pending) {
+        xTimerChangePeriod(s_wait_timer, nearest > 0 ? nearest : 1, 0);
+    }
+}
+
+/**
+ * @brief Wait timer callback
+ *
+ * Completes every asynchronous wait whose deadline has passed with a NULL
+ * event, then re-arms for the next deadline.
+ */
+static void button_wait_timer_cb(TimerHandle_t timer)
+{
+    button_waiter_t *woken = NULL;
+    button_waiter_t **tail = &woken;
+    TickType_t now = xTaskGetTickCount();
+    
+    portENTER_CRITICAL(&s_waiters_lock);
+    button_waiter_t **link = &s_waiters;
+    while (*link != NULL) {
+        button_waiter_t *waiter = *link;
+        if (waiter->timed && (int32_t)(waiter->deadline - now) <= 0) {
+            waiter->done = true;
+            *link = waiter->next;
+            waiter->next = NULL;
+            *tail = waiter;
+            tail = &waiter->next;
+        } else {
+            link = &waiter->next;
+        }
+    }
+    button_waiters_update();
+    portEXIT_CRITICAL(&s_waiters_lock);
+    
+    button_wake_list(woken, NULL);
+    
+    button_wait_timer_arm(NULL, 0);
+}
+
+/**
+ * @brief Post an event record to the button's sink without blocking
+ */
+static void button_post_sink(button_dev_t *btn, const button_event_info_t *info)
+{
+    bool posted = true;
+    
+    switch (btn->sink.type) {
+        case BUTTON_SINK_QUEUE:
+            posted = (xQueueSend((QueueHandle_t)btn->sink.handle, info, 0) == pdTRUE);
+            break;
+        case BUTTON_SINK_STREAM_BUFFER:
+            /* Only ever write whole records so readers stay aligned */
+            posted = (xStreamBufferSpacesAvailable((StreamBufferHandle_t)btn->sink.handle) >= sizeof(*info) &&
+                      xStreamBufferSend((StreamBufferHandle_t)btn->sink.handle, info, sizeof(*info), 0) == sizeof(*info));
+            break;
+        case BUTTON_SINK_EVENT_LOOP:
+            posted = (esp_event_post_to((esp_event_loop_handle_t)btn->sink.handle, BUTTON_LONGPRESS_EVENT,
+                                        info->event, info, sizeof(*info), 0) == ESP_OK);
+            break;
+        default:
+            break;
+    }
+    
+#if CONFIG_BUTTON_LONGPRESS_STATS
+    if (!posted) {
+        btn->sink_drops = btn->sink_drops + 1;
+    }
+#else
+    (void)posted;
+#endif
+}
+
+/**
+ * @brief Register a button as a writer of its stream buffer sink
+ *
+ * @return false if the buffer is already written from another task or too
+ *         many stream buffers are in use
+ */
+static bool button_stream_sink_claim(button_dev_t *btn)
+{
+    StreamBufferHandle_t buffer = (StreamBufferHandle_t)btn->sink.handle;
+    int free_index = -1;
+    bool ok = false;
+    
+    portENTER_CRITICAL(&s_stream_sinks_lock);
+    for (int i = 0; i < BUTTON_MAX_STREAM_SINKS; i++) {
+        if (s_stream_sinks[i].users > 0 && s_stream_sinks[i].buffer == buffer) {
+            free_index = -1;
+            if (s_stream_sinks[i].engine == btn->engine) {
+                s_stream_sinks[i].users++;
+                ok = true;
+            }
+            break;
+        }
+        if (s_stream_sinks[i].users == 0 && free_index < 0) {
+            free_index = i;
+        }
+    }
+    if (free_index >= 0) {
+        s_stream_sinks[free_index].buffer = buffer;
+        s_stream_sinks[free_index].engine = btn->engine;
+        s_stream_sinks[free_index].users = 1;
+        ok = true;
+    }
+    portEXIT_CRITICAL(&s_stream_sinks_lock);
+    
+    return ok;
+}
+
+/**
+ * @brief Drop a button's registration as a writer of its stream buffer sink
+ */
+static void button_stream_sink_release(button_dev_t *btn)
+{
+    if (btn->sink.type != BUTTON_SINK_STREAM_BUFFER) {
+        return;
+    }
+    
+    portENTER_CRITICAL(&s_stream_sinks_lock);
+    for (int i = 0; i < BUTTON_MAX_STREAM_SINKS; i++) {
+        if (s_stream_sinks[i].users > 0 && s_stream_sinks[i].buffer == (StreamBufferHandle_t)btn->sink.handle) {
+            s_stream_sinks[i].users--;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&s_stream_sinks_lock);
+}
+
+/**
+ * @brief Evaluate the chords of a group after an edge
+ *
+ * Called with the group lock held and the pressed bitmap already updated.
+ *
+ * @return Bitmask of chords detected by this edge
+ */
+static uint32_t button_group_eval_chords(button_group_t *group, uint64_t bit, bool pressed, TickType_t now)
+{
+    uint64_t mask = atomic_load_explicit(&group->pressed_mask, memory_order_relaxed);
+    uint32_t detected = 0;
+    
+    for (uint8_t i = 0; i < group->chord_count; i++) {
+        const button_chord_t *chord = &group->chords[i];
+        button_chord_state_t *st = &group->chord_state[i];
+        TickType_t window = pdMS_TO_TICKS(chord->window_ms);
+        bool held = (mask & chord->hold_mask) == chord->hold_mask;
+        
+        if (!((chord->hold_mask | chord->click_mask) & bit)) {
+            continue;
+        }
+        
+        if (chord->click_mask == 0) {
+            /* Hold chord */
+            if (!pressed) {
+                st->reported = false;
+            } else if ((mask & chord->hold_mask) == bit) {
+                st->start_tick = now;
+            }
+            if (pressed && held && !st->reported &&
+                (chord->window_ms == 0 || now - st->start_tick <= window)) {
+                st->reported = true;
+                detected |= 1UL << i;
+            }
+        } else if (chord->hold_mask & bit) {
+            /* A modifier edge cancels a click in progress */
+            st->armed = false;
+        } else if (pressed) {
+            /* Click button pressed, arm once all of them are down with the modifiers held */
+            if ((mask & chord->click_mask) == bit) {
+                st->start_tick = now;
+            }
+            st->armed = held && (mask & chord->click_mask) == chord->click_mask;
+        } else if (st->armed) {
+            /* Click complete when the last click button is released */
+            if ((mask & chord->click_mask) == 0) {
+                st->armed = false;
+                if (held && (chord->window_ms == 0 || now - st->start_tick <= window)) {
+                    detected |= 1UL << i;
+                }
+            }
+        }
+        
+        if ((detected & (1UL << i)) && chord->suppress) {
+            atomic_fetch_or_explicit(&group->suppress_mask, chord->hold_mask | chord->click_mask,
+                                     memory_order_relaxed);
+        }
+    }
+    
+    return detected;
+}
+
+/**
+ * @brief Update the debounced pressed state and the group bitmap
+ *
+ * @return Bitmask of group chords detected by this edge
+ */
+static uint32_t button_set_pressed(button_dev_t *btn, bool pressed)
+{
+    btn->is_pressed = pressed;
+    
+    if (btn->group == NULL) {
+        return 0;
+    }
+    
+    uint64_t bit = 1ULL << btn->group_index;
+    uint32_t detected = 0;
+    
+    if (pressed) {
+        atomic_fetch_or_explicit(&btn->group->pressed_mask, bit, memory_order_release);
+    } else {
+        atomic_fetch_and_explicit(&btn->group->pressed_mask, ~bit, memory_order_release);
+    }
+    
+    if (btn->group->chord_count > 0) {
+        portENTER_CRITICAL(&btn->group->lock);
+        detected = button_group_eval_chords(btn->group, bit, pressed, xTaskGetTickCount());
+        portEXIT_CRITICAL(&btn->group->lock);
+    }
+    
+    return detected;
+}
+
+/**
+ * @brief Check whether a chord suppresses the button's own events
+ */
+static bool button_is_suppressed(const button_dev_t *btn)
+{
+    return btn->group != NULL &&
+           (atomic_load_explicit(&btn->group->suppress_mask, memory_order_relaxed) & (1ULL << btn->group_index));
+}
+
+/**
+ * @brief Take the lowest free bit of a group
+ *
+ * @return Bit index, or -1 if the group is full
+ */
+static int8_t button_group_join(button_group_t *group, struct button_dev *btn)
+{
+    int8_t index = -1;
+    
+    portENTER_CRITICAL(&group->lock);
+    for (int8_t i = 0; i < BUTTON_GROUP_MAX_BUTTONS; i++) {
+        if (!(group->member_mask & (1ULL << i))) {
+            group->member_mask |= 1ULL << i;
+            group->members[i] = btn;
+            index = i;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&group->lock);
+    
+    return index;
+}
+
+/**
+ * @brief Pick the shard running the fewest buttons for a new member
+ *
+ * Counts are read without the engines' mutexes, so the balance is only
+ * approximate when buttons are created concurrently.
+ *
+ * @return Engine, or NULL if the group is not sharded
+ */
+static button_engine_t *button_group_pick_shard(button_group_t *group)
+{
+    button_engine_t *shards[BUTTON_GROUP_MAX_SHARDS];
+    uint8_t count;
+    
+    portENTER_CRITICAL(&group->lock);
+    count = group->shard_count;
+    for (uint8_t i = 0; i < count; i++) {
+        shards[i] = group->shards[i];
+    }
+    portEXIT_CRITICAL(&group->lock);
+    
+    button_engine_t *best = NULL;
+    for (uint8_t i = 0; i < count; i++) {
+        if (best == NULL || shards[i]->button_count < best->button_count) {
+            best = shards[i];
+        }
+    }
+    
+    return best;
+}
+
+/**
+ * @brief Release a group bit and clear its pressed state
+ */
+static void button_group_leave(button_group_t *group, int8_t index)
+{
+    atomic_fetch_and_explicit(&group->pressed_mask, ~(1ULL << index), memory_order_release);
+    atomic_fetch_and_explicit(&group->suppress_mask, ~(1ULL << index), memory_order_relaxed);
+    
+    portENTER_CRITICAL(&group->lock);
+    group->member_mask &= ~(1ULL << index);
+    group->members[index] = NULL;
+    portEXIT_CRITICAL(&group->lock);
+}
+
+/**
+ * @brief Get time since the current press was confirmed
+ */
+static uint32_t button_hold_time_ms(const button_dev_t *btn)
+{
+    if (!btn->is_pressed) {
+        return 0;
+    }
+    return (xTaskGetTickCount() - btn->press_tick) * portTICK_PERIOD_MS;
+}
+
+/**
+ * @brief Deliver an event with details to the user callbacks, sink and waiters
+ *
+ * Must be called with the mutex held. The mutex is released while the
+ * callbacks run so that they may call back into the button API.
+ *
+ * @return true if the mutex is held again, false on mutex error
+ */
+static bool button_emit_info(button_dev_t *btn, const button_event_info_t *info)
+{
+    /* A chord owns this press, only keep press and release balanced */
+    if (info->event != BUTTON_EVENT_PRESSED && info->event != BUTTON_EVENT_RELEASED &&
+        button_is_suppressed(btn)) {
+        return true;
+    }
+    
+    /* Latch for low-rate pollers: count first so a consumer that sees the
+     * mask bit always finds the count */
+#if CONFIG_BUTTON_LONGPRESS_STATS
+    atomic_fetch_add_explicit(&btn->latched_counts[info->event], 1, memory_order_relaxed);
+#endif
+    atomic_fetch_or_explicit(&btn->latched_mask, BUTTON_EVENT_MASK(info->event), memory_order_release);
+    
+    /* Snapshot under the mutex, the callback setters may run meanwhile */
+    void (*callback)(button_event_t) = btn->callback;
+    button_event_cb_t event_callback = btn->event_callback;
+    void *user_ctx = btn->user_ctx;
+    
+    button_unlock(btn);
+    if (callback) {
+        callback(info->event);
+    }
+    if (event_callback) {
+        event_callback(info, user_ctx);
+    }
+    if (btn->sink.type != BUTTON_SINK_NONE) {
+        button_post_sink(btn, info);
+    }
+    if (button_waiters_pending()) {
+        button_notify_waiters(info);
+    }
+    if (!button_lock(btn)) {
+        ESP_LOGE(TAG, "Mutex error after event %d callback", info->event);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Deliver an event without extra details to the user callbacks
+ *
+ * @return true if the mutex is held again, false on mutex error
+ */
+static bool button_emit(button_dev_t *btn, button_event_t event)
+{
+    button_event_info_t info = {
+        .button = (button_handle_t)btn,
+        .event = event,
+        .hold_time_ms = button_hold_time_ms(btn),
+    };
+    return button_emit_info(btn, &info);
+}
+
+/**
+ * @brief Deliver the chords detected by an edge of this button
+ *
+ * Must be called with the button mutex held, which is released while the
+ * group callback runs.
+ *
+ * @return true if the mutex is held again, false on mutex error
+ */
+static bool button_emit_chords(button_dev_t *btn, uint32_t detected)
+{
+    if (detected == 0) {
+        return true;
+    }
+    
+    /* button_group_set_chords() may replace the callback meanwhile */
+    portENTER_CRITICAL(&btn->group->lock);
+    button_event_cb_t callback = btn->group->chord_callback;
+    void *ctx = btn->group->chord_ctx;
+    portEXIT_CRITICAL(&btn->group->lock);
+    
+    button_unlock(btn);
+    for (uint8_t i = 0; i < BUTTON_GROUP_MAX_CHORDS; i++) {
+        if (!(detected & (1UL << i))) {
+            continue;
+        }
+        
+        button_event_info_t info = {
+            .button = (button_handle_t)btn,
+            .event = BUTTON_EVENT_CHORD,
+            .hold_time_ms = button_hold_time_ms(btn),
+            .chord = i,
+        };
+        if (callback) {
+            callback(&info, ctx);
+        }
+        if (button_waiters_pending()) {
+            button_notify_waiters(&info);
+        }
+    }
+    if (!button_lock(btn)) {
+        ESP_LOGE(TAG, "Mutex error after chord callback");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Feed a token to the gesture recognizer and report completed gestures
+ *
+ * Must be called with the mutex held.
+ *
+ * @return true if the mutex is held again, false on mutex error
+ */
+static bool button_feed_gesture(button_dev_t *btn, button_gesture_token_t token)
+{
+    /* A chord owns this press, keep it out of gestures */
+    if (btn->gestures == NULL || button_is_suppressed(btn)) {
+        return true;
+    }
+    
+    uint32_t matched = button_gesture_feed(btn->gestures, token);
+    
+    for (uint8_t i = 0; matched != 0; i++, matched >>= 1) {
+        if (!(matched & 1)) {
+            continue;
+        }
+        
+        button_event_info_t info = {
+            .button = (button_handle_t)btn,
+            .event = BUTTON_EVENT_GESTURE,
+            .hold_time_ms = button_hold_time_ms(btn),
+            .gesture = i,
+        };
+        if (!button_emit_info(btn, &info)) {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+/**
+ * @brief Configured period of a button timer in ticks
+ */
+static TickType_t button_timer_period(const button_dev_t *btn, button_timer_id_t id)
+{
+    switch (id) {
+#if CONFIG_BUTTON_LONGPRESS_LONG_PRESS
+    case BUTTON_TIMER_HOLD:
+        return pdMS_TO_TICKS(btn->long_press_time_ms);
+#endif
+#if CONFIG_BUTTON_LONGPRESS_DOUBLE_CLICK
+    case BUTTON_TIMER_DOUBLE_CLICK:
+        return pdMS_TO_TICKS(btn->double_click_time_ms);
+#endif
+    default:
+        return pdMS_TO_TICKS(btn->debounce_time_ms);
+    }
+}
+
+#if CONFIG_BUTTON_LONGPRESS_PM
+/**
+ * @brief Create the shared no-light-sleep lock on first use
+ *
+ * Also enables GPIO as a light sleep wakeup source, without which the levels
+ * armed with gpio_wakeup_enable() would not end light sleep.
+ */
+static esp_err_t button_pm_init(void)
+{
+    if (s_pm_lock != NULL) {
+        return ESP_OK;
+    }
+    
+    esp_pm_lock_handle_t lock;
+    esp_err_t ret = esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "button", &lock);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    ret = esp_sleep_enable_gpio_wakeup();
+    if (ret != ESP_OK) {
+        esp_pm_lock_delete(lock);
+        return ret;
+    }
+    
+    portENTER_CRITICAL(&s_pm_init_lock);
+    bool installed = (s_pm_lock == NULL);
+    if (installed) {
+        s_pm_lock = lock;
+    }
+    portEXIT_CRITICAL(&s_pm_init_lock);
+    
+    if (!installed) {
+        esp_pm_lock_delete(lock);
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Record a pending deadline and keep the chip out of light sleep
+ *
+ * Safe from the GPIO interrupt: esp_pm_lock_acquire() is ISR-safe and each
+ * button takes at most one reference.
+ */
+static void IRAM_ATTR button_pm_arm(button_dev_t *btn, button_timer_id_t id)
+{
+    atomic_fetch_or_explicit(&btn->pm_armed, 1U << id, memory_order_release);
+    if (!atomic_exchange_explicit(&btn->pm_locked, true, memory_order_acq_rel)) {
+        esp_pm_lock_acquire(s_pm_lock);
+    }
+}
+
+/**
+ * @brief Drop the reference of a button with no pending deadline
+ *
+ * Called once the handlers have run, so a deadline expiring and re-armed by
+ * its own handler keeps the lock. The pin is then set to wake the chip on
+ * the level it would change to, since edge interrupts cannot end light sleep.
+ */
+static void button_pm_settle(button_dev_t *btn)
+{
+    if (atomic_load_explicit(&btn->pm_armed, memory_order_acquire) != 0 ||
+        !atomic_exchange_explicit(&btn->pm_locked, false, memory_order_acq_rel)) {
+        return;
+    }
+    
+    if (!btn->suspended) {
+        /* High wakes a released active-high button or a pressed active-low one */
+        gpio_wakeup_enable(btn->gpio_num, btn->active_level != btn->is_pressed ?
+                           GPIO_INTR_HIGH_LEVEL : GPIO_INTR_LOW_LEVEL);
+    }
+    esp_pm_lock_release(s_pm_lock);
+    
+    /* An edge may have armed a deadline meanwhile */
+    if (atomic_load_explicit(&btn->pm_armed, memory_order_acquire) != 0 &&
+        !atomic_exchange_explicit(&btn->pm_locked, true, memory_order_acq_rel)) {
+        esp_pm_lock_acquire(s_pm_lock);
+    }
+}
+
+/**
+ * @brief Release the wakeup pin and lock reference of a deleted button
+ */
+static void button_pm_detach(button_dev_t *btn)
+{
+    gpio_wakeup_disable(btn->gpio_num);
+    if (atomic_exchange_explicit(&btn->pm_locked, false, memory_order_acq_rel)) {
+        esp_pm_lock_release(s_pm_lock);
+    }
+}
+#else
+static inline void button_pm_arm(button_dev_t *btn, button_timer_id_t id) { (void)btn; (void)id; }
+static inline void button_pm_settle(button_dev_t *btn) { (void)btn; }
+#endif /* CONFIG_BUTTON_LONGPRESS_PM */
+
+/**
+ * @brief (Re)start a button timer
+ *
+ * On the timer service task this is a software timer command, on an engine
+ * it only records the deadline, since it is called from the engine task or
+ * with the engine lock held. Must be called with the lock held.
+ *
+ * The period is always passed explicitly, so timings changed at runtime
+ * apply from the next start without touching idle timers.
+ *
+ * @param ticks Period, BUTTON_TIMER_DEFAULT_PERIOD for the configured one
+ */
+static void button_timer_start(button_dev_t *btn, button_timer_id_t id, TickType_t ticks)
+{
+    /* A suspended button arms nothing, even from a handler that was running */
+    if (btn->suspended) {
+        return;
+    }
+    
+    if (ticks == BUTTON_TIMER_DEFAULT_PERIOD) {
+        ticks = button_timer_period(btn, id);
+    }
+    button_pm_arm(btn, id);
+    
+    if (btn->engine != NULL) {
+        btn->engine->deadlines[id][btn->engine_slot] = xTaskGetTickCount() + ticks;
+        btn->engine->armed[id] |= 1ULL << btn->engine_slot;
+    } else {
+#if CONFIG_BUTTON_LONGPRESS_SPINLOCK
+        btn->timer_periods[id] = ticks;
+        btn->timers_to_start |= 1U << id;
+        btn->timers_to_stop &= ~(1U << id);
+#else
+        xTimerChangePeriod(btn->timers[id], ticks, 0);
+#endif
+    }
+}
+
+/**
+ * @brief Stop a button timer
+ */
+static void button_timer_stop(button_dev_t *btn, button_timer_id_t id)
+{
+#if CONFIG_BUTTON_LONGPRESS_PM
+    atomic_fetch_and_explicit(&btn->pm_armed, ~(1U << id), memory_order_release);
+#endif
+    
+    if (btn->engine != NULL) {
+        btn->engine->armed[id] &= ~(1ULL << btn->engine_slot);
+    } else {
+#if CONFIG_BUTTON_LONGPRESS_SPINLOCK
+        btn->timers_to_stop |= 1U << id;
+        btn->timers_to_start &= ~(1U << id);
+#else
+        xTimerStop(btn->timers[id], 0);
+#endif
+    }
+}
+
+/**
+ * @brief Arm the hold timer for the nearest pending hold deadline
+ *
+ * Long press, hold stages, auto-repeat and hold progress share one one-shot
+ * timer which is re-armed for the next threshold each time it fires.
+ */
+static void button_hold_schedule(button_dev_t *btn, uint32_t elapsed_ms)
+{
+#if CONFIG_BUTTON_LONGPRESS_LONG_PRESS
+    uint32_t deadline_ms = UINT32_MAX;
+    
+    if (!btn->long_press_reported) {
+        deadline_ms = btn->long_press_time_ms;
+    }
+    if (btn->next_hold_stage < btn->hold_stage_count &&
+        btn->hold_stages_ms[btn->next_hold_stage] < deadline_ms) {
+        deadline_ms = btn->hold_stages_ms[btn->next_hold_stage];
+    }
+    if (btn->repeat_interval_ms > 0 && btn->repeat_next_ms < deadline_ms) {
+        deadline_ms = btn->repeat_next_ms;
+    }
+    if (btn->hold_progress_interval_ms > 0 && !btn->long_press_reported &&
+        btn->progress_next_ms < deadline_ms) {
+        deadline_ms = btn->progress_next_ms;
+    }
+    
+    if (deadline_ms == UINT32_MAX) {
+        button_timer_stop(btn, BUTTON_TIMER_HOLD);
+        return;
+    }
+    
+    TickType_t ticks = pdMS_TO_TICKS(deadline_ms > elapsed_ms ? deadline_ms - elapsed_ms : 0);
+    button_timer_start(btn, BUTTON_TIMER_HOLD, ticks > 0 ? ticks : 1);
+#endif
+}
+
+/**
+ * @brief Run one click state machine transition
+ *
+ * Looks up the transition for the current state and input, switches state
+ * and executes its actions in a fixed order. Must be called with the mutex
+ * held.
+ *
+ * @return true if the mutex is held again, false on mutex error
+ */
+static bool button_fsm_step(button_dev_t *btn, button_fsm_input_t input)
+{
+    const button_fsm_transition_t *t = &s_fsm_table[btn->fsm_state][input];
+    uint16_t actions = t->actions;
+    
+    btn->fsm_state = t->next;
+    
+#if CONFIG_BUTTON_LONGPRESS_DOUBLE_CLICK
+    /* The double click timer doubles as the gesture gap timer */
+    if (actions & BUTTON_ACT_WINDOW_START) {
+        button_timer_start(btn, BUTTON_TIMER_DOUBLE_CLICK, BUTTON_TIMER_DEFAULT_PERIOD);
+    }
+    if (actions & BUTTON_ACT_WINDOW_STOP) {
+        button_timer_stop(btn, BUTTON_TIMER_DOUBLE_CLICK);
+    }
+    if ((actions & BUTTON_ACT_GAP_ARM) && btn->gestures != NULL) {
+        button_timer_start(btn, BUTTON_TIMER_DOUBLE_CLICK, BUTTON_TIMER_DEFAULT_PERIOD);
+    }
+    if ((actions & BUTTON_ACT_GAP_STOP) && btn->gestures != NULL) {
+        button_timer_stop(btn, BUTTON_TIMER_DOUBLE_CLICK);
+    }
+#endif
+    if (actions & BUTTON_ACT_UNSUPPRESS) {
+        atomic_fetch_and_explicit(&btn->group->suppress_mask, ~(1ULL << btn->group_index),
+                                  memory_order_relaxed);
+    }
+    
+    if ((actions & BUTTON_ACT_FEED_SHORT) && !button_feed_gesture(btn, BUTTON_GESTURE_SHORT)) {
+        return false;
+    }
+    if ((actions & BUTTON_ACT_EMIT_CLICK) && !button_emit(btn, BUTTON_EVENT_CLICK)) {
+        return false;
+    }
+    if ((actions & BUTTON_ACT_EMIT_DOUBLE) && !button_emit(btn, BUTTON_EVENT_DOUBLE_CLICK)) {
+        return false;
+    }
+    if ((actions & BUTTON_ACT_EMIT_LONG) && !button_emit(btn, BUTTON_EVENT_LONG_PRESS)) {
+        return false;
+    }
+    if ((actions & BUTTON_ACT_FEED_LONG) && !button_feed_gesture(btn, BUTTON_GESTURE_LONG)) {
+        return false;
+    }
+    if ((actions & BUTTON_ACT_FEED_GAP) && !button_feed_gesture(btn, BUTTON_GESTURE_GAP)) {
+        return false;
+    }
+    
+    return true;
+}
+
+/**
+ * @brief Debounce deadline handler
+ * 
+ * This function is called when the debounce timer expires.
+ * It turns a settled level change into a press or release input.
+ */
+static void button_debounce_expired(button_dev_t *btn)
+{
+    if (!button_lock(btn)) {
+        ESP_LOGE(TAG, "Mutex error in debounce callback");
+        return;
+    }
+    
+    if (btn->suspended) {
+        button_unlock(btn);
+        return;
+    }
+    
+    /* Get current GPIO level and determine if button is active */
+    int level = gpio_get_level(btn->gpio_num);
+    bool is_active = (btn->active_level) ? (level == 1) : (level == 0);
+    
+    /* Only level changes are inputs */
+    if (is_active == btn->is_pressed) {
+        button_unlock(btn);
+        return;
+    }
+    
+#if CONFIG_BUTTON_LONGPRESS_ANTI_NOISE
+    /* Anti-noise protection: re-check a change that comes too soon, never drop it */
+    uint32_t current_time = xTaskGetTickCount() * portTICK_PERIOD_MS;
+    uint32_t min_event_interval = btn->debounce_time_ms / 2;
+    uint32_t since_last = current_time - btn->last_event_ms;
+    
+    if (since_last < min_event_interval) {
+        TickType_t retry = pdMS_TO_TICKS(min_event_interval - since_last);
+        button_timer_start(btn, BUTTON_TIMER_DEBOUNCE, retry > 0 ? retry : 1);
+        button_unlock(btn);
+        return;
+    }
+    btn->last_event_ms = current_time;
+#endif
+    
+    uint32_t chords = button_set_pressed(btn, is_active);
+    button_fsm_input_t input;
+    
+    if (is_active) {
+        /* Start long press and hold stage deadline */
+        btn->press_tick = xTaskGetTickCount();
+        btn->long_press_reported = false;
+        btn->next_hold_stage = 0;
+        btn->repeat_next_ms = btn->repeat_delay_ms > 0 ? btn->repeat_delay_ms : btn->long_press_time_ms;
+        btn->repeat_cur_interval_ms = btn->repeat_interval_ms;
+        btn->repeat_count = 0;
+        btn->progress_next_ms = btn->hold_progress_interval_ms;
+        button_hold_schedule(btn, 0);
+        
+        input = btn->double_click_on_press ? BUTTON_INPUT_PRESS_DC : BUTTON_INPUT_PRESS;
+    } else {
+#if CONFIG_BUTTON_LONGPRESS_LONG_PRESS
+        button_timer_stop(btn, BUTTON_TIMER_HOLD);
+#endif
+        
+        /* A press that was part of a suppressing chord is neither a click nor a gesture token */
+        input = button_is_suppressed(btn) ? BUTTON_INPUT_CANCEL : BUTTON_INPUT_RELEASE;
+    }
+    
+    if (!button_emit(btn, is_active ? BUTTON_EVENT_PRESSED : BUTTON_EVENT_RELEASED)) {
+        return;
+    }
+    
+    if (!button_fsm_step(btn, input)) {
+        return;
+    }
+    
+    if (!button_emit_chords(btn, chords)) {
+        return;
+    }
+    
+    button_unlock(btn);
+}
+
+#if CONFIG_BUTTON_LONGPRESS_LONG_PRESS
+/**
+ * @brief Hold deadline handler
+ * 
+ * This function is called when the hold deadline expires.
+ * It reports the long press and every hold stage that has been reached,
+ * then re-arms the same timer for the next pending threshold.
+ */
+static void button_hold_expired(button_dev_t *btn)
+{
+    if (!button_lock(btn)) {
+        ESP_LOGE(TAG, "Mutex error in hold callback");
+        return;
+    }
+    
+    if (btn->suspended || !btn->is_pressed) {
+        button_unlock(btn);
+        return;
+    }
+    
+    /*
+     * A release is confirmed by the debounce timer, which then stops this one.
+     * A glitch shorter than the debounce time changes nothing there, so retry
+     * once it has settled rather than losing the rest of the hold.
+     */
+    int level = gpio_get_level(btn->gpio_num);
+    bool is_active = (btn->active_level) ? (level == 1) : (level == 0);
+    
+    if (!is_active) {
+        button_timer_start(btn, BUTTON_TIMER_HOLD, pdMS_TO_TICKS(btn->debounce_time_ms) + 1);
+        button_unlock(btn);
+        return;
+    }
+    
+    uint32_t elapsed_ms = button_hold_time_ms(btn);
+    
+    /* Report progress only on the way to the long press, which completes it */
+    if (btn->hold_progress_interval_ms > 0 && !btn->long_press_reported &&
+        elapsed_ms >= btn->progress_next_ms && elapsed_ms < btn->long_press_time_ms) {
+        button_event_info_t info = {
+            .button = (button_handle_t)btn,
+            .event = BUTTON_EVENT_HOLD_PROGRESS,
+            .hold_time_ms = elapsed_ms,
+            .target_ms = btn->long_press_time_ms,
+        };
+        
+        /* Skip missed intervals rather than bursting */
+        while (btn->progress_next_ms <= elapsed_ms) {
+            btn->progress_next_ms += btn->hold_progress_interval_ms;
+        }
+        
+        if (!button_emit_info(btn, &info)) {
+            return;
+        }
+    }
+    
+    if (btn->is_pressed && !btn->long_press_reported && elapsed_ms >= btn->long_press_time_ms) {
+        btn->long_press_reported = true;
+        
+        if (!button_fsm_step(btn, BUTTON_INPUT_LONG)) {
+            return;
+        }
+    }
+    
+    /* Report every hold stage reached so far, in order */
+    while (btn->is_pressed && btn->next_hold_stage < btn->hold_stage_count &&
+           elapsed_ms >= btn->hold_stages_ms[btn->next_hold_stage]) {
+        button_event_info_t info = {
+            .button = (button_handle_t)btn,
+            .event = BUTTON_EVENT_HOLD_STAGE,
+            .stage = btn->next_hold_stage,
+            .hold_time_ms = elapsed_ms,
+        };
+        btn->next_hold_stage++;
+        
+        if (!button_emit_info(btn, &info)) {
+            return;
+        }
+    }
+    
+    /* Report at most one repeat per expiry, skipping missed ones */
+    if (btn->is_pressed && btn->repeat_interval_ms > 0 && elapsed_ms >= btn->repeat_next_ms) {
+        btn->repeat_count++;
+        button_event_info_t info = {
+            .button = (button_handle_t)btn,
+            .event = BUTTON_EVENT_REPEAT,
+            .hold_time_ms = elapsed_ms,
+            .repeat_count = btn->repeat_count,
+        };
+        
+        btn->repeat_next_ms += btn->repeat_cur_interval_ms;
+        if (btn->repeat_next_ms <= elapsed_ms) {
+            btn->repeat_next_ms = elapsed_ms + btn->repeat_cur_interval_ms;
+        }
+        
+        /* Accelerate towards the minimum interval */
+        if (btn->repeat_accel_percent > 0) {
+            uint32_t next = btn->repeat_cur_interval_ms * (100 - btn->repeat_accel_percent) / 100;
+            btn->repeat_cur_interval_ms = next > btn->repeat_min_interval_ms ? next : btn->repeat_min_interval_ms;
+        }
+        
+        /* Once repeating, the press no longer counts as a click */
+        if (!button_fsm_step(btn, BUTTON_INPUT_REPEAT)) {
+            return;
+        }
+        
+        if (!button_emit_info(btn, &info)) {
+            return;
+        }
+    }
+    
+    /* A release may have been processed while callbacks ran */
+    if (btn->is_pressed) {
+        button_hold_schedule(btn, button_hold_time_ms(btn));
+    }
+    
+    button_unlock(btn);
+}
+
+#endif /* CONFIG_BUTTON_LONGPRESS_LONG_PRESS */
+
+#if CONFIG_BUTTON_LONGPRESS_DOUBLE_CLICK
+/**
+ * @brief Double click deadline handler
+ * 
+ * This function is called when the double click timer expires.
+ * It confirms a single click when no second press arrived in time
+ * and marks the gap between gestures.
+ */
+static void button_double_click_expired(button_dev_t *btn)
+{
+    if (!button_lock(btn)) {
+        ESP_LOGE(TAG, "Mutex error in double click callback");
+        return;
+    }
+    
+    if (btn->suspended) {
+        button_unlock(btn);
+        return;
+    }
+    
+    if (!button_fsm_step(btn, BUTTON_INPUT_TIMEOUT)) {
+        return;
+    }
+    
+    button_unlock(btn);
+}
+
+#endif /* CONFIG_BUTTON_LONGPRESS_DOUBLE_CLICK */
+
+/* Deadline handlers and software timer names, indexed by button_timer_id_t */
+static void (*const s_timer_expired[BUTTON_TIMER_MAX])(button_dev_t *btn) = {
+    [BUTTON_TIMER_DEBOUNCE] = button_debounce_expired,
+#if CONFIG_BUTTON_LONGPRESS_LONG_PRESS
+    [BUTTON_TIMER_HOLD] = button_hold_expired,
+#endif
+#if CONFIG_BUTTON_LONGPRESS_DOUBLE_CLICK
+    [BUTTON_TIMER_DOUBLE_CLICK] = button_double_click_expired,
+#endif
+};
+
+static const char *const s_timer_names[BUTTON_TIMER_MAX] = {
+    [BUTTON_TIMER_DEBOUNCE] = "btn_dbnc",
+#if CONFIG_BUTTON_LONGPRESS_LONG_PRESS
+    [BUTTON_TIMER_HOLD] = "btn_hold",
+#endif
+#if CONFIG_BUTTON_LONGPRESS_DOUBLE_CLICK
+    [BUTTON_TIMER_DOUBLE_CLICK] = "btn_dblc",
+#endif
+};
+
+/**
+ * @brief Run the handler of an expired deadline
+ */
+static void button_timer_expired(button_dev_t *btn, button_timer_id_t id)
+{
+#if CONFIG_BUTTON_LONGPRESS_PM
+    atomic_fetch_and_explicit(&btn->pm_armed, ~(1U << id), memory_order_release);
+#endif
+    s_timer_expired[id](btn);
+    button_pm_settle(btn);
+}
+
+/**
+ * @brief Software timer callback, runs the handler of the expired timer
+ */
+static void button_timer_cb(TimerHandle_t timer)
+{
+    button_dev_t *btn = (button_dev_t *)pvTimerGetTimerID(timer);
+    
+    for (int id = 0; id < BUTTON_TIMER_MAX; id++) {
+        if (btn->timers[id] == timer) {
+            button_timer_expired(btn, (button_timer_id_t)id);
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Delete the timers of a button, any of which may be missing
+ */
+static void button_delete_timers(button_dev_t *btn)
+{
+    for (int id = 0; id < BUTTON_TIMER_MAX; id++) {
+        if (btn->timers[id]) {
+            xTimerStop(btn->timers[id], 0);
+            xTimerDelete(btn->timers[id], 0);
+        }
+    }
+}
+
+/**
+ * @brief Capture a GPIO edge from interrupt context
+ * 
+ * Resets the debounce timer to start debouncing, or hands the edge to the
+ * button's engine task.
+ */
+static void IRAM_ATTR button_edge_from_isr(button_dev_t *btn, BaseType_t *woken)
+{
+#if CONFIG_BUTTON_LONGPRESS_PM
+    /* Back from level wakeup to edge interrupts until the button is idle again */
+    gpio_ll_wakeup_disable(&GPIO, btn->gpio_num);
+    gpio_ll_set_intr_type(&GPIO, btn->gpio_num, GPIO_INTR_ANYEDGE);
+#endif
+    button_pm_arm(btn, BUTTON_TIMER_DEBOUNCE);
+    
+    if (btn->engine != NULL) {
+        atomic_fetch_or_explicit(&btn->engine->edge_pending, 1ULL << btn->engine_slot, memory_order_release);
+        vTaskNotifyGiveFromISR(btn->engine->task, woken);
+    } else {
+        xTimerResetFromISR(btn->timers[BUTTON_TIMER_DEBOUNCE], woken);
+    }
+}
+
+#if CONFIG_BUTTON_LONGPRESS_SHARED_ISR
+/**
+ * @brief Capture the edges of every pending pin in one status word
+ */
+static void IRAM_ATTR button_edges_from_isr(uint32_t status, int first_pin, BaseType_t *woken)
+{
+    while (status != 0) {
+        int pin = first_pin + __builtin_ctz(status);
+        status &= status - 1;
+        
+        if (pin < GPIO_NUM_MAX && s_pin_buttons[pin] != NULL) {
+            button_edge_from_isr(s_pin_buttons[pin], woken);
+        }
+    }
+}
+
+/**
+ * @brief Shared GPIO interrupt handler
+ * 
+ * Registered once with gpio_isr_register() for all button pins. Each status
+ * word is read once, cleared with a single write before its pins are handled
+ * (so edges arriving meanwhile raise the interrupt again), then scanned bit
+ * by bit.
+ */
+static void IRAM_ATTR button_shared_isr(void *arg)
+{
+    uint32_t core_id = xPortGetCoreID();
+    uint32_t status;
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    
+    portENTER_CRITICAL_ISR(&s_isr_lock);
+    
+    gpio_ll_get_intr_status(&GPIO, core_id, &status);
+    gpio_ll_clear_intr_status(&GPIO, status);
+    button_edges_from_isr(status, 0, &xHigherPriorityTaskWoken);
+    
+#if SOC_GPIO_PIN_COUNT > 32
+    gpio_ll_get_intr_status_high(&GPIO, core_id, &status);
+    gpio_ll_clear_intr_status_high(&GPIO, status);
+    button_edges_from_isr(status, 32, &xHigherPriorityTaskWoken);
+#endif
+    
+    portEXIT_CRITICAL_ISR(&s_isr_lock);
+    
+    if (xHigherPriorityTaskWoken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+#else
+/**
+ * @brief GPIO interrupt handler
+ * 
+ * This function is called by the GPIO ISR service when an edge occurs
+ * on the button's pin.
+ */
+static void IRAM_ATTR button_isr_handler(void *arg)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    
+    button_edge_from_isr((button_dev_t *)arg, &xHigherPriorityTaskWoken);
+    
+    if (xHigherPriorityTaskWoken) {
+        portYIELD_FROM_ISR();
+    }
+}
+#endif /* CONFIG_BUTTON_LONGPRESS_SHARED_ISR */
+
+#if CONFIG_BUTTON_LONGPRESS_ISR_IRAM
+/* Global names of the ISR path for the link-time check in button_longpress_iram.ld */
+#if CONFIG_BUTTON_LONGPRESS_SHARED_ISR
+extern void button_longpress_iram_isr(void *arg) __attribute__((alias("button_shared_isr")));
+extern void button_longpress_iram_scan(uint32_t status, int first_pin, BaseType_t *woken)
+    __attribute__((alias("button_edges_from_isr")));
+#else
+extern void button_longpress_iram_isr(void *arg) __attribute__((alias("button_isr_handler")));
+#endif
+extern void button_longpress_iram_edge(button_dev_t *btn, BaseType_t *woken)
+    __attribute__((alias("button_edge_from_isr")));
+#if CONFIG_BUTTON_LONGPRESS_PM
+extern void button_longpress_iram_pm_arm(button_dev_t *btn, button_timer_id_t id)
+    __attribute__((alias("button_pm_arm")));
+#endif
+#endif
+
+/**
+ * @brief Install the GPIO interrupt with the given allocation flags
+ */
+static esp_err_t button_isr_setup(int intr_alloc_flags)
+{
+    esp_err_t ret;
+    
+#if CONFIG_BUTTON_LONGPRESS_SHARED_ISR
+    ret = gpio_isr_register(button_shared_isr, NULL, intr_alloc_flags, &s_isr_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Shared ISR registration failed: %d", ret);
+        return ret;
+    }
+#else
+    ret = gpio_install_isr_service(intr_alloc_flags);
+    if (ret != ESP_OK) {
+        if (ret != ESP_ERR_INVALID_STATE) {
+            ESP_LOGE(TAG, "ISR service installation failed: %d", ret);
+        }
+        return ret;
+    }
+#endif
+    
+    s_isr_installed = true;
+    return ESP_OK;
+}
+
+/**
+ * @brief Route the interrupt of the button's pin to the component
+ * 
+ * Installs the GPIO ISR service, or registers the shared handler, on first
+ * use with the default allocation flags.
+ */
+static esp_err_t button_isr_attach(button_dev_t *btn)
+{
+    esp_err_t ret;
+    
+#if CONFIG_BUTTON_LONGPRESS_SHARED_ISR
+    portENTER_CRITICAL(&s_isr_lock);
+    bool busy = (s_pin_buttons[btn->gpio_num] != NULL);
+    if (!busy) {
+        s_pin_buttons[btn->gpio_num] = btn;
+    }
+    portEXIT_CRITICAL(&s_isr_lock);
+    
+    if (busy) {
+        ESP_LOGE(TAG, "GPIO %d already has a button", btn->gpio_num);
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    ret = s_isr_installed ? ESP_OK : button_isr_setup(BUTTON_ISR_DEFAULT_FLAGS);
+    if (ret == ESP_OK) {
+        ret = gpio_intr_enable(btn->gpio_num);
+    }
+    if (ret != ESP_OK) {
+        portENTER_CRITICAL(&s_isr_lock);
+        s_pin_buttons[btn->gpio_num] = NULL;
+        portEXIT_CRITICAL(&s_isr_lock);
+    }
+#else
+    /* Install ISR service if needed, it may already be installed by the application */
+    if (!s_isr_installed) {
+        ret = button_isr_setup(BUTTON_ISR_DEFAULT_FLAGS);
+        if (ret == ESP_ERR_INVALID_STATE) {
+            s_isr_installed = true;
+        } else if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+    
+    ret = gpio_isr_handler_add(btn->gpio_num, button_isr_handler, btn);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "ISR handler addition failed");
+    }
+#endif
+    
+    return ret;
+}
+
+/**
+ * @brief Stop routing the interrupt of the button's pin
+ * 
+ * Once this returns no ISR touches the button.
+ */
+static void button_isr_detach(button_dev_t *btn)
+{
+#if CONFIG_BUTTON_LONGPRESS_SHARED_ISR
+    gpio_intr_disable(btn->gpio_num);
+    
+    portENTER_CRITICAL(&s_isr_lock);
+    s_pin_buttons[btn->gpio_num] = NULL;
+    portEXIT_CRITICAL(&s_isr_lock);
+#else
+    esp_err_t ret = gpio_isr_handler_remove(btn->gpio_num);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "ISR handler removal failed: %d", ret);
+        /* Continue with cleanup anyway */
+    }
+#endif
+}
+
+/**
+ * @brief Engine task
+ *
+ * Sleeps until a GPIO edge or the nearest deadline of its buttons, then runs
+ * every expired deadline handler, exactly like the timer service task would.
+ */
+static void button_engine_task(void *arg)
+{
+    button_engine_t *engine = (button_engine_t *)arg;
+    TickType_t wait = portMAX_DELAY;
+    
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, wait);
+        if (engine->stopping) {
+            break;
+        }
+        
+        xSemaphoreTakeRecursive(engine->mutex, portMAX_DELAY);
+        
+        /* An edge restarts the debounce deadline, like xTimerResetFromISR() */
+        uint64_t edges = atomic_exchange_explicit(&engine->edge_pending, 0, memory_order_acquire) & engine->used;
+        while (edges != 0) {
+            int slot = __builtin_ctzll(edges);
+            edges &= edges - 1;
+            button_timer_start(engine->slots[slot], BUTTON_TIMER_DEBOUNCE, BUTTON_TIMER_DEFAULT_PERIOD);
+        }
+        
+        TickType_t now = xTaskGetTickCount();
+        for (int id = 0; id < BUTTON_TIMER_MAX; id++) {
+            uint64_t due = 0;
+            for (uint64_t armed = engine->armed[id]; armed != 0; armed &= armed - 1) {
+                int slot = __builtin_ctzll(armed);
+                if ((int32_t)(engine->deadlines[id][slot] - now) <= 0) {
+                    due |= 1ULL << slot;
+                }
+            }
+            
+            while (due != 0) {
+                int slot = __builtin_ctzll(due);
+                due &= due - 1;
+                engine->armed[id] &= ~(1ULL << slot);
+                button_timer_expired(engine->slots[slot], (button_timer_id_t)id);
+            }
+        }
+        
+        /* Handlers may have re-armed deadlines, sleep until the nearest one */
+        now = xTaskGetTickCount();
+        wait = portMAX_DELAY;
+        for (int id = 0; id < BUTTON_TIMER_MAX; id++) {
+            for (uint64_t armed = engine->armed[id]; armed != 0; armed &= armed - 1) {
+                TickType_t deadline = engine->deadlines[id][__builtin_ctzll(armed)];
+                TickType_t remaining = (int32_t)(deadline - now) > 0 ? deadline - now : 0;
+                if (remaining < wait) {
+                    wait = remaining;
+                }
+            }
+        }
+        
+        xSemaphoreGiveRecursive(engine->mutex);
+    }
+    
+    xSemaphoreGive(engine->stopped);
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief Give a button the lowest free slot of its engine
+ *
+ * @return true on success, false if the engine is full
+ */
+static bool button_engine_link(button_dev_t *btn)
+{
+    button_engine_t *engine = btn->engine;
+    
+    xSemaphoreTakeRecursive(engine->mutex, portMAX_DELAY);
+    btn->engine_slot = -1;
+    if (~engine->used != 0) {
+        btn->engine_slot = __builtin_ctzll(~engine->used);
+        engine->used |= 1ULL << btn->engine_slot;
+        engine->slots[btn->engine_slot] = btn;
+        engine->button_count++;
+    }
+    xSemaphoreGiveRecursive(engine->mutex);
+    
+    return btn->engine_slot >= 0;
+}
+
+/**
+ * @brief Release a button's engine slot
+ *
+ * Once this returns the engine task no longer touches the button.
+ */
+static void button_engine_unlink(button_dev_t *btn)
+{
+    button_engine_t *engine = btn->engine;
+    uint64_t bit = 1ULL << btn->engine_slot;
+    
+    xSemaphoreTakeRecursive(engine->mutex, portMAX_DELAY);
+    engine->used &= ~bit;
+    engine->slots[btn->engine_slot] = NULL;
+    for (int id = 0; id < BUTTON_TIMER_MAX; id++) {
+        engine->armed[id] &= ~bit;
+    }
+    atomic_fetch_and_explicit(&engine->edge_pending, ~bit, memory_order_relaxed);
+    engine->button_count--;
+    xSemaphoreGiveRecursive(engine->mutex);
+}
+
+/**
+ * @brief Create a dedicated engine task
+ * 
+ * @param config Engine configuration
+ * @return button_engine_handle_t Handle to the engine, or NULL if failed
+ */
+button_engine_handle_t button_engine_create(const button_engine_config_t *config)
+{
+    if (config == NULL || config->stack_size == 0) {
+        ESP_LOGE(TAG, "Invalid engine configuration");
+        return NULL;
+    }
+    
+    button_engine_t *engine = heap_caps_calloc(1, sizeof(button_engine_t), BUTTON_ISR_MEM_CAPS);
+    if (engine == NULL) {
+        ESP_LOGE(TAG, "Memory allocation failed");
+        return NULL;
+    }
+    
+    engine->mutex = xSemaphoreCreateRecursiveMutex();
+    if (engine->mutex == NULL) {
+        ESP_LOGE(TAG, "Mutex creation failed");
+        free(engine);
+        return NULL;
+    }
+    
+    if (xTaskCreatePinnedToCore(button_engine_task, "btn_engine", config->stack_size, engine,
+                                config->priority, &engine->task, config->core_id) != pdPASS) {
+        ESP_LOGE(TAG, "Engine task creation failed");
+        vSemaphoreDelete(engine->mutex);
+        free(engine);
+        return NULL;
+    }
+    
+    return (button_engine_handle_t)engine;
+}
+
+/**
+ * @brief Stop and delete an engine task
+ * 
+ * @param engine_handle Handle to the engine
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG or ESP_ERR_INVALID_STATE otherwise
+ */
+esp_err_t button_engine_delete(button_engine_handle_t engine_handle)
+{
+    CHECK_ARG(engine_handle);
+    
+    button_engine_t *engine = (button_engine_t *)engine_handle;
+    
+    xSemaphoreTakeRecursive(engine->mutex, portMAX_DELAY);
+    bool busy = (engine->used != 0);
+    xSemaphoreGiveRecursive(engine->mutex);
+    
+    if (busy) {
+        ESP_LOGE(TAG, "Engine still runs buttons");
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    /*
+     * The task acknowledges and deletes itself. A semaphore on our stack
+     * rather than a notification leaves the caller's notifications alone.
+     */
+    StaticSemaphore_t stopped_buffer;
+    engine->stopped = xSemaphoreCreateBinaryStatic(&stopped_buffer);
+    engine->stopping = true;
+    xTaskNotifyGive(engine->task);
+    xSemaphoreTake(engine->stopped, portMAX_DELAY);
+    vSemaphoreDelete(engine->stopped);
+    
+    vSemaphoreDelete(engine->mutex);
+    free(engine);
+    
+    return ESP_OK;
+}
+
+/**
+ * @brief Install the GPIO interrupt used by all buttons
+ * 
+ * @param intr_alloc_flags ESP_INTR_FLAG_* allocation flags
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG or ESP_ERR_INVALID_STATE otherwise
+ */
+esp_err_t button_isr_install(int intr_alloc_flags)
+{
+#if !CONFIG_BUTTON_LONGPRESS_ISR_IRAM
+    if (intr_alloc_flags & ESP_INTR_FLAG_IRAM) {
+        ESP_LOGE(TAG, "ESP_INTR_FLAG_IRAM needs CONFIG_BUTTON_LONGPRESS_ISR_IRAM");
+        return ESP_ERR_INVALID_ARG;
+    }
+#endif
+    
+    if (s_isr_installed) {
+        ESP_LOGE(TAG, "Button interrupt already installed");
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    esp_err_t ret = button_isr_setup(intr_alloc_flags);
+    if (ret == ESP_ERR_INVALID_STATE) {
+        ESP_LOGE(TAG, "GPIO ISR service already installed by the application");
+    }
+    
+    return ret;
+}
+
+/**
+ * @brief Create and initialize a button
+ * 
+ * @param config Pointer to button configuration
+ * @return button_handle_t Handle to the button instance, or NULL if failed
+ */
+button_handle_t button_create(const button_config_t *config)
+{
+    /* Validate parameters */
+    if (config == NULL || config->gpio_num >= GPIO_NUM_MAX) {
+        ESP_LOGE(TAG, "Invalid button configuration");
+        return NULL;
+    }
+    
+    if (config->repeat_accel_percent >= 100) {
+        ESP_LOGE(TAG, "Invalid auto-repeat acceleration");
+        return NULL;
+    }
+    
+    if (config->hold_stage_count > BUTTON_MAX_HOLD_STAGES ||
+        (config->hold_stage_count > 0 && config->hold_stages_ms == NULL)) {
+        ESP_LOGE(TAG, "Invalid hold stage configuration");
+        return NULL;
+    }
+    
+    if (config->sink.type > BUTTON_SINK_EVENT_LOOP ||
+        (config->sink.type != BUTTON_SINK_NONE && config->sink.handle == NULL)) {
+        ESP_LOGE(TAG, "Invalid event sink configuration");
+        return NULL;
+    }
+    
+#if !CONFIG_BUTTON_LONGPRESS_LONG_PRESS
+    if (config->hold_stage_count > 0 || config->repeat_interval_ms > 0 || config->hold_progress_interval_ms > 0) {
+        ESP_LOGE(TAG, "Hold features need CONFIG_BUTTON_LONGPRESS_LONG_PRESS");
+        return NULL;
+    }
+#endif
+    
+#if !CONFIG_BUTTON_LONGPRESS_DOUBLE_CLICK
+    /* Gesture gaps are measured with the double click timer */
+    if (config->gesture_count > 0) {
+        ESP_LOGE(TAG, "Gestures need CONFIG_BUTTON_LONGPRESS_DOUBLE_CLICK");
+        return NULL;
+    }
+#endif
+    
+    for (uint8_t i = 0; i < config->hold_stage_count; i++) {
+        if (config->hold_stages_ms[i] == 0 ||
+            (i > 0 && config->hold_stages_ms[i] <= config->hold_stages_ms[i - 1])) {
+            ESP_LOGE(TAG, "Hold stages must be non-zero and strictly ascending");
+            return NULL;
+        }
+    }
+    
+#if CONFIG_BUTTON_LONGPRESS_PM
+    if (button_pm_init() != ESP_OK) {
+        ESP_LOGE(TAG, "PM lock creation failed");
+        return NULL;
+    }
+#endif
+    
+    /* Allocate memory for button instance */
+    button_dev_t *btn = heap_caps_calloc(1, sizeof(button_dev_t), BUTTON_ISR_MEM_CAPS);
+    if (btn == NULL) {
+        ESP_LOGE(TAG, "Memory allocation failed");
+        return NULL;
+    }
+    
+    /* Initialize button configuration with defaults for zero values */
+    btn->gpio_num = config->gpio_num;
+    btn->active_level = config->active_level;
+    btn->debounce_time_ms = config->debounce_time_ms > 0 ? config->debounce_time_ms : 20;
+    btn->long_press_time_ms = config->long_press_time_ms > 0 ? config->long_press_time_ms : 1000;
+    btn->double_click_time_ms = config->double_click_time_ms > 0 ? config->double_click_time_ms : 300;
+    btn->callback = config->callback;
+    btn->double_click_on_press = config->double_click_on_press;
+    btn->hold_stage_count = config->hold_stage_count;
+    for (uint8_t i = 0; i < config->hold_stage_count; i++) {
+        btn->hold_stages_ms[i] = config->hold_stages_ms[i];
+    }
+    btn->event_callback = config->event_callback;
+    btn->user_ctx = config->user_ctx;
+    btn->repeat_interval_ms = config->repeat_interval_ms;
+    btn->repeat_delay_ms = config->repeat_delay_ms;
+    btn->repeat_min_interval_ms = config->repeat_min_interval_ms > 0 ? config->repeat_min_interval_ms : btn->repeat_interval_ms;
+    if (btn->repeat_min_interval_ms > btn->repeat_interval_ms) {
+        btn->repeat_min_interval_ms = btn->repeat_interval_ms;
+    }
+    btn->repeat_accel_percent = config->repeat_accel_percent;
+    btn->hold_progress_interval_ms = config->hold_progress_interval_ms;
+    btn->sink = config->sink;
+    btn->group = (button_group_t *)config->group;
+    btn->group_index = -1;
+    btn->engine = (button_engine_t *)config->engine;
+    btn->engine_slot = -1;
+    if (btn->engine == NULL && btn->group != NULL) {
+        btn->engine = button_group_pick_shard(btn->group);
+    }
+    
+    /* A stream buffer sink is written from one task only */
+    if (btn->sink.type == BUTTON_SINK_STREAM_BUFFER && !button_stream_sink_claim(btn)) {
+        ESP_LOGE(TAG, "Stream buffer sink is written from another task, or too many are in use");
+        free(btn);
+        return NULL;
+    }
+    
+    /* Compile gestures into a transition table */
+    if (config->gesture_count > 0 &&
+        button_gesture_compile(config->gestures, config->gesture_count, &btn->gestures) != ESP_OK) {
+        ESP_LOGE(TAG, "Invalid gesture configuration");
+        button_stream_sink_release(btn);
+        free(btn);
+        return NULL;
+    }
+    btn->fsm_state = BUTTON_FSM_IDLE;
+    btn->is_pressed = false;
+    
+    /* Create lock for thread safety */
+    if (!button_lock_init(btn)) {
+        ESP_LOGE(TAG, "Mutex creation failed");
+        button_gesture_free(btn->gestures);
+        button_stream_sink_release(btn);
+        free(btn);
+        return NULL;
+    }
+    
+    /* Configure GPIO */
+    gpio_config_t io_conf = {
+        .pin_bit_mask = (1ULL << config->gpio_num),
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = config->active_level ? GPIO_PULLUP_DISABLE : GPIO_PULLUP_ENABLE,
+        .pull_down_en = config->active_level ? GPIO_PULLDOWN_ENABLE : GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_ANYEDGE,
+    };
+    
+    if (gpio_config(&io_conf) != ESP_OK) {
+        ESP_LOGE(TAG, "GPIO configuration failed");
+        button_lock_deinit(btn);
+        button_gesture_free(btn->gestures);
+        button_stream_sink_release(btn);
+        free(btn);
+        return NULL;
+    }
+    
+    /* Create timers, an engine keeps its deadlines itself */
+    bool timers_ok = true;
+    
+    for (int id = 0; id < BUTTON_TIMER_MAX && btn->engine == NULL; id++) {
+        btn->timers[id] = xTimerCreate(s_timer_names[id],
+                                       button_timer_period(btn, (button_timer_id_t)id),
+                                       pdFALSE, btn, button_timer_cb);
+        timers_ok = timers_ok && (btn->timers[id] != NULL);
+    }
+    
+    /* Verify timer creation */
+    if (!timers_ok) {
+        ESP_LOGE(TAG, "Timer creation failed");
+        button_delete_timers(btn);
+        button_lock_deinit(btn);
+        button_gesture_free(btn->gestures);
+        button_stream_sink_release(btn);
+        free(btn);
+        return NULL;
+    }
+    
+    /* Join group */
+    if (btn->group != NULL) {
+        btn->group_index = button_group_join(btn->group, btn);
+        if (btn->group_index < 0) {
+            ESP_LOGE(TAG, "Button group is full");
+            button_delete_timers(btn);
+            button_lock_deinit(btn);
+            button_gesture_free(btn->gestures);
+            button_stream_sink_release(btn);
+            free(btn);
+            return NULL;
+        }
+    }
+    
+    /* Join engine */
+    if (btn->engine != NULL && !button_engine_link(btn)) {
+        ESP_LOGE(TAG, "Button engine is full");
+        if (btn->group != NULL) {
+            button_group_leave(btn->group, btn->group_index);
+        }
+        button_delete_timers(btn);
+        button_lock_deinit(btn);
+        button_gesture_free(btn->gestures);
+        button_stream_sink_release(btn);
+        free(btn);
+        return NULL;
+    }
+    
+    /* Add ISR handler */
+    if (button_isr_attach(btn) != ESP_OK) {
+        if (btn->engine != NULL) {
+            button_engine_unlink(btn);
+        }
+        if (btn->group != NULL) {
+            button_group_leave(btn->group, btn->group_index);
+        }
+        button_delete_timers(btn);
+        button_lock_deinit(btn);
+        button_gesture_free(btn->gestures);
+        button_stream_sink_release(btn);
+        free(btn);
+        return NULL;
+    }
+    
+    /* Initialize state and start the debounce timer */
+    btn->is_pressed = false;
+    btn->fsm_state = BUTTON_FSM_IDLE;
+    button_pm_arm(btn, BUTTON_TIMER_DEBOUNCE);
+    if (btn->engine != NULL) {
+        atomic_fetch_or_explicit(&btn->engine->edge_pending, 1ULL << btn->engine_slot, memory_order_release);
+        xTaskNotifyGive(btn->engine->task);
+    } else {
+        xTimerReset(btn->timers[BUTTON_TIMER_DEBOUNCE], 0);
+    }
+    
+    ESP_LOGI(TAG, "Button created on GPIO %d, active %s", 
+             btn->gpio_num, btn->active_level ? "HIGH" : "LOW");
+    
+    return (button_handle_t)btn;
+}
+
+/**
+ * @brief Delete a button instance and clean up resources
+ * 
+ * @param btn_handle Handle to the button instance
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG otherwise
+ */
+esp_err_t button_delete(button_handle_t btn_handle)
+{
+    CHECK_ARG(btn_handle);
+    
+    button_dev_t *btn = (button_dev_t *)btn_handle;
+    
+    /* Remove ISR handler */
+    button_isr_detach(btn);
+    
+    /* Leave engine, after which its task no longer runs the button */
+    if (btn->engine != NULL) {
+        button_engine_unlink(btn);
+    }
+    
+    /* Delete timers */
+    button_delete_timers(btn);
+    
+#if CONFIG_BUTTON_LONGPRESS_PM
+    button_pm_detach(btn);
+#endif
+    
+    /* Leave group */
+    if (btn->group != NULL) {
+        button_group_leave(btn->group, btn->group_index);
+    }
+    
+    /* Delete lock */
+    button_lock_deinit(btn);
+    
+    /* Free memory */
+    button_stream_sink_release(btn);
+    button_gesture_free(btn->gestures);
+    free(btn);
+    
+    return ESP_OK;
+}
+
+/**
+ * @brief Get current button state
+ * 
+ * @param btn_handle Handle to the button instance
+ * @return Current button state
+ */
+button_state_t button_get_state(button_handle_t btn_handle)
+{
+    if (btn_handle == NULL) {
+        ESP_LOGW(TAG, "Null button handle in get_state");
+        return BUTTON_STATE_IDLE;
+    }
+    
+    button_dev_t *btn = (button_dev_t *)btn_handle;
+    button_state_t state = BUTTON_STATE_IDLE;
+    
+    if (button_lock(btn)) {
+        state = (button_state_t)s_fsm_public_state[btn->fsm_state];
+        button_unlock(btn);
+    } else {
+        ESP_LOGE(TAG, "Mutex error in get_state");
+    }
+    
+    return state;
+}
+
+/**
+ * @brief Check if button is currently pressed
+ * 
+ * @param btn_handle Handle to the button instance
+ * @return true if button is pressed, false otherwise
+ */
+bool button_is_pressed(button_handle_t btn_handle)
+{
+    if (btn_handle == NULL) {
+        ESP_LOGW(TAG, "Null button handle in is_pressed");
+        return false;
+    }
+    
+    button_dev_t *btn = (button_dev_t *)btn_handle;
+    bool is_pressed = false;
+    
+    if (button_lock(btn)) {
+        is_pressed = btn->is_pressed;
+        button_unlock(btn);
+    } else {
+        ESP_LOGE(TAG, "Mutex error in is_pressed");
+    }
+    
+    return is_pressed;
+}
+
+/**
+ * @brief Give the semaphore of button_dispatch_sync() from the dispatch task
+ */
+static void button_dispatch_sync_cb(void *arg, uint32_t unused)
+{
+    xSemaphoreGive((SemaphoreHandle_t)arg);
+}
+
+/**
+ * @brief Wait until no event of the button is being dispatched
+ *
+ * Events of a button are dispatched by one task: the engine task, which holds
+ * the engine lock while it runs callbacks, or the timer service task, which
+ * runs a pended call only after the running callback has returned. Called
+ * from that task itself, no other dispatch can be in progress.
+ */
+static void button_dispatch_sync(button_dev_t *btn)
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    
+    if (btn->engine != NULL) {
+        if (self != btn->engine->task) {
+            xSemaphoreTakeRecursive(btn->engine->mutex, portMAX_DELAY);
+            xSemaphoreGiveRecursive(btn->engine->mutex);
+        }
+        return;
+    }
+    if (self == xTimerGetTimerDaemonTaskHandle()) {
+        return;
+    }
+    
+    StaticSemaphore_t done_buffer;
+    SemaphoreHandle_t done = xSemaphoreCreateBinaryStatic(&done_buffer);
+    if (xTimerPendFunctionCall(button_dispatch_sync_cb, done, 0, portMAX_DELAY) == pdPASS) {
+        xSemaphoreTake(done, portMAX_DELAY);
+    } else {
+        ESP_LOGE(TAG, "Failed to sync with the timer service task");
+    }
+    vSemaphoreDelete(done);
+}
+
+/**
+ * @brief Replace the extended event callback and its user context
+ * 
+ * @param btn_handle Handle to the button instance
+ * @param event_callback New extended callback, or NULL
+ * @param user_ctx User context passed to event_callback
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG or ESP_FAIL otherwise
+ */
+esp_err_t button_set_event_callback(button_handle_t btn_handle, button_event_cb_t event_callback, void *user_ctx)
+{
+    CHECK_ARG(btn_handle);
+    
+    button_dev_t *btn = (button_dev_t *)btn_handle;
+    
+    if (!button_lock(btn)) {
+        ESP_LOGE(TAG, "Mutex error in set_event_callback");
+        return ESP_FAIL;
+    }
+    btn->event_callback = event_callback;
+    btn->user_ctx = user_ctx;
+    button_unlock(btn);
+    
+    /* The previous callback may still be running with the previous context */
+    button_dispatch_sync(btn);
+    
+    return ESP_OK;
+}
+
+/**
+ * @brief Replace the event callback
+ * 
+ * @param btn_handle Handle to the button instance
+ * @param callback New callback, or NULL
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG or ESP_FAIL otherwise
+ */
+esp_err_t button_set_callback(button_handle_t btn_handle, void (*callback)(button_event_t))
+{
+    CHECK_ARG(btn_handle);
+    
+    button_dev_t *btn = (button_dev_t *)btn_handle;
+    
+    if (!button_lock(btn)) {
+        ESP_LOGE(TAG, "Mutex error in set_callback");
+        return ESP_FAIL;
+    }
+    btn->callback = callback;
+    button_unlock(btn);
+    
+    button_dispatch_sync(btn);
+    
+    return ESP_OK;
+}
+
+/**
+ * @brief Lock a live button for reconfiguration
+ *
+ * Engine buttons also take the engine lock, since their deadlines live in
+ * the engine and are otherwise only touched by the engine task.
+ *
+ * @return true if locked, false on mutex error
+ */
+static bool button_reconfig_begin(button_dev_t *btn)
+{
+    if (btn->engine != NULL) {
+        xSemaphoreTakeRecursive(btn->engine->mutex, portMAX_DELAY);
+    }
+    if (!button_lock(btn)) {
+        if (btn->engine != NULL) {
+            xSemaphoreGiveRecursive(btn->engine->mutex);
+        }
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Resample the pin and unlock a reconfigured button
+ *
+ * Restarting the debounce deadline makes the state follow the new
+ * configuration; it also loads the new debounce period into the software
+ * timer restarted by the GPIO interrupt. A suspended button is resampled
+ * when it is resumed.
+ */
+static void button_reconfig_end(button_dev_t *btn)
+{
+    if (btn->suspended) {
+        /* Nothing to resample */
+    } else if (btn->engine != NULL) {
+        button_pm_arm(btn, BUTTON_TIMER_DEBOUNCE);
+        atomic_fetch_or_explicit(&btn->engine->edge_pending, 1ULL << btn->engine_slot, memory_order_release);
+    } else {
+        button_timer_start(btn, BUTTON_TIMER_DEBOUNCE, BUTTON_TIMER_DEFAULT_PERIOD);
+    }
+    button_unlock(btn);
+    
+    if (btn->engine != NULL) {
+        xSemaphoreGiveRecursive(btn->engine->mutex);
+        /* Deadlines may have moved, let the engine recompute its wait */
+        xTaskNotifyGive(btn->engine->task);
+    }
+    button_pm_settle(btn);
+}
+
+/**
+ * @brief Change the timings of a live button
+ * 
+ * @param btn_handle Handle to the button instance
+ * @param debounce_time_ms Debounce time, 0 for the default
+ * @param long_press_time_ms Long press time, 0 for the default
+ * @param double_click_time_ms Double click time, 0 for the default
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG or ESP_FAIL otherwise
+ */
+esp_err_t button_set_timings(button_handle_t btn_handle, uint32_t debounce_time_ms,
+                             uint32_t long_press_time_ms, uint32_t double_click_time_ms)
+{
+    CHECK_ARG(btn_handle);
+    
+    button_dev_t *btn = (button_dev_t *)btn_handle;
+    
+    if (!button_reconfig_begin(btn)) {
+        ESP_LOGE(TAG, "Mutex error in set_timings");
+        return ESP_FAIL;
+    }
+    
+    btn->debounce_time_ms = debounce_time_ms > 0 ? debounce_time_ms : 20;
+    btn->long_press_time_ms = long_press_time_ms > 0 ? long_press_time_ms : 1000;
+    btn->double_click_time_ms = double_click_time_ms > 0 ? double_click_time_ms : 300;
+    
+    /* A press in progress is held against the new long press time */
+    if (btn->is_pressed) {
+        button_hold_schedule(btn, button_hold_time_ms(btn));
+    }
+    
+    button_reconfig_end(btn);
+    
+    return ESP_OK;
+}
+
+/**
+ * @brief Change the active level of a live button
+ * 
+ * @param btn_handle Handle to the button instance
+ * @param active_level true: active high, false: active low
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG or ESP_FAIL otherwise
+ */
+esp_err_t button_set_active_level(button_handle_t btn_handle, bool active_level)
+{
+    CHECK_ARG(btn_handle);
+    
+    button_dev_t *btn = (button_dev_t *)btn_handle;
+    
+    if (gpio_set_pull_mode(btn->gpio_num, active_level ? GPIO_PULLDOWN_ONLY : GPIO_PULLUP_ONLY) != ESP_OK) {
+        ESP_LOGE(TAG, "GPIO configuration failed");
+        return ESP_FAIL;
+    }
+    
+    if (!button_reconfig_begin(btn)) {
+        ESP_LOGE(TAG, "Mutex error in set_active_level");
+        return ESP_FAIL;
+    }
+    btn->active_level = active_level;
+    button_reconfig_end(btn);
+    
+    return ESP_OK;
+}
+
+/**
+ * @brief Stop a button's interrupt and deadlines, keeping its resources
+ * 
+ * @param btn_handle Handle to the button instance
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG or ESP_FAIL otherwise
+ */
+esp_err_t button_suspend(button_handle_t btn_handle)
+{
+    CHECK_ARG(btn_handle);
+    
+    button_dev_t *btn = (button_dev_t *)btn_handle;
+    
+    /* No new edges first, so no debounce can be restarted behind our back */
+    gpio_intr_disable(btn->gpio_num);
+#if CONFIG_BUTTON_LONGPRESS_PM
+    /* A suspended button does not wake the chip, and resumes on edges */
+    gpio_wakeup_disable(btn->gpio_num);
+    gpio_set_intr_type(btn->gpio_num, GPIO_INTR_ANYEDGE);
+#endif
+    
+    if (!button_reconfig_begin(btn)) {
+        ESP_LOGE(TAG, "Mutex error in suspend");
+        gpio_intr_enable(btn->gpio_num);
+        return ESP_FAIL;
+    }
+    
+    for (int id = 0; id < BUTTON_TIMER_MAX; id++) {
+        button_timer_stop(btn, (button_timer_id_t)id);
+    }
+    if (btn->engine != NULL) {
+        atomic_fetch_and_explicit(&btn->engine->edge_pending, ~(1ULL << btn->engine_slot), memory_order_relaxed);
+    }
+    btn->suspended = true;
     
-    /* Timers */
-    TimerHandle_t debounce_timer;       /*!< Timer for debouncing */
-    TimerHandle_t long_press_timer;     /*!< Timer for long press detection */
-    TimerHandle_t double_click_timer;   /*!< Timer for double click detection */
+    button_reconfig_end(btn);
     
-    /* Synchronization */
-    SemaphoreHandle_t mutex;            /*!< Mutex for thread safety */
-} button_dev_t;
-
-/* Global variable to track the last event time for debouncing */
-static uint32_t s_last_event_time = 0;
+    return ESP_OK;
+}
 
 /**
- * @brief Debounce timer callback
+ * @brief Resume a suspended button and resynchronize it with its pin
  * 
- * This function is called when the debounce timer expires.
- * It processes the button state after debounce period.
+ * @param btn_handle Handle to the button instance
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG or ESP_FAIL otherwise
  */
-static void button_debounce_timer_cb(TimerHandle_t timer)
+esp_err_t button_resume(button_handle_t btn_handle)
 {
-    button_dev_t *btn = (button_dev_t *)pvTimerGetTimerID(timer);
+    CHECK_ARG(btn_handle);
     
-    if (xSemaphoreTake(btn->mutex, portMAX_DELAY) != pdTRUE) {
-        ESP_LOGE(TAG, "Mutex error in debounce callback");
-        return;
-    }
+    button_dev_t *btn = (button_dev_t *)btn_handle;
     
-    /* Get current GPIO level and determine if button is active */
-    int level = gpio_get_level(btn->gpio_num);
-    bool is_active = (btn->active_level) ? (level == 1) : (level == 0);
+    if (!button_reconfig_begin(btn)) {
+        ESP_LOGE(TAG, "Mutex error in resume");
+        return ESP_FAIL;
+    }
     
-    /* Fix state inconsistency if needed */
-    if (btn->state == BUTTON_STATE_LONG_PRESS && !btn->is_pressed) {
-        btn->state = BUTTON_STATE_IDLE;
+    if (btn->suspended) {
+        btn->suspended = false;
+        
+        /* Re-arm what was pending; deadlines passed while suspended fire right away */
+        if (btn->is_pressed) {
+            button_hold_schedule(btn, button_hold_time_ms(btn));
+        }
+#if CONFIG_BUTTON_LONGPRESS_DOUBLE_CLICK
+        else if (btn->fsm_state == BUTTON_FSM_WAIT || btn->gestures != NULL) {
+            button_timer_start(btn, BUTTON_TIMER_DOUBLE_CLICK, BUTTON_TIMER_DEFAULT_PERIOD);
+        }
+#endif
     }
+    
+    /* The level may have changed while the interrupt was off */
+    button_reconfig_end(btn);
+    gpio_intr_enable(btn->gpio_num);
+    
+    return ESP_OK;
+}
 
-    /* Anti-noise protection */
-    uint32_t current_time = xTaskGetTickCount() * portTICK_PERIOD_MS;
-    uint32_t min_event_interval = btn->debounce_time_ms / 2;
+/**
+ * @brief Fetch and clear the events latched since the previous call
+ * 
+ * @param btn_handle Handle to the button instance
+ * @param out Filled with the latched events
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG otherwise
+ */
+esp_err_t button_consume_events(button_handle_t btn_handle, button_events_t *out)
+{
+    CHECK_ARG(btn_handle);
+    CHECK_ARG(out);
     
-    if (current_time - s_last_event_time < min_event_interval && is_active != btn->is_pressed) {
-        xSemaphoreGive(btn->mutex);
-        return;
-    }
+    button_dev_t *btn = (button_dev_t *)btn_handle;
+    uint32_t pending = atomic_exchange_explicit(&btn->latched_mask, 0, memory_order_acquire);
     
-    if (is_active) {
-        /* Button press detected */
-        if (!btn->is_pressed) {
-            btn->is_pressed = true;
-            
-            /* Handle potential double click */
-            if (btn->waiting_for_double_click) {
-                xTimerStop(btn->double_click_timer, 0);
-                btn->state = BUTTON_STATE_PRESSED;
-                btn->waiting_for_double_click = false;
-                btn->click_count = 2;
-            } else {
-                btn->state = BUTTON_STATE_PRESSED;
-                btn->click_count = 1;
-            }
-            
-            /* Start long press timer */
-            xTimerStart(btn->long_press_timer, 0);
-            
-            /* Call press callback */
-            if (btn->callback) {
-                xSemaphoreGive(btn->mutex);
-                btn->callback(BUTTON_EVENT_PRESSED);
-                if (xSemaphoreTake(btn->mutex, portMAX_DELAY) != pdTRUE) {
-                    ESP_LOGE(TAG, "Mutex error after press callback");
-                    return;
-                }
-            }
-            
-            s_last_event_time = current_time;
-        }
-    } else {
-        /* Button release detected */
-        if (btn->is_pressed) {
-            btn->is_pressed = false;
-            xTimerStop(btn->long_press_timer, 0);
-            
-            /* Update state */
-            if (btn->state == BUTTON_STATE_PRESSED) {
-                btn->state = BUTTON_STATE_SHORT_PRESS;
-            }
-            
-            /* Call release callback */
-            if (btn->callback) {
-                xSemaphoreGive(btn->mutex);
-                btn->callback(BUTTON_EVENT_RELEASED);
-                if (xSemaphoreTake(btn->mutex, portMAX_DELAY) != pdTRUE) {
-                    ESP_LOGE(TAG, "Mutex error after release callback");
-                    return;
-                }
-            }
-            
-            /* Handle double click detection */
-            if (btn->click_count == 2 && btn->state != BUTTON_STATE_LONG_PRESS) {
-                btn->state = BUTTON_STATE_DOUBLE_CLICK;
-                
-                if (btn->callback) {
-                    xSemaphoreGive(btn->mutex);
-                    btn->callback(BUTTON_EVENT_DOUBLE_CLICK);
-                    if (xSemaphoreTake(btn->mutex, portMAX_DELAY) != pdTRUE) {
-                        ESP_LOGE(TAG, "Mutex error after double click callback");
-                        return;
-                    }
-                }
-                
-                btn->click_count = 0;
-            } else if (btn->click_count == 1 && btn->state != BUTTON_STATE_LONG_PRESS) {
-                btn->waiting_for_double_click = true;
-                btn->state = BUTTON_STATE_IDLE;
-                xTimerStart(btn->double_click_timer, 0);
+#if !CONFIG_BUTTON_LONGPRESS_STATS
+    /* Occurrences are not counted */
+    out->mask = pending;
+    for (int event = 0; event < BUTTON_EVENT_MAX; event++) {
+        out->counts[event] = 0;
+    }
+#else
+    out->mask = 0;
+    for (int event = 0; event < BUTTON_EVENT_MAX; event++) {
+        out->counts[event] = 0;
+        if (pending & BUTTON_EVENT_MASK(event)) {
+            /* A count taken here may belong to an event whose mask bit is set
+             * after the exchange; the next call then finds a zero count */
+            out->counts[event] = atomic_exchange_explicit(&btn->latched_counts[event], 0,
+                                                          memory_order_relaxed);
+            if (out->counts[event] > 0) {
+                out->mask |= BUTTON_EVENT_MASK(event);
             }
-            
-            s_last_event_time = current_time;
         }
     }
+#endif
     
-    xSemaphoreGive(btn->mutex);
+    return ESP_OK;
+}
+
+/**
+ * @brief Get the number of event records dropped because the sink was full
+ * 
+ * @param btn_handle Handle to the button instance
+ * @return Number of dropped records
+ */
+uint32_t button_get_dropped_events(button_handle_t btn_handle)
+{
+    if (btn_handle == NULL) {
+        ESP_LOGW(TAG, "Null button handle in get_dropped_events");
+        return 0;
+    }
+    
+#if CONFIG_BUTTON_LONGPRESS_STATS
+    return ((button_dev_t *)btn_handle)->sink_drops;
+#else
+    return 0;
+#endif
 }
 
 /**
- * @brief Long press timer callback
+ * @brief Block the calling task until one of the buttons reports an event
  * 
- * This function is called when the long press timer expires.
- * It processes the long press event.
+ * @param handles Buttons to wait on, or NULL for every button
+ * @param count Number of entries in handles
+ * @param event_mask Events to wait for, 0 for any event
+ * @param timeout Maximum time to wait in ticks
+ * @param out Filled with the event that woke the task
+ * @return ESP_OK on event, ESP_ERR_TIMEOUT on timeout, ESP_ERR_INVALID_ARG otherwise
  */
-static void button_long_press_timer_cb(TimerHandle_t timer)
+esp_err_t button_wait_event(const button_handle_t *handles, size_t count, uint32_t event_mask,
+                            TickType_t timeout, button_event_info_t *out)
 {
-    button_dev_t *btn = (button_dev_t *)pvTimerGetTimerID(timer);
+    CHECK_ARG(out);
+    CHECK_ARG(handles == NULL || count > 0);
     
-    if (xSemaphoreTake(btn->mutex, portMAX_DELAY) != pdTRUE) {
-        ESP_LOGE(TAG, "Mutex error in long press callback");
-        return;
-    }
+    /*
+     * Woken through a semaphore on our own stack, so the task's notification
+     * values stay free for the application
+     */
+    StaticSemaphore_t signal_buffer;
+    SemaphoreHandle_t signal = xSemaphoreCreateBinaryStatic(&signal_buffer);
     
-    /* Verify button is still pressed */
-    if (btn->is_pressed) {
-        int level = gpio_get_level(btn->gpio_num);
-        bool is_active = (btn->active_level) ? (level == 1) : (level == 0);
+    button_waiter_t waiter = {
+        .signal = signal,
+        .callback = NULL,
+        .handles = handles,
+        .count = count,
+        .event_mask = event_mask != 0 ? event_mask : BUTTON_EVENT_MASK_ALL,
+        .out = out,
+        .done = false,
+    };
+    
+    portENTER_CRITICAL(&s_waiters_lock);
+    waiter.next = s_waiters;
+    s_waiters = &waiter;
+    button_waiters_update();
+    portEXIT_CRITICAL(&s_waiters_lock);
+    
+    /* The semaphore is only given after the waiter has completed */
+    bool done = (xSemaphoreTake(signal, timeout) == pdTRUE);
+    
+    if (!done) {
+        portENTER_CRITICAL(&s_waiters_lock);
+        done = waiter.done;
+        if (!done) {
+            /* Unlink ourselves before the stack frame goes away */
+            button_waiter_unlink(&waiter);
+        }
+        portEXIT_CRITICAL(&s_waiters_lock);
         
-        if (is_active) {
-            /* Cancel double click detection */
-            btn->waiting_for_double_click = false;
-            xTimerStop(btn->double_click_timer, 0);
-            btn->click_count = 0;
-            btn->state = BUTTON_STATE_LONG_PRESS;
-            
-            if (btn->callback) {
-                xSemaphoreGive(btn->mutex);
-                btn->callback(BUTTON_EVENT_LONG_PRESS);
-                if (xSemaphoreTake(btn->mutex, portMAX_DELAY) != pdTRUE) {
-                    ESP_LOGE(TAG, "Mutex error after long press callback");
-                    return;
-                }
-            }
-        } else {
-            /* Button was released between timer expiry and callback execution */
-            btn->is_pressed = false;
+        if (done) {
+            /* Completed as we timed out: let the give land before the semaphore goes away */
+            xSemaphoreTake(signal, portMAX_DELAY);
         }
     }
+    vSemaphoreDelete(signal);
     
-    xSemaphoreGive(btn->mutex);
+    return done ? ESP_OK : ESP_ERR_TIMEOUT;
 }
 
 /**
- * @brief Double click timer callback
+ * @brief Wait for a button event without blocking the calling task
  * 
- * This function is called when the double click timer expires.
- * It handles the case when the second click doesn't arrive in time.
+ * @param wait Caller-owned waiter storage
+ * @param handles Buttons to wait on, or NULL for every button
+ * @param count Number of handles
+ * @param event_mask Events to wait for (0: any event)
+ * @param timeout Maximum time to wait in ticks
+ * @param callback Completion callback
+ * @param ctx Context passed to callback
+ * @return ESP_OK if registered, ESP_ERR_INVALID_ARG or ESP_ERR_NO_MEM otherwise
  */
-static void button_double_click_timer_cb(TimerHandle_t timer)
+esp_err_t button_wait_event_async(button_wait_t *wait, const button_handle_t *handles, size_t count,
+                                  uint32_t event_mask, TickType_t timeout, button_wait_cb_t callback, void *ctx)
 {
-    button_dev_t *btn = (button_dev_t *)pvTimerGetTimerID(timer);
+    CHECK_ARG(wait);
+    CHECK_ARG(callback);
+    CHECK_ARG(handles == NULL || count > 0);
     
-    if (xSemaphoreTake(btn->mutex, portMAX_DELAY) != pdTRUE) {
-        ESP_LOGE(TAG, "Mutex error in double click callback");
-        return;
-    }
+    bool timed = (timeout != portMAX_DELAY);
     
-    /* Reset double click state if timer expires */
-    if (btn->waiting_for_double_click) {
-        btn->waiting_for_double_click = false;
-        
-        /* Trigger single click event since no second click occurred */
-        if (btn->callback) {
-            xSemaphoreGive(btn->mutex);
-            btn->callback(BUTTON_EVENT_CLICK);
-            if (xSemaphoreTake(btn->mutex, portMAX_DELAY) != pdTRUE) {
-                ESP_LOGE(TAG, "Mutex error after click callback");
-                return;
-            }
+    /* Created on first use and kept for the lifetime of the application */
+    portENTER_CRITICAL(&s_waiters_lock);
+    bool need_timer = timed && s_wait_timer == NULL;
+    portEXIT_CRITICAL(&s_waiters_lock);
+    
+    if (need_timer) {
+        TimerHandle_t timer = xTimerCreate("btn_wait", 1, pdFALSE, NULL, button_wait_timer_cb);
+        if (timer == NULL) {
+            ESP_LOGE(TAG, "Wait timer creation failed");
+            return ESP_ERR_NO_MEM;
         }
         
-        /* Ensure the button state is updated */
-        if (!btn->is_pressed) {
-            btn->state = BUTTON_STATE_IDLE;
+        portENTER_CRITICAL(&s_waiters_lock);
+        bool installed = (s_wait_timer == NULL);
+        if (installed) {
+            s_wait_timer = timer;
         }
+        portEXIT_CRITICAL(&s_waiters_lock);
         
-        /* Reset click counter */
-        btn->click_count = 0;
-        ESP_LOGD(TAG, "Single click confirmed after timeout");
+        if (!installed) {
+            xTimerDelete(timer, 0);
+        }
     }
     
-    xSemaphoreGive(btn->mutex);
+    *wait = (button_wait_t){
+        .signal = NULL,
+        .callback = callback,
+        .ctx = ctx,
+        .handles = handles,
+        .count = count,
+        .event_mask = event_mask != 0 ? event_mask : BUTTON_EVENT_MASK_ALL,
+        .out = NULL,
+        .deadline = xTaskGetTickCount() + timeout,
+        .timed = timed,
+        .done = false,
+    };
+    
+    portENTER_CRITICAL(&s_waiters_lock);
+    wait->next = s_waiters;
+    s_waiters = wait;
+    button_waiters_update();
+    portEXIT_CRITICAL(&s_waiters_lock);
+    
+    /* Re-arm from the timer service task only, where re-arms are serialized */
+    if (timed) {
+        if (xTaskGetCurrentTaskHandle() == xTimerGetTimerDaemonTaskHandle()) {
+            button_wait_timer_arm(NULL, 0);
+        } else if (xTimerPendFunctionCall(button_wait_timer_arm, NULL, 0, portMAX_DELAY) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to arm wait timeout");
+            button_wait_event_cancel(wait);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    
+    return ESP_OK;
 }
 
 /**
- * @brief GPIO interrupt handler
+ * @brief Cancel an asynchronous wait
  * 
- * This function is called when a GPIO interrupt occurs.
- * It resets the debounce timer to start debouncing.
+ * @param wait Storage passed to button_wait_event_async()
+ * @return true if the wait was removed before completing
  */
-static void IRAM_ATTR button_isr_handler(void *arg)
+bool button_wait_event_cancel(button_wait_t *wait)
 {
-    button_dev_t *btn = (button_dev_t *)arg;
-    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    if (wait == NULL) {
+        return false;
+    }
     
-    xTimerResetFromISR(btn->debounce_timer, &xHigherPriorityTaskWoken);
+    portENTER_CRITICAL(&s_waiters_lock);
+    bool removed = button_waiter_unlink(wait);
+    portEXIT_CRITICAL(&s_waiters_lock);
     
-    if (xHigherPriorityTaskWoken) {
-        portYIELD_FROM_ISR();
-    }
+    return removed;
 }
 
 /**
- * @brief Create and initialize a button
+ * @brief Create an empty button group
  * 
- * @param config Pointer to button configuration
- * @return button_handle_t Handle to the button instance, or NULL if failed
+ * @return button_group_handle_t Handle to the group, or NULL if failed
  */
-button_handle_t button_create(const button_config_t *config)
+button_group_handle_t button_group_create(void)
 {
-    /* Validate parameters */
-    if (config == NULL || config->gpio_num >= GPIO_NUM_MAX) {
-        ESP_LOGE(TAG, "Invalid button configuration");
-        return NULL;
-    }
-    
-    /* Allocate memory for button instance */
-    button_dev_t *btn = calloc(1, sizeof(button_dev_t));
-    if (btn == NULL) {
+    button_group_t *group = calloc(1, sizeof(button_group_t));
+    if (group == NULL) {
         ESP_LOGE(TAG, "Memory allocation failed");
         return NULL;
     }
     
-    /* Initialize button configuration with defaults for zero values */
-    btn->gpio_num = config->gpio_num;
-    btn->active_level = config->active_level;
-    btn->debounce_time_ms = config->debounce_time_ms > 0 ? config->debounce_time_ms : 20;
-    btn->long_press_time_ms = config->long_press_time_ms > 0 ? config->long_press_time_ms : 1000;
-    btn->double_click_time_ms = config->double_click_time_ms > 0 ? config->double_click_time_ms : 300;
-    btn->callback = config->callback;
-    btn->state = BUTTON_STATE_IDLE;
-    btn->is_pressed = false;
-    btn->waiting_for_double_click = false;
-    btn->click_count = 0;
-    
-    /* Create mutex for thread safety */
-    btn->mutex = xSemaphoreCreateMutex();
-    if (btn->mutex == NULL) {
-        ESP_LOGE(TAG, "Mutex creation failed");
-        free(btn);
-        return NULL;
-    }
+    atomic_init(&group->pressed_mask, 0);
+    atomic_init(&group->suppress_mask, 0);
+    group->member_mask = 0;
+    portMUX_INITIALIZE(&group->lock);
     
-    /* Configure GPIO */
-    gpio_config_t io_conf = {
-        .pin_bit_mask = (1ULL << config->gpio_num),
-        .mode = GPIO_MODE_INPUT,
-        .pull_up_en = config->active_level ? GPIO_PULLDOWN_ENABLE : GPIO_PULLUP_ENABLE,
-        .pull_down_en = config->active_level ? GPIO_PULLUP_DISABLE : GPIO_PULLDOWN_DISABLE,
-        .intr_type = GPIO_INTR_ANYEDGE,
-    };
+    return (button_group_handle_t)group;
+}
+
+/**
+ * @brief Delete a button group
+ * 
+ * @param group Handle to the group
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG or ESP_ERR_INVALID_STATE otherwise
+ */
+esp_err_t button_group_delete(button_group_handle_t group)
+{
+    CHECK_ARG(group);
     
-    if (gpio_config(&io_conf) != ESP_OK) {
-        ESP_LOGE(TAG, "GPIO configuration failed");
-        vSemaphoreDelete(btn->mutex);
-        free(btn);
-        return NULL;
-    }
+    button_group_t *grp = (button_group_t *)group;
     
-    /* Create timers */
-    btn->debounce_timer = xTimerCreate("btn_dbnc", 
-                                      pdMS_TO_TICKS(btn->debounce_time_ms),
-                                      pdFALSE, btn, button_debounce_timer_cb);
+    portENTER_CRITICAL(&grp->lock);
+    uint64_t members = grp->member_mask;
+    portEXIT_CRITICAL(&grp->lock);
     
-    btn->long_press_timer = xTimerCreate("btn_long", 
-                                        pdMS_TO_TICKS(btn->long_press_time_ms),
-                                        pdFALSE, btn, button_long_press_timer_cb);
+    if (members != 0) {
+        ESP_LOGE(TAG, "Button group still has members");
+        return ESP_ERR_INVALID_STATE;
+    }
     
-    btn->double_click_timer = xTimerCreate("btn_dblc", 
-                                         pdMS_TO_TICKS(btn->double_click_time_ms),
-                                         pdFALSE, btn, button_double_click_timer_cb);
+    free(grp);
     
-    /* Verify timer creation */
-    if (btn->debounce_timer == NULL || btn->long_press_timer == NULL || btn->double_click_timer == NULL) {
-        ESP_LOGE(TAG, "Timer creation failed");
-        if (btn->debounce_timer) xTimerDelete(btn->debounce_timer, 0);
-        if (btn->long_press_timer) xTimerDelete(btn->long_press_timer, 0);
-        if (btn->double_click_timer) xTimerDelete(btn->double_click_timer, 0);
-        vSemaphoreDelete(btn->mutex);
-        free(btn);
-        return NULL;
+    return ESP_OK;
+}
+
+/**
+ * @brief Get the debounced pressed state of every button in a group
+ * 
+ * @param group Handle to the group
+ * @return Pressed bitmap indexed by group bit
+ */
+uint64_t button_group_get_pressed_mask(button_group_handle_t group)
+{
+    if (group == NULL) {
+        ESP_LOGW(TAG, "Null group handle in get_pressed_mask");
+        return 0;
     }
     
-    /* Install ISR service if needed */
-    static bool isr_service_installed = false;
-    if (!isr_service_installed) {
-        esp_err_t ret = gpio_install_isr_service(0);
-        if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
-            ESP_LOGE(TAG, "ISR service installation failed: %d", ret);
-            xTimerDelete(btn->debounce_timer, 0);
-            xTimerDelete(btn->long_press_timer, 0);
-            xTimerDelete(btn->double_click_timer, 0);
-            vSemaphoreDelete(btn->mutex);
-            free(btn);
-            return NULL;
-        }
-        isr_service_installed = true;
-    }
+    return atomic_load_explicit(&((button_group_t *)group)->pressed_mask, memory_order_acquire);
+}
+
+/**
+ * @brief Set the chords detected in a group
+ * 
+ * @param group Handle to the group
+ * @param chords Chord definitions, NULL to remove all chords
+ * @param count Number of chords
+ * @param callback Callback for chord events
+ * @param user_ctx User context passed to callback
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG otherwise
+ */
+esp_err_t button_group_set_chords(button_group_handle_t group, const button_chord_t *chords, uint8_t count,
+                                  button_event_cb_t callback, void *user_ctx)
+{
+    CHECK_ARG(group);
+    CHECK_ARG(count <= BUTTON_GROUP_MAX_CHORDS);
+    CHECK_ARG(chords != NULL || count == 0);
     
-    /* Add ISR handler */
-    if (gpio_isr_handler_add(btn->gpio_num, button_isr_handler, btn) != ESP_OK) {
-        ESP_LOGE(TAG, "ISR handler addition failed");
-        xTimerDelete(btn->debounce_timer, 0);
-        xTimerDelete(btn->long_press_timer, 0);
-        xTimerDelete(btn->double_click_timer, 0);
-        vSemaphoreDelete(btn->mutex);
-        free(btn);
-        return NULL;
+    for (uint8_t i = 0; i < count; i++) {
+        if (chords[i].hold_mask == 0 || (chords[i].hold_mask & chords[i].click_mask) != 0) {
+            ESP_LOGE(TAG, "Chord %d needs held buttons disjoint from clicked ones", i);
+            return ESP_ERR_INVALID_ARG;
+        }
     }
     
-    /* Initialize state and start the debounce timer */
-    btn->is_pressed = false;
-    btn->state = BUTTON_STATE_IDLE;
-    xTimerReset(btn->debounce_timer, 0);
+    button_group_t *grp = (button_group_t *)group;
     
-    ESP_LOGI(TAG, "Button created on GPIO %d, active %s", 
-             btn->gpio_num, btn->active_level ? "HIGH" : "LOW");
+    portENTER_CRITICAL(&grp->lock);
+    for (uint8_t i = 0; i < count; i++) {
+        grp->chords[i] = chords[i];
+        grp->chord_state[i] = (button_chord_state_t){ 0 };
+    }
+    grp->chord_count = count;
+    grp->chord_callback = callback;
+    grp->chord_ctx = user_ctx;
+    portEXIT_CRITICAL(&grp->lock);
     
-    return (button_handle_t)btn;
+    return ESP_OK;
 }
 
 /**
- * @brief Delete a button instance and clean up resources
+ * @brief Split the buttons of a group across engine shards
  * 
- * @param btn_handle Handle to the button instance
+ * @param group Handle to the group
+ * @param engines Engine handles, NULL to stop sharding
+ * @param count Number of engines
  * @return ESP_OK on success, ESP_ERR_INVALID_ARG otherwise
  */
-esp_err_t button_delete(button_handle_t btn_handle)
+esp_err_t button_group_set_shards(button_group_handle_t group, const button_engine_handle_t *engines, uint8_t count)
 {
-    CHECK_ARG(btn_handle);
-    
-    button_dev_t *btn = (button_dev_t *)btn_handle;
+    CHECK_ARG(group);
+    CHECK_ARG(count <= BUTTON_GROUP_MAX_SHARDS);
+    CHECK_ARG(engines != NULL || count == 0);
     
-    /* Remove ISR handler */
-    esp_err_t ret = gpio_isr_handler_remove(btn->gpio_num);
-    if (ret != ESP_OK) {
-        ESP_LOGW(TAG, "ISR handler removal failed: %d", ret);
-        /* Continue with cleanup anyway */
+    for (uint8_t i = 0; i < count; i++) {
+        CHECK_ARG(engines[i]);
     }
     
-    /* Delete timers */
-    if (btn->debounce_timer) {
-        xTimerStop(btn->debounce_timer, 0);
-        xTimerDelete(btn->debounce_timer, 0);
-    }
+    button_group_t *grp = (button_group_t *)group;
     
-    if (btn->long_press_timer) {
-        xTimerStop(btn->long_press_timer, 0);
-        xTimerDelete(btn->long_press_timer, 0);
+    portENTER_CRITICAL(&grp->lock);
+    for (uint8_t i = 0; i < count; i++) {
+        grp->shards[i] = (button_engine_t *)engines[i];
     }
+    grp->shard_count = count;
+    portEXIT_CRITICAL(&grp->lock);
     
-    if (btn->double_click_timer) {
-        xTimerStop(btn->double_click_timer, 0);
-        xTimerDelete(btn->double_click_timer, 0);
-    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Apply button_suspend() or button_resume() to every group member
+ */
+static esp_err_t button_group_for_each(button_group_t *group, esp_err_t (*fn)(button_handle_t))
+{
+    button_dev_t *members[BUTTON_GROUP_MAX_BUTTONS];
+    uint64_t mask;
     
-    /* Delete mutex */
-    if (btn->mutex) {
-        vSemaphoreDelete(btn->mutex);
+    portENTER_CRITICAL(&group->lock);
+    mask = group->member_mask;
+    for (uint64_t m = mask; m != 0; m &= m - 1) {
+        int i = __builtin_ctzll(m);
+        members[i] = group->members[i];
     }
+    portEXIT_CRITICAL(&group->lock);
     
-    /* Free memory */
-    free(btn);
+    esp_err_t ret = ESP_OK;
+    for (; mask != 0; mask &= mask - 1) {
+        esp_err_t err = fn((button_handle_t)members[__builtin_ctzll(mask)]);
+        if (ret == ESP_OK) {
+            ret = err;
+        }
+    }
     
-    return ESP_OK;
+    return ret;
 }
 
 /**
- * @brief Get current button state
+ * @brief Suspend every button of a group
  * 
- * @param btn_handle Handle to the button instance
- * @return Current button state
+ * @param group Group handle
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG or the first member error otherwise
  */
-button_state_t button_get_state(button_handle_t btn_handle)
+esp_err_t button_group_suspend(button_group_handle_t group)
 {
-    if (btn_handle == NULL) {
-        ESP_LOGW(TAG, "Null button handle in get_state");
-        return BUTTON_STATE_IDLE;
-    }
-    
-    button_dev_t *btn = (button_dev_t *)btn_handle;
-    button_state_t state = BUTTON_STATE_IDLE;
+    CHECK_ARG(group);
     
-    if (xSemaphoreTake(btn->mutex, portMAX_DELAY) == pdTRUE) {
-        state = btn->state;
-        xSemaphoreGive(btn->mutex);
-    } else {
-        ESP_LOGE(TAG, "Mutex error in get_state");
-    }
+    return button_group_for_each((button_group_t *)group, button_suspend);
+}
+
+/**
+ * @brief Resume every button of a group
+ * 
+ * @param group Group handle
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG or the first member error otherwise
+ */
+esp_err_t button_group_resume(button_group_handle_t group)
+{
+    CHECK_ARG(group);
     
-    return state;
+    return button_group_for_each((button_group_t *)group, button_resume);
 }
 
 /**
- * @brief Check if button is currently pressed
+ * @brief Get the bit index of a button in its group
  * 
  * @param btn_handle Handle to the button instance
- * @return true if button is pressed, false otherwise
+ * @return Bit index, or -1 if not in a group
  */
-bool button_is_pressed(button_handle_t btn_handle)
+int button_get_group_index(button_handle_t btn_handle)
 {
     if (btn_handle == NULL) {
-        ESP_LOGW(TAG, "Null button handle in is_pressed");
-        return false;
-    }
-    
-    button_dev_t *btn = (button_dev_t *)btn_handle;
-    bool is_pressed = false;
-    
-    if (xSemaphoreTake(btn->mutex, portMAX_DELAY) == pdTRUE) {
-        is_pressed = btn->is_pressed;
-        xSemaphoreGive(btn->mutex);
-    } else {
-        ESP_LOGE(TAG, "Mutex error in is_pressed");
+        ESP_LOGW(TAG, "Null button handle in get_group_index");
+        return -1;
     }
     
-    return is_pressed;
+    return ((button_dev_t *)btn_handle)->group_index;
 }
@@ -7,8 +7,13 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include "esp_err.h"
 #include "driver/gpio.h"
+#include "esp_event.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -33,9 +38,234 @@ typedef enum {
     BUTTON_EVENT_RELEASED,      /*!< Button released event */
     BUTTON_EVENT_CLICK,         /*!< Button single click detected */
     BUTTON_EVENT_LONG_PRESS,    /*!< Button long press detected */
-    BUTTON_EVENT_DOUBLE_CLICK   /*!< Button double click detected */
+    BUTTON_EVENT_DOUBLE_CLICK,  /*!< Button double click detected */
+    BUTTON_EVENT_HOLD_STAGE,    /*!< Button held past one of the configured hold stages */
+    BUTTON_EVENT_REPEAT,        /*!< Auto-repeat while the button is held */
+    BUTTON_EVENT_HOLD_PROGRESS, /*!< Periodic progress towards the long press threshold */
+    BUTTON_EVENT_CHORD,         /*!< Group chord detected (group chord callback only) */
+    BUTTON_EVENT_GESTURE,       /*!< One of the configured gestures was recognized */
+    BUTTON_EVENT_MAX            /*!< Number of event types */
 } button_event_t;
 
+/**
+ * @brief Bit for an event in an event mask
+ */
+#define BUTTON_EVENT_MASK(event)    (1UL << (event))
+
+/**
+ * @brief Event mask matching every event
+ */
+#define BUTTON_EVENT_MASK_ALL       0xFFFFFFFFUL
+
+/**
+ * @brief Maximum number of hold stages per button
+ */
+#define BUTTON_MAX_HOLD_STAGES  8
+
+/**
+ * @brief Maximum number of distinct stream buffers used as event sinks
+ */
+#define BUTTON_MAX_STREAM_SINKS 8
+
+/**
+ * @brief Maximum number of buttons in a group
+ */
+#define BUTTON_GROUP_MAX_BUTTONS    64
+
+/**
+ * @brief Maximum number of chords per group
+ */
+#define BUTTON_GROUP_MAX_CHORDS     16
+
+/**
+ * @brief Maximum number of buttons per engine
+ */
+#define BUTTON_ENGINE_MAX_BUTTONS   64
+
+/**
+ * @brief Maximum number of engine shards per group
+ */
+#define BUTTON_GROUP_MAX_SHARDS     4
+
+/**
+ * @brief Maximum number of gestures per button
+ */
+#define BUTTON_MAX_GESTURES         32
+
+/**
+ * @brief Maximum total number of tokens over all gestures of a button
+ */
+#define BUTTON_GESTURE_MAX_TOKENS   63
+
+/**
+ * @brief Button handle type
+ */
+typedef void* button_handle_t;
+
+/**
+ * @brief Button group handle type
+ */
+typedef void* button_group_handle_t;
+
+/**
+ * @brief Button engine handle type
+ */
+typedef void* button_engine_handle_t;
+
+/**
+ * @brief Extended event information
+ */
+typedef struct {
+    button_handle_t button;             /*!< Button that generated the event */
+    button_event_t event;               /*!< Event type */
+    uint8_t stage;                      /*!< Hold stage index (BUTTON_EVENT_HOLD_STAGE only) */
+    uint32_t hold_time_ms;              /*!< Time the button has been held, 0 if released */
+    uint32_t repeat_count;              /*!< Number of repeats so far in this hold, starting at 1 (BUTTON_EVENT_REPEAT only) */
+    uint32_t target_ms;                 /*!< Long press threshold being approached (BUTTON_EVENT_HOLD_PROGRESS only) */
+    uint8_t chord;                      /*!< Chord index in the group (BUTTON_EVENT_CHORD only) */
+    uint8_t gesture;                    /*!< Gesture index in button_config_t (BUTTON_EVENT_GESTURE only) */
+} button_event_info_t;
+
+/**
+ * @brief Event loop base for events posted to a BUTTON_SINK_EVENT_LOOP sink
+ */
+ESP_EVENT_DECLARE_BASE(BUTTON_LONGPRESS_EVENT);
+
+/**
+ * @brief Event sink types
+ */
+typedef enum {
+    BUTTON_SINK_NONE,           /*!< No sink */
+    BUTTON_SINK_QUEUE,          /*!< FreeRTOS queue with item size sizeof(button_event_info_t) */
+    BUTTON_SINK_STREAM_BUFFER,  /*!< Stream buffer receiving whole button_event_info_t records */
+    BUTTON_SINK_EVENT_LOOP      /*!< esp_event loop, posted as BUTTON_LONGPRESS_EVENT with the event type as id */
+} button_sink_type_t;
+
+/**
+ * @brief Event sink receiving a copy of every event
+ *
+ * Records are posted without blocking; when the sink is full the record is
+ * dropped and counted (see button_get_dropped_events()). Several buttons may
+ * share one sink.
+ *
+ * A stream buffer allows a single writer, so it must not have other writers
+ * and may only be shared by buttons dispatched from the same task: all on the
+ * timer service task, or all on the same engine. button_create() rejects a
+ * button that would write to it from another task.
+ */
+typedef struct {
+    button_sink_type_t type;            /*!< Sink type */
+    void *handle;                       /*!< QueueHandle_t, StreamBufferHandle_t or esp_event_loop_handle_t */
+} button_sink_t;
+
+/**
+ * @brief Events latched since the previous button_consume_events() call
+ */
+typedef struct {
+    uint32_t mask;                      /*!< BUTTON_EVENT_MASK() bits of every event that occurred */
+    uint32_t counts[BUTTON_EVENT_MAX];  /*!< Number of occurrences of each event */
+} button_events_t;
+
+/**
+ * @brief Extended event callback type
+ *
+ * @param info Event details, valid only for the duration of the call
+ * @param user_ctx User context from button_config_t
+ */
+typedef void (*button_event_cb_t)(const button_event_info_t *info, void *user_ctx);
+
+/**
+ * @brief Chord definition over the buttons of a group
+ *
+ * Masks use group bit indices (see button_get_group_index()).
+ *
+ * With click_mask == 0 this is a hold chord ("A+B held together"): it is
+ * reported once when every button of hold_mask is pressed and the last press
+ * came within window_ms of the first one.
+ *
+ * With click_mask != 0 this is a click chord ("hold A, click B"): it is
+ * reported when the click_mask buttons, pressed while every hold_mask button
+ * was held, are released again within window_ms.
+ */
+typedef struct {
+    uint64_t hold_mask;                 /*!< Buttons that must be held */
+    uint64_t click_mask;                /*!< Buttons clicked while hold_mask is held, 0 for a hold chord */
+    uint32_t window_ms;                 /*!< Simultaneity window (hold) or maximum click duration (click), 0: unlimited */
+    bool suppress;                      /*!< Suppress the member buttons' own events until each is released */
+} button_chord_t;
+
+/**
+ * @brief Gesture tokens produced by the button state machine
+ */
+typedef enum {
+    BUTTON_GESTURE_SHORT,       /*!< Press released before the long press threshold */
+    BUTTON_GESTURE_LONG,        /*!< Press reached the long press threshold */
+    BUTTON_GESTURE_GAP,         /*!< No press for double_click_time_ms after a release */
+    BUTTON_GESTURE_TOKEN_MAX    /*!< Number of token types */
+} button_gesture_token_t;
+
+/**
+ * @brief Gesture pattern
+ *
+ * A gesture is recognized when its tokens are the most recent ones produced
+ * by the button, e.g. {SHORT, SHORT, LONG}. The token stream starts with an
+ * implicit GAP, so a leading and trailing GAP anchor a pattern to a complete
+ * sequence: {GAP, SHORT, SHORT, GAP} matches exactly two short presses.
+ */
+typedef struct {
+    const button_gesture_token_t *tokens;   /*!< Token sequence */
+    uint8_t length;                         /*!< Number of tokens */
+} button_gesture_t;
+
+/**
+ * @brief Callback completing an asynchronous wait
+ *
+ * Runs in the dispatch context (the timer service task, or the engine task
+ * of the button that generated the event).
+ *
+ * @param info The matching event, or NULL if the wait timed out
+ * @param ctx Context passed to button_wait_event_async()
+ */
+typedef void (*button_wait_cb_t)(const button_event_info_t *info, void *ctx);
+
+/**
+ * @brief Waiter storage for button_wait_event() and button_wait_event_async()
+ *
+ * Fields are private to the component. Asynchronous waits keep it in the
+ * caller's storage until the callback has run or the wait was cancelled.
+ */
+typedef struct button_wait {
+    struct button_wait *next;           /*!< Next waiter in the list */
+    SemaphoreHandle_t signal;           /*!< Semaphore given on completion, NULL for a callback waiter */
+    button_wait_cb_t callback;          /*!< Completion callback of an asynchronous wait */
+    void *ctx;                          /*!< Context for callback */
+    const button_handle_t *handles;     /*!< Buttons of interest, NULL for any */
+    size_t count;                       /*!< Number of handles */
+    uint32_t event_mask;                /*!< Events of interest */
+    button_event_info_t *out;           /*!< Where a blocking wait stores the event */
+    TickType_t deadline;                /*!< Tick at which an asynchronous wait times out */
+    bool timed;                         /*!< Asynchronous wait has a deadline */
+    bool done;                          /*!< Wait has completed */
+} button_wait_t;
+
+/**
+ * @brief Configuration of a dedicated button engine task
+ */
+typedef struct {
+    UBaseType_t priority;               /*!< Task priority */
+    uint32_t stack_size;                /*!< Task stack size in bytes */
+    BaseType_t core_id;                 /*!< Core to pin the task to, or tskNO_AFFINITY */
+} button_engine_config_t;
+
+/**
+ * @brief Default engine configuration: priority 10, 4 KiB stack, no core affinity
+ */
+#define BUTTON_ENGINE_CONFIG_DEFAULT() { \
+    .priority = 10, \
+    .stack_size = 4096, \
+    .core_id = tskNO_AFFINITY, \
+}
+
 /**
  * @brief Button configuration structure
  */
@@ -46,12 +276,43 @@ typedef struct {
     uint32_t long_press_time_ms;        /*!< Time in milliseconds to detect a long press (default: 1000ms) */
     uint32_t double_click_time_ms;      /*!< Maximum time between clicks to detect a double click (default: 300ms) */
     void (*callback)(button_event_t);   /*!< Callback function for button events */
+    bool double_click_on_press;         /*!< Report double click when the second press is debounced instead of on its release */
+    const uint32_t *hold_stages_ms;     /*!< Strictly ascending hold thresholds, each reported as BUTTON_EVENT_HOLD_STAGE (optional, copied) */
+    uint8_t hold_stage_count;           /*!< Number of entries in hold_stages_ms (max BUTTON_MAX_HOLD_STAGES) */
+    button_event_cb_t event_callback;   /*!< Extended callback receiving event details (optional) */
+    void *user_ctx;                     /*!< User context passed to event_callback */
+    uint32_t repeat_interval_ms;        /*!< Initial auto-repeat interval, 0 disables auto-repeat */
+    uint32_t repeat_delay_ms;           /*!< Hold time before the first repeat (0: long_press_time_ms) */
+    uint32_t repeat_min_interval_ms;    /*!< Shortest interval reached by acceleration (0: repeat_interval_ms) */
+    uint8_t repeat_accel_percent;       /*!< Interval reduction in percent after each repeat (0: no acceleration) */
+    uint32_t hold_progress_interval_ms; /*!< Interval of BUTTON_EVENT_HOLD_PROGRESS until long press, 0 disables */
+    button_sink_t sink;                 /*!< Event sink receiving fixed-size event records (optional) */
+    button_group_handle_t group;        /*!< Group to join, the button gets the lowest free bit (optional) */
+    const button_gesture_t *gestures;   /*!< Gestures reported as BUTTON_EVENT_GESTURE, compiled at creation (optional) */
+    uint8_t gesture_count;              /*!< Number of gestures (max BUTTON_MAX_GESTURES) */
+    button_engine_handle_t engine;      /*!< Engine task running the button, NULL for the timer service task (optional) */
 } button_config_t;
 
 /**
- * @brief Button handle type
+ * @brief Install the GPIO interrupt used by all buttons
+ *
+ * Optional: the first button_create() otherwise installs it with default
+ * flags (ESP_INTR_FLAG_IRAM with CONFIG_BUTTON_LONGPRESS_ISR_IRAM, else 0).
+ * Call this before creating any button to choose the interrupt priority
+ * level or other allocation flags, e.g.
+ * ESP_INTR_FLAG_LEVEL3 | ESP_INTR_FLAG_IRAM.
+ *
+ * ESP_INTR_FLAG_IRAM requires CONFIG_BUTTON_LONGPRESS_ISR_IRAM, which keeps
+ * the whole ISR path and the data it reads in internal memory, so button
+ * edges are still captured while the flash cache is disabled (OTA writes,
+ * NVS commits).
+ *
+ * @param intr_alloc_flags ESP_INTR_FLAG_* allocation flags
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on unsupported flags,
+ *         ESP_ERR_INVALID_STATE if the interrupt is already installed,
+ *         or an error from the GPIO driver
  */
-typedef void* button_handle_t;
+esp_err_t button_isr_install(int intr_alloc_flags);
 
 /**
  * @brief Create and initialize a button
@@ -94,6 +355,304 @@ button_state_t button_get_state(button_handle_t btn_handle);
  */
 bool button_is_pressed(button_handle_t btn_handle);
 
+/**
+ * @brief Replace the extended event callback and its user context
+ *
+ * Events generated after the call returns are delivered to the new
+ * callback. An invocation of the previous callback already in progress on
+ * the dispatch task (timer service task or engine task) is waited for, so
+ * the previous user_ctx may be released once the call returns. Called from
+ * the dispatch task itself, e.g. from a callback, it does not wait.
+ *
+ * @param btn_handle Handle to the button instance
+ * @param event_callback New extended callback, or NULL to disable it
+ * @param user_ctx User context passed to event_callback
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if btn_handle is NULL, ESP_FAIL on mutex error
+ */
+esp_err_t button_set_event_callback(button_handle_t btn_handle, button_event_cb_t event_callback, void *user_ctx);
+
+/**
+ * @brief Replace the event callback
+ *
+ * Same semantics as button_set_event_callback() for the callback set in
+ * button_config_t::callback.
+ *
+ * @param btn_handle Handle to the button instance
+ * @param callback New callback, or NULL to disable it
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if btn_handle is NULL, ESP_FAIL on mutex error
+ */
+esp_err_t button_set_callback(button_handle_t btn_handle, void (*callback)(button_event_t));
+
+/**
+ * @brief Change the timings of a button in use
+ *
+ * The three timings are replaced together without recreating the button,
+ * so no edge is lost. Deadlines already running keep their period, except
+ * that a press in progress is held against the new long press time; the
+ * pin is resampled with the new debounce time.
+ *
+ * @param btn_handle Handle to the button instance
+ * @param debounce_time_ms Debounce time in milliseconds (0: 20ms)
+ * @param long_press_time_ms Long press time in milliseconds (0: 1000ms)
+ * @param double_click_time_ms Double click time in milliseconds (0: 300ms)
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if btn_handle is NULL, ESP_FAIL on mutex error
+ */
+esp_err_t button_set_timings(button_handle_t btn_handle, uint32_t debounce_time_ms,
+                             uint32_t long_press_time_ms, uint32_t double_click_time_ms);
+
+/**
+ * @brief Change the active level of a button in use
+ *
+ * Switches the internal pull resistor and resamples the pin, so a button
+ * that reads as pressed with the new level reports PRESSED.
+ *
+ * @param btn_handle Handle to the button instance
+ * @param active_level true: active high, false: active low
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if btn_handle is NULL, ESP_FAIL otherwise
+ */
+esp_err_t button_set_active_level(button_handle_t btn_handle, bool active_level);
+
+/**
+ * @brief Suspend a button, e.g. before light sleep
+ *
+ * Disables the pin interrupt and stops the pending deadlines without
+ * freeing anything or reconfiguring the GPIO, so no events are generated
+ * until button_resume(). The click state is kept.
+ *
+ * @param btn_handle Handle to the button instance
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if btn_handle is NULL, ESP_FAIL on mutex error
+ */
+esp_err_t button_suspend(button_handle_t btn_handle);
+
+/**
+ * @brief Resume a suspended button
+ *
+ * Re-arms the deadlines that were pending, counting the suspended time
+ * (a long press held through sleep is reported right away), resamples the
+ * pin so a press or release that happened meanwhile is reported, and
+ * re-enables the pin interrupt. Resuming a running button only resamples it.
+ *
+ * @param btn_handle Handle to the button instance
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if btn_handle is NULL, ESP_FAIL on mutex error
+ */
+esp_err_t button_resume(button_handle_t btn_handle);
+
+/**
+ * @brief Fetch and clear the events latched since the previous call
+ *
+ * Every event is latched into a per-button atomic pending mask and count,
+ * so a consumer polling at a low rate does not miss short-lived states such
+ * as clicks. The pending mask is fetched and cleared with a single atomic
+ * exchange and the counts of the pending events are then collected the same
+ * way; no lock is taken and the call never waits for the engine.
+ *
+ * With CONFIG_BUTTON_LONGPRESS_STATS disabled only the mask is reported
+ * and every count is 0.
+ *
+ * @param btn_handle Handle to the button instance
+ * @param out Filled with the latched events
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if an argument is NULL
+ */
+esp_err_t button_consume_events(button_handle_t btn_handle, button_events_t *out);
+
+/**
+ * @brief Get the number of event records dropped because the sink was full
+ *
+ * @param btn_handle Handle to the button instance
+ * @return Number of dropped records, 0 if btn_handle is NULL or CONFIG_BUTTON_LONGPRESS_STATS is disabled
+ */
+uint32_t button_get_dropped_events(button_handle_t btn_handle);
+
+/**
+ * @brief Block the calling task until one of the buttons reports an event
+ *
+ * The task sleeps on a binary semaphore in its own stack frame and is woken
+ * from the dispatch path as soon as a matching event is generated, so no
+ * state is polled and transient events are not missed while waiting. The
+ * task's notification values are not used. Events that occur while no task
+ * is waiting are not queued.
+ *
+ * Do not delete a button while a task is waiting on it.
+ *
+ * @param handles Buttons to wait on, or NULL to wait on every button
+ * @param count Number of entries in handles (ignored if handles is NULL)
+ * @param event_mask Events to wait for, built with BUTTON_EVENT_MASK() (0: any event)
+ * @param timeout Maximum time to wait in ticks, portMAX_DELAY to wait forever
+ * @param out Filled with the event that woke the task
+ * @return ESP_OK on event, ESP_ERR_TIMEOUT on timeout, ESP_ERR_INVALID_ARG on bad arguments
+ */
+esp_err_t button_wait_event(const button_handle_t *handles, size_t count, uint32_t event_mask,
+                            TickType_t timeout, button_event_info_t *out);
+
+/**
+ * @brief Wait for a button event without blocking the calling task
+ *
+ * Registers a waiter like button_wait_event(), but instead of waking a
+ * blocked task the callback is invoked exactly once from the dispatch path,
+ * with the matching event or with NULL when the timeout elapses. This is the
+ * hook for coroutine and state machine front-ends that must not park a task
+ * per flow. Timeouts of all asynchronous waits share one timer.
+ *
+ * @param wait Caller-owned storage, valid until the callback has run or
+ *             button_wait_event_cancel() returned true
+ * @param handles Buttons to wait on, or NULL to wait on every button (must stay valid as well)
+ * @param count Number of entries in handles (ignored if handles is NULL)
+ * @param event_mask Events to wait for, built with BUTTON_EVENT_MASK() (0: any event)
+ * @param timeout Maximum time to wait in ticks, portMAX_DELAY to wait forever
+ * @param callback Completion callback
+ * @param ctx Context passed to callback
+ * @return ESP_OK if registered, ESP_ERR_INVALID_ARG on bad arguments, ESP_ERR_NO_MEM if the timeout cannot be armed
+ */
+esp_err_t button_wait_event_async(button_wait_t *wait, const button_handle_t *handles, size_t count,
+                                  uint32_t event_mask, TickType_t timeout, button_wait_cb_t callback, void *ctx);
+
+/**
+ * @brief Cancel an asynchronous wait
+ *
+ * @param wait Storage passed to button_wait_event_async()
+ * @return true if the wait was removed and its callback will not run,
+ *         false if it has already completed (the callback has run or is running)
+ */
+bool button_wait_event_cancel(button_wait_t *wait);
+
+/**
+ * @brief Create an empty button group
+ *
+ * A group tracks the debounced pressed state of up to
+ * BUTTON_GROUP_MAX_BUTTONS buttons in one atomic bitmap.
+ *
+ * @return button_group_handle_t Handle to the group, or NULL if failed
+ */
+button_group_handle_t button_group_create(void);
+
+/**
+ * @brief Delete a button group
+ *
+ * @param group Handle to the group
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if group is NULL,
+ *         ESP_ERR_INVALID_STATE if buttons still belong to the group
+ */
+esp_err_t button_group_delete(button_group_handle_t group);
+
+/**
+ * @brief Get the debounced pressed state of every button in a group
+ *
+ * The bitmap is maintained by the engine on each debounced edge, so one
+ * load replaces a button_is_pressed() call per button and gives a
+ * consistent snapshot across buttons.
+ *
+ * @param group Handle to the group
+ * @return Bit n set if the button with group index n is pressed, 0 if group is NULL
+ */
+uint64_t button_group_get_pressed_mask(button_group_handle_t group);
+
+/**
+ * @brief Set the chords detected in a group
+ *
+ * Chords are evaluated by the engine on the group's debounced bitmap at
+ * every edge of a member button. A detected chord is reported to callback
+ * as BUTTON_EVENT_CHORD, with the button whose edge completed it, and to
+ * tasks in button_wait_event() waiting on that button.
+ *
+ * When a chord with suppress set is detected, the member buttons report only
+ * BUTTON_EVENT_PRESSED and BUTTON_EVENT_RELEASED until each is released, and
+ * that press does not count towards a click or double click.
+ *
+ * @param group Handle to the group
+ * @param chords Chord definitions, copied (NULL to remove all chords)
+ * @param count Number of chords (max BUTTON_GROUP_MAX_CHORDS)
+ * @param callback Callback for chord events
+ * @param user_ctx User context passed to callback
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on bad arguments
+ */
+esp_err_t button_group_set_chords(button_group_handle_t group, const button_chord_t *chords, uint8_t count,
+                                  button_event_cb_t callback, void *user_ctx);
+
+/**
+ * @brief Split the buttons of a group across engine shards
+ *
+ * Buttons created afterwards in this group without an engine of their own
+ * are placed on the shard currently running the fewest buttons. With one
+ * engine pinned to each core (see button_engine_create()), the debounce,
+ * hold and dispatch work of a large panel is spread over both cores, and
+ * shards share no task or mutex. They still meet on the group's short
+ * critical section for chord evaluation, and on the waiter list's while a
+ * task is in button_wait_event() or button_wait_event_async(). Buttons
+ * already in the group keep their runtime.
+ *
+ * The engines are not owned by the group and must outlive its buttons.
+ *
+ * @param group Handle to the group
+ * @param engines Engine handles, copied (NULL to stop sharding)
+ * @param count Number of engines (max BUTTON_GROUP_MAX_SHARDS)
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on bad arguments
+ */
+esp_err_t button_group_set_shards(button_group_handle_t group, const button_engine_handle_t *engines, uint8_t count);
+
+/**
+ * @brief Suspend every button of a group
+ *
+ * See button_suspend().
+ *
+ * @param group Handle to the group
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if group is NULL, otherwise the first member error
+ */
+esp_err_t button_group_suspend(button_group_handle_t group);
+
+/**
+ * @brief Resume every button of a group
+ *
+ * See button_resume().
+ *
+ * @param group Handle to the group
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if group is NULL, otherwise the first member error
+ */
+esp_err_t button_group_resume(button_group_handle_t group);
+
+/**
+ * @brief Get the bit index of a button in its group
+ *
+ * @param btn_handle Handle to the button instance
+ * @return Bit index in the group bitmap, or -1 if btn_handle is NULL or not in a group
+ */
+int button_get_group_index(button_handle_t btn_handle);
+
+/**
+ * @brief Create a dedicated engine task
+ *
+ * By default every button runs on the FreeRTOS timer service task, shared
+ * with all other software timers of the application. Buttons created with
+ * an engine in button_config_t are instead debounced, timed and dispatched
+ * by the engine's own task, created with xTaskCreatePinnedToCore(), so their
+ * latency is isolated from unrelated timer callbacks. Such buttons create no
+ * software timers; the task sleeps until the next deadline or GPIO edge.
+ * An engine runs up to BUTTON_ENGINE_MAX_BUTTONS buttons.
+ *
+ * Only the pending edges and deadlines are kept in per-engine arrays; the
+ * FSM state, pressed flag and configuration of each button stay in its
+ * button object, as on the timer service task. The arrays are
+ * reserved for BUTTON_ENGINE_MAX_BUTTONS buttons when the engine is created,
+ * about 1.1 KB on ESP32 plus the task stack, however few buttons it runs.
+ * Each engine button then costs its button object (about 210 bytes on ESP32)
+ * and a mutex, but no software timers.
+ *
+ * Callbacks of engine buttons run on the engine task and must not delete
+ * buttons of the same engine.
+ *
+ * @param config Engine configuration, see BUTTON_ENGINE_CONFIG_DEFAULT()
+ * @return button_engine_handle_t Handle to the engine, or NULL if failed
+ */
+button_engine_handle_t button_engine_create(const button_engine_config_t *config);
+
+/**
+ * @brief Stop and delete an engine task
+ *
+ * @param engine Handle to the engine
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if engine is NULL,
+ *         ESP_ERR_INVALID_STATE if buttons still run on the engine
+ */
+esp_err_t button_engine_delete(button_engine_handle_t engine);
+
 #ifdef __cplusplus
 }
 #endif
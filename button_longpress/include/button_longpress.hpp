@@ -0,0 +1,228 @@
+/**
+ * @file button_longpress.hpp
+ * @brief Header-only C++17 front-end for the button component
+ *
+ * Wraps button_create()/button_delete() in a move-only RAII type whose pin,
+ * active level and timings are template parameters checked at compile time.
+ * The event handler (lambda, functor or function) is stored by value inside
+ * the Button object, so there is no type erasure and no heap allocation; the
+ * C callback is a static trampoline in which the handler call is inlined.
+ * Handlers only need to be move-constructible: capturing lambdas, whose
+ * assignment operators are deleted, can be moved into and between Buttons.
+ *
+ * @code
+ * using Timing = button_longpress::Timings<20, 800, 250>;
+ *
+ * auto btn = button_longpress::make_button<GPIO_NUM_0, false, Timing>(
+ *     [&](button_longpress::ButtonEvent event) {
+ *         if (event == button_longpress::ButtonEvent::LongPress) {
+ *             led.toggle();
+ *         }
+ *     });
+ * if (!btn) {
+ *     // button_create() failed
+ * }
+ * @endcode
+ */
+
+#pragma once
+
+#if !defined(__cplusplus) || __cplusplus < 201703L
+#error "button_longpress.hpp requires C++17"
+#endif
+
+#include <cstdint>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include "button_longpress.h"
+
+namespace button_longpress {
+
+class EventAwaiter;
+
+/**
+ * @brief Button events
+ */
+enum class ButtonEvent : uint8_t {
+    Pressed = BUTTON_EVENT_PRESSED,
+    Released = BUTTON_EVENT_RELEASED,
+    Click = BUTTON_EVENT_CLICK,
+    LongPress = BUTTON_EVENT_LONG_PRESS,
+    DoubleClick = BUTTON_EVENT_DOUBLE_CLICK,
+    HoldStage = BUTTON_EVENT_HOLD_STAGE,
+    Repeat = BUTTON_EVENT_REPEAT,
+    HoldProgress = BUTTON_EVENT_HOLD_PROGRESS,
+    Chord = BUTTON_EVENT_CHORD,
+    Gesture = BUTTON_EVENT_GESTURE,
+};
+
+/**
+ * @brief Compile-time timing parameters
+ *
+ * @tparam DebounceMs Debounce time in milliseconds
+ * @tparam LongPressMs Time in milliseconds to detect a long press
+ * @tparam DoubleClickMs Maximum time between clicks to detect a double click
+ */
+template <uint32_t DebounceMs = 20, uint32_t LongPressMs = 1000, uint32_t DoubleClickMs = 300>
+struct Timings {
+    static_assert(DebounceMs > 0, "Debounce time must be non-zero");
+    static_assert(LongPressMs > DebounceMs, "Long press time must exceed the debounce time");
+    static_assert(DoubleClickMs > DebounceMs, "Double click time must exceed the debounce time");
+
+    static constexpr uint32_t debounce_ms = DebounceMs;
+    static constexpr uint32_t long_press_ms = LongPressMs;
+    static constexpr uint32_t double_click_ms = DoubleClickMs;
+};
+
+/**
+ * @brief RAII button with compile-time configuration
+ *
+ * The handler is invoked from the component's dispatch path with either a
+ * ButtonEvent or a const button_event_info_t&, whichever it accepts.
+ *
+ * Button is move-only. Events are dispatched on the timer service task or
+ * the button's engine task, so a move first detaches the C callback from
+ * the source with button_set_event_callback(), which waits for a handler
+ * call in progress to return; only then is the handler moved and the
+ * callback re-targeted to the new object. Events generated during the move
+ * are not delivered. Do not move a Button from inside its own handler,
+ * where that wait cannot happen.
+ *
+ * @tparam Gpio GPIO number
+ * @tparam ActiveLevel true: active high, false: active low
+ * @tparam Timing Timings<> instantiation
+ * @tparam Handler Event handler type
+ */
+template <gpio_num_t Gpio, bool ActiveLevel, typename Timing, typename Handler>
+class Button {
+    static_assert(Gpio >= 0 && Gpio < GPIO_NUM_MAX, "Invalid GPIO number");
+    static_assert(std::is_invocable_v<Handler &, ButtonEvent> ||
+                  std::is_invocable_v<Handler &, const button_event_info_t &>,
+                  "Handler must accept ButtonEvent or const button_event_info_t&");
+    static_assert(std::is_move_constructible_v<Handler>, "Handler must be move-constructible");
+
+public:
+    /**
+     * @brief Create the button
+     *
+     * @param handler Event handler, stored by value
+     * @param base Remaining configuration (hold stages, repeat, group, ...);
+     *             pin, level, timings and the extended callback are overridden
+     */
+    explicit Button(Handler handler, button_config_t base = {}) : handler_(std::in_place, std::move(handler))
+    {
+        base.gpio_num = Gpio;
+        base.active_level = ActiveLevel;
+        base.debounce_time_ms = Timing::debounce_ms;
+        base.long_press_time_ms = Timing::long_press_ms;
+        base.double_click_time_ms = Timing::double_click_ms;
+        base.event_callback = &Button::dispatch;
+        base.user_ctx = this;
+        handle_ = button_create(&base);
+    }
+
+    ~Button()
+    {
+        if (handle_ != nullptr) {
+            button_delete(handle_);
+        }
+    }
+
+    Button(const Button &) = delete;
+    Button &operator=(const Button &) = delete;
+
+    Button(Button &&other) noexcept : handler_(std::in_place, std::move(detach(other))), handle_(other.handle_)
+    {
+        other.handle_ = nullptr;
+        retarget();
+    }
+
+    Button &operator=(Button &&other) noexcept
+    {
+        if (this != &other) {
+            if (handle_ != nullptr) {
+                detach(*this);
+                button_delete(handle_);
+            }
+            /* Re-construct rather than assign: a capturing lambda is not assignable */
+            handler_.emplace(std::move(detach(other)));
+            handle_ = other.handle_;
+            other.handle_ = nullptr;
+            retarget();
+        }
+        return *this;
+    }
+
+    /** @brief true if button_create() succeeded */
+    explicit operator bool() const noexcept { return handle_ != nullptr; }
+
+    /** @brief Underlying C handle for the rest of the C API */
+    button_handle_t handle() const noexcept { return handle_; }
+
+    /** @brief See button_get_state() */
+    button_state_t state() const { return button_get_state(handle_); }
+
+    /** @brief See button_is_pressed() */
+    bool is_pressed() const { return button_is_pressed(handle_); }
+
+#if __cplusplus >= 202002L
+    /**
+     * @brief Await the next event, defined in button_longpress_coro.hpp
+     *
+     * @code
+     * auto ev = co_await btn.next(ButtonEvent::LongPress, pdMS_TO_TICKS(5000));
+     * @endcode
+     */
+    EventAwaiter next(ButtonEvent event, TickType_t timeout = portMAX_DELAY) const noexcept;
+#endif
+
+    static constexpr gpio_num_t gpio = Gpio;
+    static constexpr bool active_level = ActiveLevel;
+    using timing = Timing;
+
+private:
+    static void dispatch(const button_event_info_t *info, void *user_ctx)
+    {
+        Handler &handler = *static_cast<Button *>(user_ctx)->handler_;
+        if constexpr (std::is_invocable_v<Handler &, const button_event_info_t &>) {
+            handler(*info);
+        } else {
+            handler(static_cast<ButtonEvent>(info->event));
+        }
+    }
+
+    /* Stop dispatching to b, waiting for a handler call in progress, and return its handler */
+    static Handler &detach(Button &b) noexcept
+    {
+        if (b.handle_ != nullptr) {
+            button_set_event_callback(b.handle_, nullptr, nullptr);
+        }
+        return *b.handler_;
+    }
+
+    void retarget()
+    {
+        if (handle_ != nullptr) {
+            button_set_event_callback(handle_, &Button::dispatch, this);
+        }
+    }
+
+    std::optional<Handler> handler_;    /* Always engaged, optional only for emplace() */
+    button_handle_t handle_ = nullptr;
+};
+
+/**
+ * @brief Create a Button, deducing the handler type
+ *
+ * @code
+ * auto btn = make_button<GPIO_NUM_4, true>([](ButtonEvent e) { ... });
+ * @endcode
+ */
+template <gpio_num_t Gpio, bool ActiveLevel, typename Timing = Timings<>, typename Handler>
+Button<Gpio, ActiveLevel, Timing, std::decay_t<Handler>> make_button(Handler &&handler, const button_config_t &base = {})
+{
+    return Button<Gpio, ActiveLevel, Timing, std::decay_t<Handler>>(std::forward<Handler>(handler), base);
+}
+
+} // namespace button_longpress
@@ -0,0 +1,150 @@
+/**
+ * @file button_longpress_coro.hpp
+ * @brief C++20 coroutine front-end: co_await the next button event
+ *
+ * The awaiter registers a button_wait_event_async() waiter that lives in the
+ * coroutine frame and resumes the coroutine directly from the dispatch path,
+ * so UI flows need neither a task of their own nor a polling loop.
+ *
+ * @code
+ * template <typename B>
+ * button_longpress::Flow unlock_flow(B &btn)
+ * {
+ *     using button_longpress::ButtonEvent;
+ *
+ *     for (;;) {
+ *         co_await btn.next(ButtonEvent::LongPress);
+ *         auto confirm = co_await btn.next(ButtonEvent::DoubleClick, pdMS_TO_TICKS(2000));
+ *         if (confirm) {
+ *             unlock();
+ *         }
+ *     }
+ * }
+ * @endcode
+ *
+ * Coroutines resumed by a button event continue on the task that dispatches
+ * the button's events (the timer service task, or the button's engine task),
+ * like every other button callback, and must not block it.
+ */
+
+#pragma once
+
+#if !defined(__cplusplus) || __cplusplus < 202002L
+#error "button_longpress_coro.hpp requires C++20"
+#endif
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include "button_longpress.hpp"
+
+namespace button_longpress {
+
+/**
+ * @brief Awaitable for the next matching event of a button
+ *
+ * co_await yields std::optional<button_event_info_t>, empty on timeout or
+ * if the wait could not be registered. Destroying a suspended coroutine
+ * cancels its wait.
+ */
+class EventAwaiter {
+public:
+    EventAwaiter(button_handle_t button, uint32_t event_mask, TickType_t timeout) noexcept
+        : button_(button), event_mask_(event_mask), timeout_(timeout)
+    {
+    }
+
+    EventAwaiter(const EventAwaiter &) = delete;
+    EventAwaiter &operator=(const EventAwaiter &) = delete;
+
+    ~EventAwaiter()
+    {
+        if (suspended_) {
+            button_wait_event_cancel(&wait_);
+        }
+    }
+
+    bool await_ready() const noexcept { return false; }
+
+    bool await_suspend(std::coroutine_handle<> coroutine) noexcept
+    {
+        coroutine_ = coroutine;
+        suspended_ = true;
+        if (button_wait_event_async(&wait_, &button_, 1, event_mask_, timeout_, &EventAwaiter::complete, this) != ESP_OK) {
+            suspended_ = false;
+            return false;
+        }
+        /* The coroutine may already be running again, do not touch *this */
+        return true;
+    }
+
+    std::optional<button_event_info_t> await_resume() const noexcept { return result_; }
+
+private:
+    static void complete(const button_event_info_t *info, void *ctx)
+    {
+        EventAwaiter *self = static_cast<EventAwaiter *>(ctx);
+        if (info != nullptr) {
+            self->result_ = *info;
+        }
+        self->suspended_ = false;
+        self->coroutine_.resume();
+    }
+
+    button_handle_t button_;
+    uint32_t event_mask_;
+    TickType_t timeout_;
+    button_wait_t wait_ = {};
+    std::coroutine_handle<> coroutine_;
+    std::optional<button_event_info_t> result_;
+    bool suspended_ = false;
+};
+
+/**
+ * @brief Await the next event of a button
+ *
+ * @param button Button handle
+ * @param event Event to wait for
+ * @param timeout Maximum time to wait in ticks, portMAX_DELAY to wait forever
+ */
+inline EventAwaiter next(button_handle_t button, ButtonEvent event, TickType_t timeout = portMAX_DELAY) noexcept
+{
+    return EventAwaiter(button, BUTTON_EVENT_MASK(static_cast<uint32_t>(event)), timeout);
+}
+
+/**
+ * @brief Await the next event of a button among several
+ *
+ * @param button Button handle
+ * @param event_mask Events built with BUTTON_EVENT_MASK() (0: any event)
+ * @param timeout Maximum time to wait in ticks, portMAX_DELAY to wait forever
+ */
+inline EventAwaiter next(button_handle_t button, uint32_t event_mask, TickType_t timeout = portMAX_DELAY) noexcept
+{
+    return EventAwaiter(button, event_mask, timeout);
+}
+
+template <gpio_num_t Gpio, bool ActiveLevel, typename Timing, typename Handler>
+EventAwaiter Button<Gpio, ActiveLevel, Timing, Handler>::next(ButtonEvent event, TickType_t timeout) const noexcept
+{
+    return button_longpress::next(handle_, event, timeout);
+}
+
+/**
+ * @brief Fire-and-forget coroutine type for button flows
+ *
+ * The coroutine starts running immediately and its frame is freed when it
+ * returns. Only the frame itself is allocated, no task is created. An
+ * exception escaping the flow has nobody to report to and terminates.
+ */
+struct Flow {
+    struct promise_type {
+        Flow get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        [[noreturn]] void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+} // namespace button_longpress
@@ -0,0 +1,57 @@
+/**
+ * @file button_gesture.h
+ * @brief Gesture recognizer compiled into a deterministic transition table
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "button_longpress.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Compiled gesture recognizer
+ *
+ * Every state has one transition per token, so matching costs a single
+ * table lookup per token however many gestures are registered.
+ */
+typedef struct {
+    uint8_t state;                                  /*!< Current state */
+    uint8_t state_count;                            /*!< Number of states */
+    uint8_t (*next)[BUTTON_GESTURE_TOKEN_MAX];      /*!< Transition table indexed by state and token */
+    uint32_t *accept;                               /*!< Gestures completed on entering each state */
+} button_gesture_dfa_t;
+
+/**
+ * @brief Compile gesture patterns into a transition table
+ *
+ * @param gestures Gesture patterns
+ * @param count Number of gestures (max BUTTON_MAX_GESTURES)
+ * @param out Receives the compiled recognizer
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on bad patterns, ESP_ERR_NO_MEM on allocation failure
+ */
+esp_err_t button_gesture_compile(const button_gesture_t *gestures, uint8_t count, button_gesture_dfa_t **out);
+
+/**
+ * @brief Feed one token to the recognizer
+ *
+ * @param dfa Compiled recognizer
+ * @param token Token produced by the button
+ * @return Bitmask of gestures completed by this token
+ */
+uint32_t button_gesture_feed(button_gesture_dfa_t *dfa, button_gesture_token_t token);
+
+/**
+ * @brief Free a compiled recognizer
+ *
+ * @param dfa Compiled recognizer, may be NULL
+ */
+void button_gesture_free(button_gesture_dfa_t *dfa);
+
+#ifdef __cplusplus
+}
+#endif
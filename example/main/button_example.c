@@ -58,13 +58,15 @@ void app_main(void)
     
     // Main loop
     while (1) {
-        vTaskDelay(pdMS_TO_TICKS(100));
-        
-        // You can also check button state programmatically
-        button_state_t state = button_get_state(btn_handle);
-        if (state == BUTTON_STATE_SHORT_PRESS) {
+        // You can also block on button events instead of polling the state
+        button_event_info_t info;
+        esp_err_t ret = button_wait_event(&btn_handle, 1,
+                                          BUTTON_EVENT_MASK(BUTTON_EVENT_CLICK) |
+                                          BUTTON_EVENT_MASK(BUTTON_EVENT_DOUBLE_CLICK),
+                                          portMAX_DELAY, &info);
+        if (ret == ESP_OK && info.event == BUTTON_EVENT_CLICK) {
             // Additional actions for short press if needed
-            ESP_LOGI(TAG, "Short press detected programmatically");
+            ESP_LOGI(TAG, "Short press received by waiting task");
         }
     }
     
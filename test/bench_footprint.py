@@ -0,0 +1,111 @@
+#!/usr/bin/env python3
+"""
+Memory footprint benchmark for the button component (host build)
+
+Creates 1..N buttons and reports the kernel objects they hold and the peak
+timer service queue demand during a bounce storm. Every result is printed as
+one "BENCH {json}" line, the same format as the on-target app in benchmark/,
+so CI can diff the numbers across commits.
+
+Heap bytes are only meaningful on target; the host build models the timer
+queue as the commands posted between two runs of the timer service task.
+
+Usage:
+    python3 bench_footprint.py [--max-buttons N] [--edges E] [--json FILE]
+"""
+import argparse
+import ctypes
+import json
+import os
+import sys
+
+sys.path.insert(0, os.path.dirname(__file__))
+
+from conftest import esp, gpio, freertos, ButtonConfig, reset_all_mocks
+import button_longpress
+
+
+def reset_component():
+    """Reset the mock environment and the component state"""
+    reset_all_mocks()
+    button_longpress.button_instances = {}
+    button_longpress.next_button_id = 1
+    button_longpress.group_instances = {}
+    button_longpress.next_group_id = 1
+    button_longpress.waiters = []
+    button_longpress.wait_timer = None
+    button_longpress.pm_lock = None
+    button_longpress.stream_sinks = {}
+
+
+def measure(buttons, edges):
+    """Measure one configuration of `buttons` buttons"""
+    reset_component()
+    base_objects = freertos.kernel_objects()
+
+    handles = []
+    for gpio_num in range(buttons):
+        config = ButtonConfig(
+            gpio_num=gpio_num,
+            active_level=True,
+            debounce_time_ms=20,
+            long_press_time_ms=1000,
+            double_click_time_ms=300,
+        )
+        handle = button_longpress.button_create(ctypes.byref(config))
+        if handle is None:
+            raise RuntimeError(f"button_create failed for GPIO {gpio_num}")
+        handles.append(handle)
+
+    kernel_objects = freertos.kernel_objects() - base_objects
+
+    # All pins bounce at once, faster than the timer service task can run
+    freertos.advance_time(0)
+    freertos.timer_queue_peak = 0
+    for edge in range(edges):
+        for gpio_num in range(buttons):
+            gpio.gpio_set_level(gpio_num, (edge + 1) % 2)
+    timer_queue_peak = freertos.timer_queue_peak
+
+    freertos.advance_time(2000)
+    for handle in handles:
+        button_longpress.button_delete(handle)
+
+    return {
+        "bench": "footprint",
+        "target": "host",
+        "runtime": "timer_service",
+        "buttons": buttons,
+        "kernel_objects": kernel_objects,
+        "kernel_objects_per_button": kernel_objects / buttons,
+        "timer_queue_peak": timer_queue_peak,
+    }
+
+
+def run(max_buttons, edges):
+    """Measure 1..max_buttons buttons"""
+    return [measure(n, edges) for n in range(1, max_buttons + 1)]
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    parser.add_argument("--max-buttons", type=int, default=16)
+    parser.add_argument("--edges", type=int, default=20)
+    parser.add_argument("--json", help="Also write the results to this file")
+    args = parser.parse_args(argv)
+
+    if not 1 <= args.max_buttons <= esp.GPIO_NUM_MAX:
+        parser.error(f"--max-buttons must be within 1..{esp.GPIO_NUM_MAX}")
+
+    results = run(args.max_buttons, args.edges)
+    for result in results:
+        print("BENCH " + json.dumps(result, sort_keys=True))
+
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump(results, f, indent=2, sort_keys=True)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,166 @@
+#!/usr/bin/env python3
+"""
+Kernel call cost model for the button component (host build)
+
+Compiles the real button_longpress.c for the host against the counting
+kernel in host/host_rtos.c (see host_build.py), runs scripted interactions
+on one button and counts every FreeRTOS primitive the C code invokes from
+the first edge until the button is idle again. Button creation is not
+counted, only the hot path. The counts are those of the default Kconfig
+configuration with the timer service task runtime; engines need a real
+scheduler and are not covered.
+
+The counts are compared against rtos_calls_baseline.json by
+test_button_rtos_calls.py, which fails when an interaction needs more kernel
+calls than recorded. After an intended change, re-record the baseline with
+--record and commit it together with the change.
+
+Usage:
+    python3 bench_rtos_calls.py [--record]
+"""
+import argparse
+import ctypes
+import functools
+import json
+import os
+import sys
+
+sys.path.insert(0, os.path.dirname(__file__))
+
+from conftest import ButtonConfig
+import host_build
+
+BASELINE_PATH = os.path.join(os.path.dirname(os.path.abspath(__file__)), "rtos_calls_baseline.json")
+
+# Primitives of the hot path
+PRIMITIVES = (
+    "xTimerStart",
+    "xTimerStop",
+    "xTimerReset",
+    "xTimerResetFromISR",
+    "xTimerChangePeriod",
+    "xTimerPendFunctionCall",
+    "xSemaphoreTake",
+    "xSemaphoreGive",
+)
+
+GPIO_NUM = 4
+
+
+@functools.lru_cache(maxsize=None)
+def component():
+    """The component and host kernel, built and loaded once"""
+    lib = ctypes.CDLL(host_build.build_library())
+    lib.button_create.argtypes = [ctypes.POINTER(ButtonConfig)]
+    lib.button_create.restype = ctypes.c_void_p
+    lib.button_delete.argtypes = [ctypes.c_void_p]
+    lib.host_gpio_set_level.argtypes = [ctypes.c_int, ctypes.c_int]
+    lib.host_advance_ms.argtypes = [ctypes.c_uint32]
+    lib.host_calls.argtypes = [ctypes.c_char_p]
+    lib.host_calls.restype = ctypes.c_uint32
+    return lib
+
+
+def set_level(pin, level):
+    component().host_gpio_set_level(pin, level)
+
+
+def advance(ms):
+    component().host_advance_ms(ms)
+
+
+def click(pin):
+    set_level(pin, 1)
+    advance(50)
+    set_level(pin, 0)
+
+
+def double_click(pin):
+    click(pin)
+    advance(100)
+    click(pin)
+
+
+def long_press(pin):
+    set_level(pin, 1)
+    advance(1200)
+    set_level(pin, 0)
+
+
+def bounce(pin, edges=20):
+    # Edges faster than the debounce time, ending at the released level
+    for edge in range(edges):
+        set_level(pin, (edge + 1) % 2)
+        advance(1)
+
+
+INTERACTIONS = {
+    "click": click,
+    "double_click": double_click,
+    "long_press": long_press,
+    "bounce_20": bounce,
+}
+
+
+def measure(name):
+    """Kernel calls of one interaction on a fresh button"""
+    lib = component()
+    config = ButtonConfig(
+        gpio_num=GPIO_NUM,
+        active_level=True,
+        debounce_time_ms=20,
+        long_press_time_ms=1000,
+        double_click_time_ms=300,
+    )
+    handle = lib.button_create(ctypes.byref(config))
+    if not handle:
+        raise RuntimeError("button_create failed")
+    # Let the initial pin sample settle
+    advance(100)
+
+    lib.host_calls_clear()
+    INTERACTIONS[name](GPIO_NUM)
+    # Let every pending deadline expire
+    advance(2000)
+    calls = {primitive: lib.host_calls(primitive.encode()) for primitive in PRIMITIVES}
+
+    if lib.host_mutexes_held() != 0:
+        raise RuntimeError(f"{name}: button mutex left held")
+    lib.button_delete(handle)
+    advance(10)
+    return calls
+
+
+def run():
+    """Kernel calls of every interaction"""
+    return {name: measure(name) for name in INTERACTIONS}
+
+
+def load_baseline():
+    with open(BASELINE_PATH) as f:
+        return json.load(f)
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    parser.add_argument("--record", action="store_true", help=f"Write the counts to {os.path.basename(BASELINE_PATH)}")
+    args = parser.parse_args(argv)
+
+    reason = host_build.unavailable()
+    if reason is not None:
+        print(f"host build unavailable: {reason}", file=sys.stderr)
+        return 1
+
+    results = run()
+    for name, calls in results.items():
+        print("BENCH " + json.dumps({"bench": "rtos_calls", "interaction": name, **calls}, sort_keys=True))
+
+    if args.record:
+        with open(BASELINE_PATH, "w") as f:
+            json.dump(results, f, indent=2, sort_keys=True)
+            f.write("\n")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -1,22 +1,165 @@
 """
 Mock implementation of button_longpress module for testing
 """
+import contextlib
 import ctypes
 
 # Import mock objects from conftest
 try:
-    from conftest import esp, gpio, freertos
+    from conftest import esp, gpio, freertos, pm, events, ButtonEventInfo, ButtonWait, BUTTON_EVENT_CALLBACK, BUTTON_WAIT_CALLBACK
 except ImportError:
     # Fallback for direct execution
     import sys
     import os
     sys.path.insert(0, os.path.dirname(__file__))
-    from conftest import esp, gpio, freertos
+    from conftest import esp, gpio, freertos, pm, events, ButtonEventInfo, ButtonWait, BUTTON_EVENT_CALLBACK, BUTTON_WAIT_CALLBACK
 
 # Global state for button instances
 button_instances = {}
 next_button_id = 1
 
+# Asynchronous waiters and the timer for their nearest deadline
+waiters = []
+wait_timer = None
+
+# Global state for button groups
+group_instances = {}
+next_group_id = 1
+
+# No-light-sleep lock, referenced once by each button with a pending deadline
+pm_lock = None
+
+# Stream buffer sinks: handle -> [writer engine, number of buttons]
+stream_sinks = {}
+
+class GroupInstance:
+    """Internal button group representation"""
+    def __init__(self):
+        self.pressed_mask = 0
+        self.suppress_mask = 0
+        self.member_mask = 0
+        self.chords = []
+        self.chord_state = []
+        self.chord_callback = None
+        self.chord_ctx = None
+
+class GestureDFA:
+    """Gesture recognizer compiled into a deterministic transition table"""
+    def __init__(self, patterns):
+        # Build the trie, state 0 is the root
+        self.next = [[None] * esp.BUTTON_GESTURE_TOKEN_MAX]
+        self.accept = [0]
+        for g, pattern in enumerate(patterns):
+            state = 0
+            for token in pattern:
+                if self.next[state][token] is None:
+                    self.next.append([None] * esp.BUTTON_GESTURE_TOKEN_MAX)
+                    self.accept.append(0)
+                    self.next[state][token] = len(self.next) - 1
+                state = self.next[state][token]
+            self.accept[state] |= 1 << g
+        
+        # Breadth-first pass: failure links and missing transitions
+        fail = [0] * len(self.next)
+        queue = []
+        for token in range(esp.BUTTON_GESTURE_TOKEN_MAX):
+            child = self.next[0][token]
+            if child is None:
+                self.next[0][token] = 0
+            else:
+                fail[child] = 0
+                queue.append(child)
+        
+        while queue:
+            state = queue.pop(0)
+            self.accept[state] |= self.accept[fail[state]]
+            for token in range(esp.BUTTON_GESTURE_TOKEN_MAX):
+                child = self.next[state][token]
+                if child is None:
+                    self.next[state][token] = self.next[fail[state]][token]
+                else:
+                    fail[child] = self.next[fail[state]][token]
+                    queue.append(child)
+        
+        # The stream starts after an implicit gap
+        self.state = self.next[0][esp.BUTTON_GESTURE_GAP]
+    
+    def feed(self, token):
+        """Feed one token, returns the bitmask of completed gestures"""
+        self.state = self.next[self.state][token]
+        return self.accept[self.state]
+
+def gesture_compile(config):
+    """Validate and compile the gestures of a configuration"""
+    if config.gesture_count == 0:
+        return None
+    if config.gesture_count > esp.BUTTON_MAX_GESTURES or not config.gestures:
+        raise ValueError("invalid gesture count")
+    
+    patterns = []
+    for g in range(config.gesture_count):
+        gesture = config.gestures[g]
+        if gesture.length == 0 or not gesture.tokens:
+            raise ValueError(f"gesture {g} is empty")
+        pattern = [gesture.tokens[i] for i in range(gesture.length)]
+        if any(token < 0 or token >= esp.BUTTON_GESTURE_TOKEN_MAX for token in pattern):
+            raise ValueError(f"gesture {g} has an invalid token")
+        patterns.append(pattern)
+    
+    if sum(len(p) for p in patterns) > esp.BUTTON_GESTURE_MAX_TOKENS:
+        raise ValueError("too many gesture tokens")
+    
+    return GestureDFA(patterns)
+
+# Click state machine states, finer grained than the public button state
+FSM_IDLE, FSM_DOWN, FSM_WAIT, FSM_DOWN2, FSM_DOUBLE_DOWN, FSM_DOUBLE, FSM_HELD, FSM_LONG = range(8)
+
+# Click state machine inputs
+(INPUT_PRESS, INPUT_PRESS_DC, INPUT_RELEASE, INPUT_CANCEL,
+ INPUT_LONG, INPUT_REPEAT, INPUT_TIMEOUT) = range(7)
+
+# Transition actions, executed in the order listed
+ACT_WINDOW_START = 1 << 0
+ACT_WINDOW_STOP = 1 << 1
+ACT_GAP_ARM = 1 << 2
+ACT_GAP_STOP = 1 << 3
+ACT_UNSUPPRESS = 1 << 4
+ACT_FEED_SHORT = 1 << 5
+ACT_EMIT_CLICK = 1 << 6
+ACT_EMIT_DOUBLE = 1 << 7
+ACT_EMIT_LONG = 1 << 8
+ACT_FEED_LONG = 1 << 9
+ACT_FEED_GAP = 1 << 10
+
+ACT_RELEASE_END = ACT_FEED_SHORT | ACT_GAP_ARM
+ACT_CANCEL = ACT_UNSUPPRESS | ACT_GAP_ARM
+ACT_LONG = ACT_EMIT_LONG | ACT_FEED_LONG
+
+# Transition table [state][input] -> (next state, actions)
+FSM_TABLE = {
+    #                  PRESS                       PRESS_DC                                        RELEASE                                       CANCEL                    LONG                   REPEAT                TIMEOUT
+    FSM_IDLE:        [(FSM_DOWN, ACT_GAP_STOP),    (FSM_DOWN, ACT_GAP_STOP),                       (FSM_IDLE, 0),                                (FSM_IDLE, 0),            (FSM_IDLE, 0),         (FSM_IDLE, 0),        (FSM_IDLE, ACT_FEED_GAP)],
+    FSM_DOWN:        [(FSM_DOWN, 0),               (FSM_DOWN, 0),                                  (FSM_WAIT, ACT_FEED_SHORT | ACT_WINDOW_START), (FSM_IDLE, ACT_CANCEL),   (FSM_LONG, ACT_LONG),  (FSM_HELD, 0),        (FSM_DOWN, 0)],
+    FSM_WAIT:        [(FSM_DOWN2, ACT_WINDOW_STOP), (FSM_DOUBLE_DOWN, ACT_WINDOW_STOP | ACT_EMIT_DOUBLE), (FSM_WAIT, 0),                           (FSM_WAIT, 0),            (FSM_WAIT, 0),         (FSM_WAIT, 0),        (FSM_IDLE, ACT_EMIT_CLICK | ACT_FEED_GAP)],
+    FSM_DOWN2:       [(FSM_DOWN2, 0),              (FSM_DOWN2, 0),                                 (FSM_DOUBLE, ACT_RELEASE_END | ACT_EMIT_DOUBLE), (FSM_IDLE, ACT_CANCEL), (FSM_LONG, ACT_LONG),  (FSM_HELD, 0),        (FSM_DOWN2, 0)],
+    FSM_DOUBLE_DOWN: [(FSM_DOUBLE_DOWN, 0),        (FSM_DOUBLE_DOWN, 0),                           (FSM_DOUBLE, ACT_RELEASE_END),                (FSM_IDLE, ACT_CANCEL),   (FSM_LONG, ACT_LONG),  (FSM_DOUBLE_DOWN, 0), (FSM_DOUBLE_DOWN, 0)],
+    FSM_DOUBLE:      [(FSM_DOWN, ACT_GAP_STOP),    (FSM_DOWN, ACT_GAP_STOP),                       (FSM_DOUBLE, 0),                              (FSM_DOUBLE, 0),          (FSM_DOUBLE, 0),       (FSM_DOUBLE, 0),      (FSM_DOUBLE, ACT_FEED_GAP)],
+    FSM_HELD:        [(FSM_HELD, 0),               (FSM_HELD, 0),                                  (FSM_IDLE, ACT_RELEASE_END),                  (FSM_IDLE, ACT_CANCEL),   (FSM_LONG, ACT_LONG),  (FSM_HELD, 0),        (FSM_HELD, 0)],
+    FSM_LONG:        [(FSM_LONG, 0),               (FSM_LONG, 0),                                  (FSM_IDLE, ACT_GAP_ARM),                      (FSM_IDLE, ACT_CANCEL),   (FSM_LONG, 0),         (FSM_LONG, 0),        (FSM_LONG, 0)],
+}
+
+# Public state reported for each state machine state
+FSM_PUBLIC_STATE = {
+    FSM_IDLE: esp.BUTTON_STATE_IDLE,
+    FSM_DOWN: esp.BUTTON_STATE_PRESSED,
+    FSM_WAIT: esp.BUTTON_STATE_IDLE,
+    FSM_DOWN2: esp.BUTTON_STATE_PRESSED,
+    FSM_DOUBLE_DOWN: esp.BUTTON_STATE_DOUBLE_CLICK,
+    FSM_DOUBLE: esp.BUTTON_STATE_DOUBLE_CLICK,
+    FSM_HELD: esp.BUTTON_STATE_PRESSED,
+    FSM_LONG: esp.BUTTON_STATE_LONG_PRESS,
+}
+
 class ButtonInstance:
     """Internal button instance representation"""
     def __init__(self, config):
@@ -26,13 +169,40 @@ class ButtonInstance:
         self.long_press_time_ms = config.long_press_time_ms or 1000
         self.double_click_time_ms = config.double_click_time_ms or 300
         self.callback = config.callback
-        self.state = esp.BUTTON_STATE_IDLE
+        self.double_click_on_press = config.double_click_on_press
+        self.hold_stages_ms = [config.hold_stages_ms[i] for i in range(config.hold_stage_count)]
+        self.event_callback = config.event_callback
+        self.user_ctx = config.user_ctx
+        self.repeat_interval_ms = config.repeat_interval_ms
+        self.repeat_delay_ms = config.repeat_delay_ms  # 0: follow long_press_time_ms
+        self.repeat_min_interval_ms = min(config.repeat_min_interval_ms or self.repeat_interval_ms,
+                                          self.repeat_interval_ms)
+        self.repeat_accel_percent = config.repeat_accel_percent
+        self.hold_progress_interval_ms = config.hold_progress_interval_ms
+        self.sink_type = config.sink.type
+        self.sink_handle = config.sink.handle
+        self.sink_drops = 0
+        self.engine = config.engine
+        self.progress_next_ms = 0
+        self.repeat_next_ms = 0
+        self.repeat_cur_interval_ms = 0
+        self.repeat_count = 0
+        self.group = config.group
+        self.group_index = -1
+        self.gestures = None
+        self.latched_mask = 0
+        self.latched_counts = [0] * esp.BUTTON_EVENT_MAX
+        self.long_press_reported = False
+        self.next_hold_stage = 0
+        self.press_time_ms = 0
+        self.fsm_state = FSM_IDLE
         self.is_pressed = False
         self.debounce_timer = None
         self.long_press_timer = None
         self.double_click_timer = None
-        self.click_count = 0
-        self.waiting_for_double_click = False
+        self.mutex = None
+        self.suspended = False
+        self.pm_locked = False
 
 def button_create(config_ptr):
     """Create a button instance"""
@@ -76,6 +246,42 @@ def button_create(config_ptr):
         print(f"DEBUG: Invalid GPIO number: {config.gpio_num}")
         return None
     
+    # Validate auto-repeat acceleration
+    if config.repeat_accel_percent >= 100:
+        print(f"DEBUG: Invalid auto-repeat acceleration: {config.repeat_accel_percent}")
+        return None
+    
+    # Validate hold stages
+    if config.hold_stage_count > esp.BUTTON_MAX_HOLD_STAGES:
+        print(f"DEBUG: Too many hold stages: {config.hold_stage_count}")
+        return None
+    if config.hold_stage_count > 0 and not config.hold_stages_ms:
+        print("DEBUG: Hold stages pointer is NULL")
+        return None
+    for i in range(config.hold_stage_count):
+        if config.hold_stages_ms[i] == 0 or (i > 0 and config.hold_stages_ms[i] <= config.hold_stages_ms[i - 1]):
+            print("DEBUG: Hold stages must be non-zero and strictly ascending")
+            return None
+    
+    # Validate event sink
+    if config.sink.type > esp.BUTTON_SINK_EVENT_LOOP or \
+            (config.sink.type != esp.BUTTON_SINK_NONE and not config.sink.handle):
+        print("DEBUG: Invalid event sink configuration")
+        return None
+    
+    # Compile gestures into a transition table
+    try:
+        gestures = gesture_compile(config)
+    except ValueError as e:
+        print(f"DEBUG: Invalid gesture configuration: {e}")
+        return None
+    
+    # Create the shared PM lock on first use
+    global pm_lock
+    if pm_lock is None:
+        pm_lock = pm.esp_pm_lock_create(esp.ESP_PM_NO_LIGHT_SLEEP, 0, "button")
+        pm.esp_sleep_enable_gpio_wakeup()
+    
     # Check if ISR service is installed
     if not gpio.isr_service_installed:
         print("DEBUG: ISR service not installed")
@@ -86,20 +292,28 @@ def button_create(config_ptr):
     next_button_id += 1
     
     button = ButtonInstance(config)
+    button.gestures = gestures
+    
+    # A stream buffer sink is written from one task only
+    if button.sink_type == esp.BUTTON_SINK_STREAM_BUFFER and not stream_sink_claim(button):
+        print("DEBUG: Stream buffer sink is written from another task, or too many are in use")
+        return None
+    
     button_instances[button_id] = button
     
     # Configure GPIO with proper initial state
     gpio_config = type('GPIOConfig', (), {
         'pin_bit_mask': 1 << config.gpio_num,
         'mode': esp.GPIO_MODE_INPUT,
-        'pull_up_en': esp.GPIO_PULLUP_ENABLE if not config.active_level else esp.GPIO_PULLDOWN_ENABLE,
-        'pull_down_en': esp.GPIO_PULLDOWN_DISABLE if not config.active_level else esp.GPIO_PULLUP_DISABLE,
+        'pull_up_en': esp.GPIO_PULLUP_ENABLE if not config.active_level else esp.GPIO_PULLUP_DISABLE,
+        'pull_down_en': esp.GPIO_PULLDOWN_DISABLE if not config.active_level else esp.GPIO_PULLDOWN_ENABLE,
         'intr_type': esp.GPIO_INTR_ANYEDGE
     })()
     
     result = gpio.gpio_config(gpio_config)
     if result != esp.ESP_OK:
         print(f"DEBUG: GPIO config failed: {result}")
+        stream_sink_release(button)
         del button_instances[button_id]
         return None
     
@@ -133,20 +347,47 @@ def button_create(config_ptr):
         double_click_timer_callback
     )
     
+    button.mutex = freertos.xSemaphoreCreateMutex()
+    
     # Check if timers were created successfully
     if not all([button.debounce_timer, button.long_press_timer, button.double_click_timer]):
         print("DEBUG: Timer creation failed")
+        stream_sink_release(button)
         del button_instances[button_id]
         return None
     
+    # Join group
+    if button.group:
+        if button.group not in group_instances:
+            print(f"DEBUG: Unknown group {button.group}")
+            stream_sink_release(button)
+            del button_instances[button_id]
+            return None
+        group = group_instances[button.group]
+        free_bits = [i for i in range(esp.BUTTON_GROUP_MAX_BUTTONS) if not group.member_mask & (1 << i)]
+        if not free_bits:
+            print("DEBUG: Button group is full")
+            stream_sink_release(button)
+            del button_instances[button_id]
+            return None
+        button.group_index = free_bits[0]
+        group.member_mask |= 1 << button.group_index
+    
     # Install ISR handler
     result = gpio.gpio_isr_handler_add(config.gpio_num, gpio_isr_handler, button_id)
     if result != esp.ESP_OK:
         print(f"DEBUG: ISR handler add failed: {result}")
+        if button.group:
+            group_leave(button)
+        stream_sink_release(button)
         del button_instances[button_id]
         return None
     
     print(f"DEBUG: ISR handler installed for GPIO {config.gpio_num}")
+    
+    # The mock starts settled, without the initial debounce: arm the wakeup pin
+    pm_arm(button)
+    pm_settle(button)
     print(f"DEBUG: Button {button_id} created successfully")
     return button_id
 
@@ -167,8 +408,20 @@ def button_delete(button_handle):
         freertos.xTimerDelete(button.long_press_timer, 0)
     if button.double_click_timer:
         freertos.xTimerDelete(button.double_click_timer, 0)
+    freertos.vSemaphoreDelete(button.mutex)
+    
+    # Release the wakeup pin and lock reference
+    gpio.gpio_wakeup_disable(button.gpio_num)
+    if button.pm_locked:
+        button.pm_locked = False
+        pm.esp_pm_lock_release(pm_lock)
+    
+    # Leave group
+    if button.group:
+        group_leave(button)
     
     # Remove from instances
+    stream_sink_release(button)
     del button_instances[button_handle]
     
     return esp.ESP_OK
@@ -178,14 +431,537 @@ def button_get_state(button_handle):
     if not button_handle or button_handle not in button_instances:
         return esp.BUTTON_STATE_IDLE
     
-    return button_instances[button_handle].state
+    button = button_instances[button_handle]
+    with button_locked(button):
+        return FSM_PUBLIC_STATE[button.fsm_state]
 
 def button_is_pressed(button_handle):
     """Check if button is pressed"""
     if not button_handle or button_handle not in button_instances:
         return False
     
-    return button_instances[button_handle].is_pressed
+    button = button_instances[button_handle]
+    with button_locked(button):
+        return button.is_pressed
+
+def button_set_event_callback(button_handle, event_callback, user_ctx):
+    """Replace the extended event callback and its user context"""
+    if not button_handle or button_handle not in button_instances:
+        return esp.ESP_ERR_INVALID_ARG
+    
+    button = button_instances[button_handle]
+    with button_locked(button):
+        button.event_callback = event_callback.value if isinstance(event_callback, ctypes.c_void_p) else event_callback
+        button.user_ctx = user_ctx
+    return esp.ESP_OK
+
+def button_set_callback(button_handle, callback):
+    """Replace the legacy event callback"""
+    if not button_handle or button_handle not in button_instances:
+        return esp.ESP_ERR_INVALID_ARG
+    
+    button = button_instances[button_handle]
+    with button_locked(button):
+        button.callback = callback.value if isinstance(callback, ctypes.c_void_p) else callback
+    return esp.ESP_OK
+
+def button_set_timings(button_handle, debounce_time_ms, long_press_time_ms, double_click_time_ms):
+    """Change the timings of a live button"""
+    if not button_handle or button_handle not in button_instances:
+        return esp.ESP_ERR_INVALID_ARG
+    
+    button = button_instances[button_handle]
+    with button_locked(button):
+        button.debounce_time_ms = debounce_time_ms or 20
+        button.long_press_time_ms = long_press_time_ms or 1000
+        button.double_click_time_ms = double_click_time_ms or 300
+        
+        # A press in progress is held against the new long press time
+        if button.is_pressed:
+            hold_schedule(button)
+        debounce_start(button)
+    pm_settle(button)
+    return esp.ESP_OK
+
+def button_set_active_level(button_handle, active_level):
+    """Change the active level of a live button"""
+    if not button_handle or button_handle not in button_instances:
+        return esp.ESP_ERR_INVALID_ARG
+    
+    button = button_instances[button_handle]
+    if gpio.gpio_set_pull_mode(button.gpio_num, not active_level) != esp.ESP_OK:
+        return esp.ESP_FAIL
+    with button_locked(button):
+        button.active_level = active_level
+        debounce_start(button)
+    pm_settle(button)
+    return esp.ESP_OK
+
+def button_suspend(button_handle):
+    """Stop the interrupt and deadlines of a button, keeping its resources"""
+    if not button_handle or button_handle not in button_instances:
+        return esp.ESP_ERR_INVALID_ARG
+    
+    button = button_instances[button_handle]
+    gpio.gpio_intr_disable(button.gpio_num)
+    gpio.gpio_wakeup_disable(button.gpio_num)
+    with button_locked(button):
+        for timer in (button.debounce_timer, button.long_press_timer, button.double_click_timer):
+            freertos.xTimerStop(timer, 0)
+        button.suspended = True
+    pm_settle(button)
+    return esp.ESP_OK
+
+def button_resume(button_handle):
+    """Resume a suspended button and resynchronize it with its pin"""
+    if not button_handle or button_handle not in button_instances:
+        return esp.ESP_ERR_INVALID_ARG
+    
+    button = button_instances[button_handle]
+    with button_locked(button):
+        if button.suspended:
+            button.suspended = False
+            # Re-arm what was pending; deadlines passed while suspended fire right away
+            if button.is_pressed:
+                hold_schedule(button)
+            elif button.fsm_state == FSM_WAIT or button.gestures is not None:
+                window_start(button)
+        # The level may have changed while the interrupt was off
+        debounce_start(button)
+    pm_settle(button)
+    gpio.gpio_intr_enable(button.gpio_num)
+    return esp.ESP_OK
+
+def group_for_each(group_handle, fn):
+    """Apply fn to every member of a group, returning the first error"""
+    if not group_handle or group_handle not in group_instances:
+        return esp.ESP_ERR_INVALID_ARG
+    
+    ret = esp.ESP_OK
+    for button_id, button in list(button_instances.items()):
+        if button.group == group_handle:
+            err = fn(button_id)
+            if ret == esp.ESP_OK:
+                ret = err
+    return ret
+
+def button_group_suspend(group_handle):
+    """Suspend every button of a group"""
+    return group_for_each(group_handle, button_suspend)
+
+def button_group_resume(group_handle):
+    """Resume every button of a group"""
+    return group_for_each(group_handle, button_resume)
+
+def button_group_create():
+    """Create an empty button group"""
+    global next_group_id
+    
+    group_id = next_group_id
+    next_group_id += 1
+    group_instances[group_id] = GroupInstance()
+    return group_id
+
+def button_group_delete(group_handle):
+    """Delete a button group"""
+    if not group_handle or group_handle not in group_instances:
+        return esp.ESP_ERR_INVALID_ARG
+    
+    if group_instances[group_handle].member_mask != 0:
+        return esp.ESP_ERR_INVALID_STATE
+    
+    del group_instances[group_handle]
+    return esp.ESP_OK
+
+def button_group_get_pressed_mask(group_handle):
+    """Get the debounced pressed bitmap of a group"""
+    if not group_handle or group_handle not in group_instances:
+        return 0
+    
+    return group_instances[group_handle].pressed_mask
+
+def button_get_group_index(button_handle):
+    """Get the bit index of a button in its group"""
+    if not button_handle or button_handle not in button_instances:
+        return -1
+    
+    return button_instances[button_handle].group_index
+
+def button_group_set_chords(group_handle, chords, count, callback, user_ctx):
+    """Set the chords detected in a group"""
+    if not group_handle or group_handle not in group_instances:
+        return esp.ESP_ERR_INVALID_ARG
+    if count > esp.BUTTON_GROUP_MAX_CHORDS or (count > 0 and not chords):
+        return esp.ESP_ERR_INVALID_ARG
+    
+    for i in range(count):
+        if chords[i].hold_mask == 0 or chords[i].hold_mask & chords[i].click_mask:
+            return esp.ESP_ERR_INVALID_ARG
+    
+    group = group_instances[group_handle]
+    group.chords = [chords[i] for i in range(count)]
+    group.chord_state = [{'start_ms': 0, 'armed': False, 'reported': False} for _ in range(count)]
+    group.chord_callback = callback.value if isinstance(callback, ctypes.c_void_p) else callback
+    group.chord_ctx = user_ctx
+    return esp.ESP_OK
+
+def group_leave(button):
+    """Release a group bit and clear its pressed state"""
+    group = group_instances[button.group]
+    group.pressed_mask &= ~(1 << button.group_index)
+    group.suppress_mask &= ~(1 << button.group_index)
+    group.member_mask &= ~(1 << button.group_index)
+
+def group_eval_chords(group, bit, pressed, now_ms):
+    """Evaluate the chords of a group after an edge, returns detected chord indices"""
+    mask = group.pressed_mask
+    detected = []
+    
+    for i, chord in enumerate(group.chords):
+        st = group.chord_state[i]
+        held = (mask & chord.hold_mask) == chord.hold_mask
+        
+        if not (chord.hold_mask | chord.click_mask) & bit:
+            continue
+        
+        if chord.click_mask == 0:
+            # Hold chord
+            if not pressed:
+                st['reported'] = False
+            elif (mask & chord.hold_mask) == bit:
+                st['start_ms'] = now_ms
+            if (pressed and held and not st['reported'] and
+                    (chord.window_ms == 0 or now_ms - st['start_ms'] <= chord.window_ms)):
+                st['reported'] = True
+                detected.append(i)
+        elif chord.hold_mask & bit:
+            # A modifier edge cancels a click in progress
+            st['armed'] = False
+        elif pressed:
+            if (mask & chord.click_mask) == bit:
+                st['start_ms'] = now_ms
+            st['armed'] = held and (mask & chord.click_mask) == chord.click_mask
+        elif st['armed'] and (mask & chord.click_mask) == 0:
+            # Click complete when the last click button is released
+            st['armed'] = False
+            if held and (chord.window_ms == 0 or now_ms - st['start_ms'] <= chord.window_ms):
+                detected.append(i)
+        
+        if i in detected and chord.suppress:
+            group.suppress_mask |= chord.hold_mask | chord.click_mask
+    
+    return detected
+
+def set_pressed(button, pressed):
+    """Update the debounced pressed state and the group bitmap, returns detected chords"""
+    button.is_pressed = pressed
+    
+    if not button.group:
+        return []
+    
+    group = group_instances[button.group]
+    bit = 1 << button.group_index
+    if pressed:
+        group.pressed_mask |= bit
+    else:
+        group.pressed_mask &= ~bit
+    
+    return group_eval_chords(group, bit, pressed, freertos.current_time_ms)
+
+@contextlib.contextmanager
+def button_locked(button):
+    """Hold the button mutex, as the deadline handlers do"""
+    freertos.xSemaphoreTake(button.mutex, freertos.portMAX_DELAY)
+    try:
+        yield
+    finally:
+        freertos.xSemaphoreGive(button.mutex)
+
+@contextlib.contextmanager
+def button_unlocked(button):
+    """Release the button mutex while user callbacks run"""
+    freertos.xSemaphoreGive(button.mutex)
+    try:
+        yield
+    finally:
+        freertos.xSemaphoreTake(button.mutex, freertos.portMAX_DELAY)
+
+def is_suppressed(button):
+    """Check whether a chord suppresses the button's own events"""
+    return bool(button.group and group_instances[button.group].suppress_mask & (1 << button.group_index))
+
+def emit_chords(button_id, button, detected):
+    """Deliver the chords detected by an edge of this button"""
+    if not detected:
+        return
+    group = group_instances[button.group]
+    with button_unlocked(button):
+        for i in detected:
+            if group.chord_callback:
+                info = ButtonEventInfo(button=button_id, event=esp.BUTTON_EVENT_CHORD,
+                                       hold_time_ms=hold_time_ms(button), chord=i)
+                BUTTON_EVENT_CALLBACK(group.chord_callback)(ctypes.byref(info), group.chord_ctx)
+            if waiters:
+                notify_waiters(ButtonEventInfo(button=button_id, event=esp.BUTTON_EVENT_CHORD,
+                                               hold_time_ms=hold_time_ms(button), chord=i))
+
+def button_consume_events(button_handle, out_ptr):
+    """Fetch and clear the latched events"""
+    if not button_handle or button_handle not in button_instances or not out_ptr:
+        return esp.ESP_ERR_INVALID_ARG
+    
+    out = out_ptr._obj if hasattr(out_ptr, '_obj') else out_ptr
+    button = button_instances[button_handle]
+    pending = button.latched_mask
+    button.latched_mask = 0
+    
+    out.mask = 0
+    for event in range(esp.BUTTON_EVENT_MAX):
+        out.counts[event] = 0
+        if pending & (1 << event):
+            out.counts[event] = button.latched_counts[event]
+            button.latched_counts[event] = 0
+            if out.counts[event] > 0:
+                out.mask |= 1 << event
+    
+    return esp.ESP_OK
+
+def button_get_dropped_events(button_handle):
+    """Number of event records dropped because the sink was full"""
+    if not button_handle or button_handle not in button_instances:
+        return 0
+    return button_instances[button_handle].sink_drops
+
+def stream_sink_claim(button):
+    """Register a button as a writer of its stream buffer sink"""
+    entry = stream_sinks.get(button.sink_handle)
+    if entry is not None:
+        if entry[0] != button.engine:
+            return False
+        entry[1] += 1
+        return True
+    if len(stream_sinks) >= esp.BUTTON_MAX_STREAM_SINKS:
+        return False
+    stream_sinks[button.sink_handle] = [button.engine, 1]
+    return True
+
+def stream_sink_release(button):
+    """Drop a button's registration as a writer of its stream buffer sink"""
+    if button.sink_type != esp.BUTTON_SINK_STREAM_BUFFER:
+        return
+    entry = stream_sinks[button.sink_handle]
+    entry[1] -= 1
+    if entry[1] == 0:
+        del stream_sinks[button.sink_handle]
+
+def post_sink(button, info):
+    """Post an event record to the button's sink without blocking"""
+    size = ctypes.sizeof(info)
+    if button.sink_type == esp.BUTTON_SINK_QUEUE:
+        posted = freertos.xQueueSend(button.sink_handle, info, 0) == 1
+    elif button.sink_type == esp.BUTTON_SINK_STREAM_BUFFER:
+        # Only ever write whole records so readers stay aligned
+        posted = (freertos.xStreamBufferSpacesAvailable(button.sink_handle) >= size and
+                  freertos.xStreamBufferSend(button.sink_handle, info, size, 0) == size)
+    else:
+        posted = events.esp_event_post_to(button.sink_handle, "BUTTON_LONGPRESS_EVENT",
+                                          info.event, info, size, 0) == esp.ESP_OK
+    if not posted:
+        button.sink_drops += 1
+
+def hold_time_ms(button):
+    """Time since the current press was confirmed"""
+    if not button.is_pressed:
+        return 0
+    return freertos.current_time_ms - button.press_time_ms
+
+def emit_event(button_id, button, event, stage=0, repeat_count=0, target_ms=0, gesture=0):
+    """Deliver an event to the legacy and extended callbacks"""
+    # A chord owns this press, only keep press and release balanced
+    if event not in (esp.BUTTON_EVENT_PRESSED, esp.BUTTON_EVENT_RELEASED) and is_suppressed(button):
+        return
+    
+    # Latch for low-rate pollers
+    button.latched_counts[event] += 1
+    button.latched_mask |= 1 << event
+    
+    with button_unlocked(button):
+        if button.callback:
+            callback_func = ctypes.CFUNCTYPE(None, ctypes.c_int)(button.callback)
+            callback_func(event)
+        if button.event_callback:
+            info = ButtonEventInfo(button=button_id, event=event, stage=stage,
+                                   hold_time_ms=hold_time_ms(button), repeat_count=repeat_count,
+                                   target_ms=target_ms, gesture=gesture)
+            event_callback_func = BUTTON_EVENT_CALLBACK(button.event_callback)
+            event_callback_func(ctypes.byref(info), button.user_ctx)
+        if button.sink_type != esp.BUTTON_SINK_NONE:
+            info = ButtonEventInfo(button=button_id, event=event, stage=stage,
+                                   hold_time_ms=hold_time_ms(button), repeat_count=repeat_count,
+                                   target_ms=target_ms, gesture=gesture)
+            post_sink(button, info)
+        if waiters:
+            info = ButtonEventInfo(button=button_id, event=event, stage=stage,
+                                   hold_time_ms=hold_time_ms(button), repeat_count=repeat_count,
+                                   target_ms=target_ms, gesture=gesture)
+            notify_waiters(info)
+
+def waiter_matches(wait, info):
+    """Check whether a waiter is interested in an event"""
+    if not wait.event_mask & (1 << info.event):
+        return False
+    if not wait.handles:
+        return True
+    return any(wait.handles[i] == info.button for i in range(wait.count))
+
+def notify_waiters(info):
+    """Hand an event to every waiter waiting for it"""
+    woken = [wait for wait in waiters if waiter_matches(wait, info)]
+    for wait in woken:
+        waiters.remove(wait)
+        if wait.out:
+            ctypes.memmove(wait.out, ctypes.byref(info), ctypes.sizeof(info))
+        wait.done = True
+    for wait in woken:
+        if wait.callback:
+            BUTTON_WAIT_CALLBACK(wait.callback)(ctypes.byref(info), wait.ctx)
+        else:
+            freertos.xSemaphoreGive(wait.signal)
+
+def wait_timer_arm():
+    """Arm the wait timer for the nearest asynchronous wait deadline"""
+    now = freertos.xTaskGetTickCount()
+    deadlines = [max(wait.deadline - now, 0) for wait in waiters if wait.timed]
+    if deadlines:
+        freertos.xTimerChangePeriod(wait_timer, max(min(deadlines), 1), 0)
+
+def wait_timer_callback(timer_id):
+    """Complete the asynchronous waits whose deadline has passed"""
+    now = freertos.xTaskGetTickCount()
+    expired = [wait for wait in waiters if wait.timed and wait.deadline <= now]
+    for wait in expired:
+        waiters.remove(wait)
+        wait.done = True
+    for wait in expired:
+        BUTTON_WAIT_CALLBACK(wait.callback)(None, wait.ctx)
+    wait_timer_arm()
+
+def button_wait_event(handles, count, event_mask, timeout, out):
+    """Block until one of the buttons reports an event
+    
+    The caller plays the blocked task: time passes while it waits on the
+    semaphore, so the test schedules the pin changes it waits for.
+    """
+    if out is None or (handles is not None and count == 0):
+        return esp.ESP_ERR_INVALID_ARG
+    
+    wait = ButtonWait()
+    wait.signal = freertos.xSemaphoreCreateBinaryStatic()
+    wait.handles = ctypes.cast(handles, ctypes.POINTER(ctypes.c_void_p)) if handles is not None else None
+    wait.count = count
+    wait.event_mask = event_mask or 0xFFFFFFFF
+    wait.out = ctypes.pointer(out)
+    wait.done = False
+    waiters.insert(0, wait)
+    
+    done = freertos.xSemaphoreTake(wait.signal, timeout) == 1
+    if not done:
+        done = wait.done
+        if not done:
+            waiters.remove(wait)
+        else:
+            # Completed as we timed out: let the give land first
+            freertos.xSemaphoreTake(wait.signal, freertos.portMAX_DELAY)
+    freertos.vSemaphoreDelete(wait.signal)
+    
+    return esp.ESP_OK if done else esp.ESP_ERR_TIMEOUT
+
+def button_wait_event_async(wait, handles, count, event_mask, timeout, callback, ctx):
+    """Wait for a button event without blocking"""
+    global wait_timer
+    
+    if wait is None or not callback or (handles is not None and count == 0):
+        return esp.ESP_ERR_INVALID_ARG
+    
+    timed = timeout != freertos.portMAX_DELAY
+    if timed and wait_timer is None:
+        wait_timer = freertos.xTimerCreate("btn_wait", 1, False, None, wait_timer_callback)
+    
+    wait.callback = ctypes.cast(callback, ctypes.c_void_p).value
+    wait.ctx = ctx
+    wait.handles = ctypes.cast(handles, ctypes.POINTER(ctypes.c_void_p)) if handles is not None else None
+    wait.count = count
+    wait.event_mask = event_mask or 0xFFFFFFFF
+    wait.deadline = freertos.xTaskGetTickCount() + (timeout if timed else 0)
+    wait.timed = timed
+    wait.done = False
+    waiters.insert(0, wait)
+    
+    if timed:
+        wait_timer_arm()
+    return esp.ESP_OK
+
+def button_wait_event_cancel(wait):
+    """Cancel an asynchronous wait"""
+    if wait is None or wait not in waiters:
+        return False
+    waiters.remove(wait)
+    return True
+
+def feed_gesture(button_id, button, token):
+    """Feed a token to the gesture recognizer and report completed gestures"""
+    # A chord owns this press, keep it out of gestures
+    if button.gestures is None or is_suppressed(button):
+        return
+    
+    matched = button.gestures.feed(token)
+    for i in range(esp.BUTTON_MAX_GESTURES):
+        if matched & (1 << i):
+            emit_event(button_id, button, esp.BUTTON_EVENT_GESTURE, gesture=i)
+
+def pm_arm(button):
+    """Record a pending deadline and keep the chip out of light sleep"""
+    if not button.pm_locked:
+        button.pm_locked = True
+        pm.esp_pm_lock_acquire(pm_lock)
+
+def pm_settle(button):
+    """Drop the lock reference of a button with no pending deadline and arm its wakeup pin"""
+    timers = (button.debounce_timer, button.long_press_timer, button.double_click_timer)
+    if any(freertos.timers[t]['running'] for t in timers if t in freertos.timers) or not button.pm_locked:
+        return
+    if not button.suspended:
+        # Wake on the level the pin would change to
+        gpio.gpio_wakeup_enable(button.gpio_num, esp.GPIO_INTR_HIGH_LEVEL
+                                if button.active_level != button.is_pressed else esp.GPIO_INTR_LOW_LEVEL)
+    button.pm_locked = False
+    pm.esp_pm_lock_release(pm_lock)
+
+def hold_schedule(button):
+    """Arm the hold timer for the nearest pending hold deadline"""
+    if button.suspended:
+        return
+    deadline_ms = None
+    if not button.long_press_reported:
+        deadline_ms = button.long_press_time_ms
+    if button.next_hold_stage < len(button.hold_stages_ms):
+        stage_ms = button.hold_stages_ms[button.next_hold_stage]
+        if deadline_ms is None or stage_ms < deadline_ms:
+            deadline_ms = stage_ms
+    if button.repeat_interval_ms > 0:
+        if deadline_ms is None or button.repeat_next_ms < deadline_ms:
+            deadline_ms = button.repeat_next_ms
+    if button.hold_progress_interval_ms > 0 and not button.long_press_reported:
+        if deadline_ms is None or button.progress_next_ms < deadline_ms:
+            deadline_ms = button.progress_next_ms
+    
+    if deadline_ms is None:
+        freertos.xTimerStop(button.long_press_timer, 0)
+        return
+    
+    ticks = max(1, (deadline_ms - hold_time_ms(button)) // 10)
+    pm_arm(button)
+    freertos.xTimerChangePeriod(button.long_press_timer, ticks, 0)
 
 def gpio_isr_handler(button_id):
     """GPIO ISR handler"""
@@ -195,8 +971,55 @@ def gpio_isr_handler(button_id):
         return
     
     button = button_instances[button_id]
+    # Back from level wakeup to edge interrupts, as gpio_ll_wakeup_disable()
+    gpio.gpio_wakeup_disable(button.gpio_num)
+    pm_arm(button)
     print(f"DEBUG: Resetting debounce timer for button {button_id}")
-    freertos.xTimerReset(button.debounce_timer, 0)
+    freertos.xTimerResetFromISR(button.debounce_timer)
+
+def window_start(button):
+    """(Re)start the double click timer with the current double click time"""
+    if button.suspended:
+        return
+    pm_arm(button)
+    freertos.xTimerChangePeriod(button.double_click_timer, max(1, button.double_click_time_ms // 10), 0)
+
+def debounce_start(button):
+    """Resample the pin, loading the current debounce time into the debounce timer"""
+    if button.suspended:
+        return
+    pm_arm(button)
+    freertos.xTimerChangePeriod(button.debounce_timer, max(1, button.debounce_time_ms // 10), 0)
+
+def fsm_step(button_id, button, event_input):
+    """Run one click state machine transition"""
+    next_state, actions = FSM_TABLE[button.fsm_state][event_input]
+    button.fsm_state = next_state
+    
+    # The double click timer doubles as the gesture gap timer
+    if actions & ACT_WINDOW_START:
+        window_start(button)
+    if actions & ACT_WINDOW_STOP:
+        freertos.xTimerStop(button.double_click_timer, 0)
+    if actions & ACT_GAP_ARM and button.gestures is not None:
+        window_start(button)
+    if actions & ACT_GAP_STOP and button.gestures is not None:
+        freertos.xTimerStop(button.double_click_timer, 0)
+    if actions & ACT_UNSUPPRESS:
+        group_instances[button.group].suppress_mask &= ~(1 << button.group_index)
+    
+    if actions & ACT_FEED_SHORT:
+        feed_gesture(button_id, button, esp.BUTTON_GESTURE_SHORT)
+    if actions & ACT_EMIT_CLICK:
+        emit_event(button_id, button, esp.BUTTON_EVENT_CLICK)
+    if actions & ACT_EMIT_DOUBLE:
+        emit_event(button_id, button, esp.BUTTON_EVENT_DOUBLE_CLICK)
+    if actions & ACT_EMIT_LONG:
+        emit_event(button_id, button, esp.BUTTON_EVENT_LONG_PRESS)
+    if actions & ACT_FEED_LONG:
+        feed_gesture(button_id, button, esp.BUTTON_GESTURE_LONG)
+    if actions & ACT_FEED_GAP:
+        feed_gesture(button_id, button, esp.BUTTON_GESTURE_GAP)
 
 def debounce_timer_callback(timer_id):
     """Debounce timer callback"""
@@ -215,80 +1038,54 @@ def debounce_timer_callback(timer_id):
     
     print(f"DEBUG: Processing debounce for button {button_id}")
     button = button_instances[button_id]
+    with button_locked(button):
+        debounce_expired(button_id, button)
+    pm_settle(button)
+
+def debounce_expired(button_id, button):
+    """Turn a settled level change into a press or release input"""
+    if button.suspended:
+        return
     current_level = gpio.gpio_get_level(button.gpio_num)
     is_active = (current_level == 1) if button.active_level else (current_level == 0)
     
     print(f"DEBUG: GPIO {button.gpio_num} level: {current_level}, active_level: {button.active_level}, is_active: {is_active}")
     print(f"DEBUG: Button currently pressed: {button.is_pressed}")
     
-    if is_active and not button.is_pressed:
+    # Only level changes are inputs
+    if is_active == button.is_pressed:
+        print(f"DEBUG: No state change for button {button_id} (is_active: {is_active}, is_pressed: {button.is_pressed})")
+        return
+    
+    chords = set_pressed(button, is_active)
+    
+    if is_active:
         print(f"DEBUG: Confirmed button press for button {button_id}")
-        # Confirmed button press
-        button.is_pressed = True
-        button.state = esp.BUTTON_STATE_PRESSED
+        # Start long press and hold stage deadline
+        button.press_time_ms = freertos.current_time_ms
+        button.long_press_reported = False
+        button.next_hold_stage = 0
+        button.repeat_next_ms = button.repeat_delay_ms or button.long_press_time_ms
+        button.repeat_cur_interval_ms = button.repeat_interval_ms
+        button.repeat_count = 0
+        button.progress_next_ms = button.hold_progress_interval_ms
+        hold_schedule(button)
         
-        # Handle double click detection
-        if button.waiting_for_double_click:
-            button.click_count = 2
-            button.waiting_for_double_click = False
-            freertos.xTimerStop(button.double_click_timer, 0)
-        else:
-            button.click_count = 1
-        
-        # Start long press timer
-        freertos.xTimerStart(button.long_press_timer, 0)
-        
-        # Call callback
-        if button.callback:
-            print(f"DEBUG: Calling PRESSED callback for button {button_id}")
-            callback_func = ctypes.CFUNCTYPE(None, ctypes.c_int)(button.callback)
-            callback_func(esp.BUTTON_EVENT_PRESSED)
-        else:
-            print(f"DEBUG: No callback set for button {button_id}")
-    
-    elif not is_active and button.is_pressed:
+        event_input = INPUT_PRESS_DC if button.double_click_on_press else INPUT_PRESS
+        emit_event(button_id, button, esp.BUTTON_EVENT_PRESSED)
+    else:
         print(f"DEBUG: Confirmed button release for button {button_id}")
-        # Confirmed button release
-        button.is_pressed = False
-        
-        # Stop long press timer
         freertos.xTimerStop(button.long_press_timer, 0)
         
-        if button.state == esp.BUTTON_STATE_LONG_PRESS:
-            # Was a long press, reset state
-            button.state = esp.BUTTON_STATE_IDLE
-            button.click_count = 0
-        else:
-            # Was a short press
-            button.state = esp.BUTTON_STATE_SHORT_PRESS
-            
-            if button.click_count == 2:
-                # Double click detected
-                button.state = esp.BUTTON_STATE_DOUBLE_CLICK
-                button.click_count = 0
-                button.waiting_for_double_click = False
-                freertos.xTimerStop(button.double_click_timer, 0)
-                
-                if button.callback:
-                    print(f"DEBUG: Calling DOUBLE_CLICK callback for button {button_id}")
-                    callback_func = ctypes.CFUNCTYPE(None, ctypes.c_int)(button.callback)
-                    callback_func(esp.BUTTON_EVENT_DOUBLE_CLICK)
-            elif button.click_count == 1:
-                # First click, start double click timer
-                button.waiting_for_double_click = True
-                button.state = esp.BUTTON_STATE_IDLE
-                freertos.xTimerStart(button.double_click_timer, 0)
-        
-        # Call released callback
-        if button.callback:
-            print(f"DEBUG: Calling RELEASED callback for button {button_id}")
-            callback_func = ctypes.CFUNCTYPE(None, ctypes.c_int)(button.callback)
-            callback_func(esp.BUTTON_EVENT_RELEASED)
-    else:
-        print(f"DEBUG: No state change for button {button_id} (is_active: {is_active}, is_pressed: {button.is_pressed})")
+        # A press that was part of a suppressing chord is neither a click nor a gesture token
+        event_input = INPUT_CANCEL if is_suppressed(button) else INPUT_RELEASE
+        emit_event(button_id, button, esp.BUTTON_EVENT_RELEASED)
+    
+    fsm_step(button_id, button, event_input)
+    emit_chords(button_id, button, chords)
 
 def long_press_timer_callback(timer_id):
-    """Long press timer callback"""
+    """Hold timer callback: long press and hold stages"""
     # Find button by timer ID
     button_id = None
     for bid, button in button_instances.items():
@@ -300,19 +1097,62 @@ def long_press_timer_callback(timer_id):
         return
     
     button = button_instances[button_id]
+    with button_locked(button):
+        hold_expired(button_id, button)
+    pm_settle(button)
+
+def hold_expired(button_id, button):
+    """Report the long press and hold stages reached, re-arm for the next one"""
+    if button.suspended or not button.is_pressed:
+        return
+    
+    # A glitch shorter than the debounce time: retry once it has settled
+    current_level = gpio.gpio_get_level(button.gpio_num)
+    if current_level != (1 if button.active_level else 0):
+        pm_arm(button)
+        freertos.xTimerChangePeriod(button.long_press_timer, button.debounce_time_ms // 10 + 1, 0)
+        return
+    
+    elapsed_ms = hold_time_ms(button)
+    
+    # Report progress only on the way to the long press, which completes it
+    if (button.hold_progress_interval_ms > 0 and not button.long_press_reported and
+            button.progress_next_ms <= elapsed_ms < button.long_press_time_ms):
+        # Skip missed intervals rather than bursting
+        while button.progress_next_ms <= elapsed_ms:
+            button.progress_next_ms += button.hold_progress_interval_ms
+        emit_event(button_id, button, esp.BUTTON_EVENT_HOLD_PROGRESS, target_ms=button.long_press_time_ms)
+    
+    if not button.long_press_reported and elapsed_ms >= button.long_press_time_ms:
+        button.long_press_reported = True
+        fsm_step(button_id, button, INPUT_LONG)
     
-    if button.is_pressed and button.state == esp.BUTTON_STATE_PRESSED:
-        button.state = esp.BUTTON_STATE_LONG_PRESS
+    # Report every hold stage reached so far, in order
+    while (button.next_hold_stage < len(button.hold_stages_ms) and
+           elapsed_ms >= button.hold_stages_ms[button.next_hold_stage]):
+        stage = button.next_hold_stage
+        button.next_hold_stage += 1
+        emit_event(button_id, button, esp.BUTTON_EVENT_HOLD_STAGE, stage)
+    
+    # Report at most one repeat per expiry, skipping missed ones
+    if button.is_pressed and button.repeat_interval_ms > 0 and elapsed_ms >= button.repeat_next_ms:
+        button.repeat_count += 1
+        button.repeat_next_ms += button.repeat_cur_interval_ms
+        if button.repeat_next_ms <= elapsed_ms:
+            button.repeat_next_ms = elapsed_ms + button.repeat_cur_interval_ms
         
-        # Cancel double click detection
-        button.waiting_for_double_click = False
-        freertos.xTimerStop(button.double_click_timer, 0)
-        button.click_count = 0
+        # Accelerate towards the minimum interval
+        if button.repeat_accel_percent > 0:
+            next_interval = button.repeat_cur_interval_ms * (100 - button.repeat_accel_percent) // 100
+            button.repeat_cur_interval_ms = max(next_interval, button.repeat_min_interval_ms)
         
-        # Call callback
-        if button.callback:
-            callback_func = ctypes.CFUNCTYPE(None, ctypes.c_int)(button.callback)
-            callback_func(esp.BUTTON_EVENT_LONG_PRESS)
+        # Once repeating, the press no longer counts as a click
+        fsm_step(button_id, button, INPUT_REPEAT)
+        
+        emit_event(button_id, button, esp.BUTTON_EVENT_REPEAT, repeat_count=button.repeat_count)
+    
+    if button.is_pressed:
+        hold_schedule(button)
 
 def double_click_timer_callback(timer_id):
     """Double click timeout callback"""
@@ -327,14 +1167,7 @@ def double_click_timer_callback(timer_id):
         return
     
     button = button_instances[button_id]
-    
-    if button.waiting_for_double_click and button.click_count == 1:
-        # Single click confirmed
-        button.waiting_for_double_click = False
-        button.click_count = 0
-        button.state = esp.BUTTON_STATE_IDLE
-        
-        # Call click callback
-        if button.callback:
-            callback_func = ctypes.CFUNCTYPE(None, ctypes.c_int)(button.callback)
-            callback_func(esp.BUTTON_EVENT_CLICK)
+    with button_locked(button):
+        if not button.suspended:
+            fsm_step(button_id, button, INPUT_TIMEOUT)
+    pm_settle(button)
@@ -5,6 +5,7 @@ import pytest
 import ctypes
 import sys
 import os
+from collections import Counter
 
 # Add current directory to Python path for imports
 sys.path.insert(0, os.path.dirname(__file__))
@@ -17,6 +18,7 @@ class MockESP:
     ESP_FAIL = -1
     ESP_ERR_INVALID_ARG = -2
     ESP_ERR_INVALID_STATE = -3
+    ESP_ERR_TIMEOUT = -4
     
     # GPIO definitions
     GPIO_NUM_MAX = 40
@@ -26,6 +28,17 @@ class MockESP:
     GPIO_PULLUP_DISABLE = 0
     GPIO_PULLDOWN_DISABLE = 0
     GPIO_INTR_ANYEDGE = 3
+    GPIO_INTR_LOW_LEVEL = 4
+    GPIO_INTR_HIGH_LEVEL = 5
+    
+    # Power management lock types
+    ESP_PM_NO_LIGHT_SLEEP = 2
+    
+    # Event sink types
+    BUTTON_SINK_NONE = 0
+    BUTTON_SINK_QUEUE = 1
+    BUTTON_SINK_STREAM_BUFFER = 2
+    BUTTON_SINK_EVENT_LOOP = 3
     
     # Button states
     BUTTON_STATE_IDLE = 0
@@ -40,18 +53,162 @@ class MockESP:
     BUTTON_EVENT_CLICK = 2
     BUTTON_EVENT_LONG_PRESS = 3
     BUTTON_EVENT_DOUBLE_CLICK = 4
+    BUTTON_EVENT_HOLD_STAGE = 5
+    BUTTON_EVENT_REPEAT = 6
+    BUTTON_EVENT_HOLD_PROGRESS = 7
+    BUTTON_EVENT_CHORD = 8
+    BUTTON_EVENT_GESTURE = 9
+    BUTTON_EVENT_MAX = 10
+    
+    # Gesture tokens
+    BUTTON_GESTURE_SHORT = 0
+    BUTTON_GESTURE_LONG = 1
+    BUTTON_GESTURE_GAP = 2
+    BUTTON_GESTURE_TOKEN_MAX = 3
+    
+    # Button limits
+    BUTTON_MAX_HOLD_STAGES = 8
+    BUTTON_MAX_STREAM_SINKS = 8
+    BUTTON_GROUP_MAX_BUTTONS = 64
+    BUTTON_GROUP_MAX_CHORDS = 16
+    BUTTON_MAX_GESTURES = 32
+    BUTTON_GESTURE_MAX_TOKENS = 63
 
 class MockFreeRTOS:
     """Mock class for FreeRTOS functionality"""
     
+    portMAX_DELAY = 0xFFFFFFFF
+    
     def __init__(self):
         self.timers = {}
         self.timer_id = 0
         self.current_time_ms = 0
         self.tick_rate_hz = 100  # 100Hz tick rate (10ms per tick)
+        self.reset_stats()
+    
+    def reset_stats(self):
+        """Reset kernel object, timer queue and kernel call accounting"""
+        self.calls = Counter()
+        self.mutexes = set()
+        self.mutexes_held = set()
+        self.mutex_id = 0
+        self.binary_sems = {}
+        self.queues = {}
+        self.stream_buffers = {}
+        self.timer_queue_depth = 0
+        self.timer_queue_peak = 0
+    
+    def kernel_objects(self):
+        """Number of live kernel objects (timers and mutexes)"""
+        return len(self.timers) + len(self.mutexes)
+    
+    def _timer_command(self):
+        """Account a command posted to the timer service queue"""
+        self.timer_queue_depth += 1
+        self.timer_queue_peak = max(self.timer_queue_peak, self.timer_queue_depth)
+    
+    def _timer_daemon_run(self):
+        """The timer service task drained its command queue"""
+        self.timer_queue_depth = 0
+    
+    def xSemaphoreCreateMutex(self):
+        """Create a mutex"""
+        self.calls['xSemaphoreCreateMutex'] += 1
+        self.mutex_id += 1
+        self.mutexes.add(self.mutex_id)
+        return self.mutex_id
+    
+    def xSemaphoreCreateBinaryStatic(self):
+        """Create an empty binary semaphore in caller-provided storage"""
+        self.calls['xSemaphoreCreateBinaryStatic'] += 1
+        self.mutex_id += 1
+        self.binary_sems[self.mutex_id] = 0
+        return self.mutex_id
+    
+    def vSemaphoreDelete(self, mutex):
+        """Delete a mutex or semaphore"""
+        self.calls['vSemaphoreDelete'] += 1
+        self.mutexes.discard(mutex)
+        self.mutexes_held.discard(mutex)
+        self.binary_sems.pop(mutex, None)
+    
+    def xSemaphoreTake(self, mutex, block_time):
+        """Take a mutex or binary semaphore
+        
+        The mock is single threaded, so a mutex is never contended. Blocking
+        on an empty binary semaphore lets time pass tick by tick, running the
+        timers as the timer service task would, until it is given or the
+        block time runs out.
+        """
+        self.calls['xSemaphoreTake'] += 1
+        if mutex in self.binary_sems:
+            tick_ms = 1000 // self.tick_rate_hz
+            waited = 0
+            while self.binary_sems[mutex] == 0 and waited < block_time:
+                self.advance_time(tick_ms)
+                waited += 1
+            if self.binary_sems[mutex] == 0:
+                return 0  # pdFALSE
+            self.binary_sems[mutex] = 0
+            return 1  # pdTRUE
+        if mutex not in self.mutexes or mutex in self.mutexes_held:
+            return 0  # pdFALSE
+        self.mutexes_held.add(mutex)
+        return 1  # pdTRUE
+    
+    def xSemaphoreGive(self, mutex):
+        """Give a mutex or binary semaphore back"""
+        self.calls['xSemaphoreGive'] += 1
+        if mutex in self.binary_sems:
+            if self.binary_sems[mutex]:
+                return 0  # pdFALSE
+            self.binary_sems[mutex] = 1
+            return 1  # pdTRUE
+        if mutex not in self.mutexes_held:
+            return 0  # pdFALSE
+        self.mutexes_held.discard(mutex)
+        return 1  # pdTRUE
+    
+    def xQueueCreate(self, length, item_size):
+        """Create a queue of fixed-size items"""
+        self.calls['xQueueCreate'] += 1
+        self.mutex_id += 1
+        self.queues[self.mutex_id] = {'length': length, 'item_size': item_size, 'items': []}
+        return self.mutex_id
+    
+    def xQueueSend(self, queue, item, block_time):
+        """Copy an item to the back of a queue, fails when it is full"""
+        self.calls['xQueueSend'] += 1
+        q = self.queues[queue]
+        if len(q['items']) >= q['length']:
+            return 0  # errQUEUE_FULL
+        q['items'].append(ctypes.string_at(ctypes.addressof(item), q['item_size']))
+        return 1  # pdTRUE
+    
+    def xStreamBufferCreate(self, size, trigger_level):
+        """Create a stream buffer"""
+        self.calls['xStreamBufferCreate'] += 1
+        self.mutex_id += 1
+        self.stream_buffers[self.mutex_id] = {'size': size, 'data': bytearray()}
+        return self.mutex_id
+    
+    def xStreamBufferSpacesAvailable(self, buffer):
+        """Free bytes in a stream buffer"""
+        self.calls['xStreamBufferSpacesAvailable'] += 1
+        sb = self.stream_buffers[buffer]
+        return sb['size'] - len(sb['data'])
+    
+    def xStreamBufferSend(self, buffer, data, length, block_time):
+        """Write as many bytes as fit, returns the number written"""
+        self.calls['xStreamBufferSend'] += 1
+        sb = self.stream_buffers[buffer]
+        written = min(length, sb['size'] - len(sb['data']))
+        sb['data'] += ctypes.string_at(ctypes.addressof(data), written)
+        return written
     
     def xTimerCreate(self, name, period_ticks, auto_reload, timer_id, callback):
         """Create a timer"""
+        self.calls['xTimerCreate'] += 1
         self.timer_id += 1
         timer = {
             'id': self.timer_id,
@@ -69,6 +226,8 @@ class MockFreeRTOS:
     
     def xTimerStart(self, timer_id, block_time):
         """Start a timer"""
+        self.calls['xTimerStart'] += 1
+        self._timer_command()
         if timer_id in self.timers:
             timer = self.timers[timer_id]
             timer['running'] = True
@@ -78,6 +237,8 @@ class MockFreeRTOS:
     
     def xTimerStop(self, timer_id, block_time):
         """Stop a timer"""
+        self.calls['xTimerStop'] += 1
+        self._timer_command()
         if timer_id in self.timers:
             timer = self.timers[timer_id]
             timer['running'] = False
@@ -86,6 +247,8 @@ class MockFreeRTOS:
     
     def xTimerDelete(self, timer_id, block_time):
         """Delete a timer"""
+        self.calls['xTimerDelete'] += 1
+        self._timer_command()
         if timer_id in self.timers:
             del self.timers[timer_id]
             return 1  # pdPASS
@@ -93,6 +256,11 @@ class MockFreeRTOS:
     
     def xTimerReset(self, timer_id, block_time):
         """Reset a timer"""
+        self.calls['xTimerReset'] += 1
+        return self._timer_reset(timer_id)
+    
+    def _timer_reset(self, timer_id):
+        self._timer_command()
         if timer_id in self.timers:
             timer = self.timers[timer_id]
             timer['expiry_time'] = self.current_time_ms + timer['period_ms']
@@ -100,6 +268,23 @@ class MockFreeRTOS:
             return 1  # pdPASS
         return 0  # pdFAIL
     
+    def xTimerChangePeriod(self, timer_id, period_ticks, block_time):
+        """Change timer period and (re)start it"""
+        self.calls['xTimerChangePeriod'] += 1
+        self._timer_command()
+        if timer_id in self.timers:
+            timer = self.timers[timer_id]
+            timer['period_ms'] = period_ticks * (1000 // self.tick_rate_hz)
+            timer['expiry_time'] = self.current_time_ms + timer['period_ms']
+            timer['running'] = True
+            return 1  # pdPASS
+        return 0  # pdFAIL
+    
+    def xTimerResetFromISR(self, timer_id, woken=None):
+        """Reset a timer from an ISR"""
+        self.calls['xTimerResetFromISR'] += 1
+        return self._timer_reset(timer_id)
+    
     def pvTimerGetTimerID(self, timer_id):
         """Get timer ID"""
         if timer_id in self.timers:
@@ -116,6 +301,7 @@ class MockFreeRTOS:
             return
             
         target_time = self.current_time_ms + ms
+        self._timer_daemon_run()
         
         # Process timers in chronological order
         while self.current_time_ms < target_time:
@@ -125,7 +311,7 @@ class MockFreeRTOS:
             
             for timer_id, timer in self.timers.items():
                 if (timer['running'] and 
-                    timer['expiry_time'] > self.current_time_ms and 
+                    timer['expiry_time'] >= self.current_time_ms and 
                     timer['expiry_time'] <= next_expiry):
                     next_expiry = timer['expiry_time']
                     next_timer = timer_id
@@ -149,10 +335,76 @@ class MockFreeRTOS:
                         timer['callback'](next_timer)
                     except Exception as e:
                         print(f"DEBUG: Error in timer callback: {e}")
+                self._timer_daemon_run()
             else:
                 # No more timers to process, advance to target time
                 self.current_time_ms = target_time
 
+class MockPM:
+    """Mock class for esp_pm locks"""
+    
+    def __init__(self):
+        self.reset()
+    
+    def esp_pm_lock_create(self, lock_type, arg, name):
+        """Create a lock, returns its handle"""
+        self.lock_id += 1
+        self.locks[self.lock_id] = {'type': lock_type, 'name': name, 'count': 0}
+        return self.lock_id
+    
+    def esp_pm_lock_acquire(self, handle):
+        """Take a reference on a lock"""
+        self.locks[handle]['count'] += 1
+        return esp.ESP_OK
+    
+    def esp_pm_lock_release(self, handle):
+        """Drop a reference on a lock"""
+        if self.locks[handle]['count'] == 0:
+            return esp.ESP_ERR_INVALID_STATE
+        self.locks[handle]['count'] -= 1
+        return esp.ESP_OK
+    
+    def esp_sleep_enable_gpio_wakeup(self):
+        """Enable GPIO as a light sleep wakeup source"""
+        self.gpio_wakeup_source = True
+        return esp.ESP_OK
+    
+    def light_sleep_allowed(self):
+        """Automatic light sleep may run when no no-light-sleep lock is held"""
+        return all(lock['count'] == 0 for lock in self.locks.values()
+                   if lock['type'] == esp.ESP_PM_NO_LIGHT_SLEEP)
+    
+    def reset(self):
+        """Reset lock state"""
+        self.locks = {}
+        self.lock_id = 0
+        self.gpio_wakeup_source = False
+
+class MockEventLoop:
+    """Mock class for esp_event loops"""
+    
+    def __init__(self):
+        self.reset()
+    
+    def esp_event_loop_create(self, queue_size):
+        """Create an event loop without a task, returns its handle"""
+        self.loop_id += 1
+        self.loops[self.loop_id] = {'queue_size': queue_size, 'posted': []}
+        return self.loop_id
+    
+    def esp_event_post_to(self, loop, event_base, event_id, event_data, event_data_size, ticks_to_wait):
+        """Queue a copy of the event data, fails when the loop queue is full"""
+        l = self.loops[loop]
+        if len(l['posted']) >= l['queue_size']:
+            return esp.ESP_ERR_TIMEOUT
+        l['posted'].append((event_base, event_id, ctypes.string_at(ctypes.addressof(event_data), event_data_size)))
+        return esp.ESP_OK
+    
+    def reset(self):
+        """Reset loop state"""
+        self.loops = {}
+        self.loop_id = 0
+
 class MockGPIO:
     """Mock class for GPIO functionality"""
     
@@ -161,6 +413,8 @@ class MockGPIO:
         self.isr_handlers = {}
         self.isr_args = {}
         self.isr_service_installed = False
+        self.intr_disabled = set()
+        self.wakeup = {}
     
     def gpio_config(self, config):
         """Configure a GPIO pin"""
@@ -192,6 +446,36 @@ class MockGPIO:
             return self.pins[gpio_num]['level']
         return 0
     
+    def gpio_intr_enable(self, gpio_num):
+        """Enable the interrupt of a GPIO pin"""
+        self.intr_disabled.discard(gpio_num)
+        return esp.ESP_OK
+    
+    def gpio_intr_disable(self, gpio_num):
+        """Disable the interrupt of a GPIO pin"""
+        self.intr_disabled.add(gpio_num)
+        return esp.ESP_OK
+    
+    def gpio_wakeup_enable(self, gpio_num, intr_type):
+        """Wake the chip from light sleep when a GPIO pin reaches a level"""
+        if intr_type not in (esp.GPIO_INTR_LOW_LEVEL, esp.GPIO_INTR_HIGH_LEVEL):
+            return esp.ESP_ERR_INVALID_ARG
+        self.wakeup[gpio_num] = intr_type
+        return esp.ESP_OK
+    
+    def gpio_wakeup_disable(self, gpio_num):
+        """Stop a GPIO pin from waking the chip"""
+        self.wakeup.pop(gpio_num, None)
+        return esp.ESP_OK
+    
+    def gpio_set_pull_mode(self, gpio_num, pull_up):
+        """Select the pull resistor of a GPIO pin; the level is driven by the test"""
+        if gpio_num not in self.pins:
+            return esp.ESP_ERR_INVALID_ARG
+        self.pins[gpio_num]['pull_up_en'] = esp.GPIO_PULLUP_ENABLE if pull_up else esp.GPIO_PULLUP_DISABLE
+        self.pins[gpio_num]['pull_down_en'] = esp.GPIO_PULLDOWN_DISABLE if pull_up else esp.GPIO_PULLDOWN_ENABLE
+        return esp.ESP_OK
+    
     def gpio_set_level(self, gpio_num, level):
         """Set the level of a GPIO pin (simulates external button press/release)"""
         if gpio_num not in self.pins:
@@ -209,7 +493,9 @@ class MockGPIO:
         self.pins[gpio_num]['level'] = level
     
         # Trigger ISR if level changed and there's a handler
-        if old_level != level and gpio_num in self.isr_handlers:
+        if gpio_num in self.intr_disabled:
+            print(f"DEBUG: GPIO {gpio_num} interrupt disabled")
+        elif old_level != level and gpio_num in self.isr_handlers:
             print(f"DEBUG: GPIO {gpio_num} level changed from {old_level} to {level}, triggering ISR")
             try:
                 self.isr_handlers[gpio_num](self.isr_args[gpio_num])
@@ -258,6 +544,22 @@ class MockGPIO:
         self.isr_handlers = {}
         self.isr_args = {}
         self.isr_service_installed = False
+        self.intr_disabled = set()
+        self.wakeup = {}
+
+# Define button_sink_t structure for C compatibility
+class ButtonSink(ctypes.Structure):
+    _fields_ = [
+        ("type", ctypes.c_int),
+        ("handle", ctypes.c_void_p)
+    ]
+
+# Define button_gesture_t structure for C compatibility
+class ButtonGesture(ctypes.Structure):
+    _fields_ = [
+        ("tokens", ctypes.POINTER(ctypes.c_int)),
+        ("length", ctypes.c_uint8)
+    ]
 
 # Define ButtonConfig structure for C compatibility
 class ButtonConfig(ctypes.Structure):
@@ -267,25 +569,102 @@ class ButtonConfig(ctypes.Structure):
         ("debounce_time_ms", ctypes.c_uint32),
         ("long_press_time_ms", ctypes.c_uint32),
         ("double_click_time_ms", ctypes.c_uint32),
-        ("callback", ctypes.c_void_p)
+        ("callback", ctypes.c_void_p),
+        ("double_click_on_press", ctypes.c_bool),
+        ("hold_stages_ms", ctypes.POINTER(ctypes.c_uint32)),
+        ("hold_stage_count", ctypes.c_uint8),
+        ("event_callback", ctypes.c_void_p),
+        ("user_ctx", ctypes.c_void_p),
+        ("repeat_interval_ms", ctypes.c_uint32),
+        ("repeat_delay_ms", ctypes.c_uint32),
+        ("repeat_min_interval_ms", ctypes.c_uint32),
+        ("repeat_accel_percent", ctypes.c_uint8),
+        ("hold_progress_interval_ms", ctypes.c_uint32),
+        ("sink", ButtonSink),
+        ("group", ctypes.c_void_p),
+        ("gestures", ctypes.POINTER(ButtonGesture)),
+        ("gesture_count", ctypes.c_uint8),
+        ("engine", ctypes.c_void_p)
     ]
 
+# Define button_event_info_t structure for C compatibility
+class ButtonEventInfo(ctypes.Structure):
+    _fields_ = [
+        ("button", ctypes.c_void_p),
+        ("event", ctypes.c_int),
+        ("stage", ctypes.c_uint8),
+        ("hold_time_ms", ctypes.c_uint32),
+        ("repeat_count", ctypes.c_uint32),
+        ("target_ms", ctypes.c_uint32),
+        ("chord", ctypes.c_uint8),
+        ("gesture", ctypes.c_uint8)
+    ]
+
+# Define button_chord_t structure for C compatibility
+class ButtonChord(ctypes.Structure):
+    _fields_ = [
+        ("hold_mask", ctypes.c_uint64),
+        ("click_mask", ctypes.c_uint64),
+        ("window_ms", ctypes.c_uint32),
+        ("suppress", ctypes.c_bool)
+    ]
+
+# Define button_events_t structure for C compatibility
+class ButtonEvents(ctypes.Structure):
+    _fields_ = [
+        ("mask", ctypes.c_uint32),
+        ("counts", ctypes.c_uint32 * MockESP.BUTTON_EVENT_MAX)
+    ]
+
+# C-compatible extended callback type
+BUTTON_EVENT_CALLBACK = ctypes.CFUNCTYPE(None, ctypes.POINTER(ButtonEventInfo), ctypes.c_void_p)
+
+# C-compatible asynchronous wait completion callback type
+BUTTON_WAIT_CALLBACK = ctypes.CFUNCTYPE(None, ctypes.POINTER(ButtonEventInfo), ctypes.c_void_p)
+
+# Define button_wait_t structure for C compatibility
+class ButtonWait(ctypes.Structure):
+    pass
+
+ButtonWait._fields_ = [
+    ("next", ctypes.POINTER(ButtonWait)),
+    ("signal", ctypes.c_void_p),
+    ("callback", ctypes.c_void_p),
+    ("ctx", ctypes.c_void_p),
+    ("handles", ctypes.POINTER(ctypes.c_void_p)),
+    ("count", ctypes.c_size_t),
+    ("event_mask", ctypes.c_uint32),
+    ("out", ctypes.POINTER(ButtonEventInfo)),
+    ("deadline", ctypes.c_uint32),
+    ("timed", ctypes.c_bool),
+    ("done", ctypes.c_bool)
+]
+
 # Create global instances of mock objects
 esp = MockESP()
 gpio = MockGPIO()
 freertos = MockFreeRTOS()
+pm = MockPM()
+events = MockEventLoop()
 
 def reset_all_mocks():
     """Reset all mock objects to initial state"""
-    global esp, gpio, freertos
+    global esp, gpio, freertos, pm, events
     
     # Reset GPIO
     gpio.reset()
     
+    # Reset power management
+    pm.reset()
+    
+    # Reset event loops
+    events.reset()
+    
     # Reset FreeRTOS
     freertos.timers = {}
     freertos.timer_id = 0
     freertos.current_time_ms = 0
+    freertos.reset_stats()
     
     # Install ISR service
     gpio.gpio_install_isr_service(0)
@@ -301,12 +680,19 @@ def mock_button_component():
     import button_longpress
     button_longpress.button_instances = {}
     button_longpress.next_button_id = 1
+    button_longpress.group_instances = {}
+    button_longpress.next_group_id = 1
+    button_longpress.waiters = []
+    button_longpress.wait_timer = None
+    button_longpress.pm_lock = None
+    button_longpress.stream_sinks = {}
     
     yield
     
     # Cleanup after test
     reset_all_mocks()
     button_longpress.button_instances = {}
+    button_longpress.group_instances = {}
 
 @pytest.fixture
 def button_config():
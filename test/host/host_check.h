@@ -0,0 +1,22 @@
+/**
+ * @file host_check.h
+ * @brief Minimal assertions for the host test programs
+ *
+ * A failed CHECK() is reported and counted, and HOST_CHECK_EXIT() turns the
+ * count into the program's exit status.
+ */
+
+#pragma once
+
+#include <stdio.h>
+
+static int s_check_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        s_check_failures++; \
+    } \
+} while (0)
+
+#define HOST_CHECK_EXIT() (s_check_failures == 0 ? 0 : 1)
@@ -0,0 +1,633 @@
+/**
+ * @file host_rtos.c
+ * @brief Single threaded host kernel and GPIO driver for running the component on a PC
+ *
+ * The program calling into the component is the application task. Timer
+ * callbacks and pended function calls run on a simulated timer service task
+ * whenever time passes, and a level change on a pin calls its GPIO interrupt
+ * handler directly. Kernel calls made inside a critical section, and a task
+ * taking a mutex it already holds, abort the program.
+ */
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host_rtos.h"
+#include "esp_log.h"
+#include "esp_event.h"
+#include "driver/gpio.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/timers.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include "freertos/stream_buffer.h"
+
+#define HOST_MAX_CALL_NAMES     64
+#define HOST_MAX_PENDED_CALLS   32
+#define HOST_MAX_BLOCK_TICKS    1000000
+
+/* Calls per function name, names are the functions' __func__ */
+static struct {
+    const char *name;
+    uint32_t count;
+} s_calls[HOST_MAX_CALL_NAMES];
+static int s_call_names = 0;
+
+#define HOST_COUNT() host_count(__func__)
+
+struct tskTaskControlBlock {
+    const char *name;
+};
+
+static struct tskTaskControlBlock s_app_task = { "main" };
+static struct tskTaskControlBlock s_timer_task = { "Tmr Svc" };
+static TaskHandle_t s_current_task = &s_app_task;
+
+static int s_critical_nesting = 0;
+
+/* Time, advanced by host_advance_ms() or by a task blocking on a semaphore */
+static uint32_t s_time_ms = 0;
+static TickType_t s_tick = 0;
+
+struct tmrTimerControl {
+    const char *name;
+    TickType_t period;
+    bool auto_reload;
+    void *timer_id;
+    TimerCallbackFunction_t callback;
+    bool active;
+    bool deleted;
+    TickType_t expiry;
+    uint32_t order;                     /* Start order, breaks ties between equal expiry ticks */
+    struct tmrTimerControl *next;
+};
+
+static struct tmrTimerControl *s_timers = NULL;
+static uint32_t s_timer_order = 0;
+
+/* Timer command queue entries posted by xTimerPendFunctionCall() */
+static struct {
+    PendedFunction_t function;
+    void *arg1;
+    uint32_t arg2;
+} s_pended[HOST_MAX_PENDED_CALLS];
+static int s_pended_head = 0;
+static int s_pended_count = 0;
+
+typedef enum {
+    HOST_SEM_MUTEX,
+    HOST_SEM_RECURSIVE_MUTEX,
+    HOST_SEM_BINARY,
+} host_sem_kind_t;
+
+struct QueueDefinition {
+    host_sem_kind_t kind;
+    int count;                          /* Nesting of a mutex, value of a binary semaphore */
+    bool is_static;
+};
+
+_Static_assert(sizeof(struct QueueDefinition) <= sizeof(StaticSemaphore_t), "StaticSemaphore_t too small");
+
+static int s_mutexes_held = 0;
+
+static struct {
+    int level;
+    gpio_int_type_t intr_type;
+    bool intr_enabled;
+    gpio_isr_t handler;
+    void *arg;
+} s_pins[GPIO_NUM_MAX];
+
+static bool s_isr_service_installed = false;
+
+static void host_count(const char *name)
+{
+    for (int i = 0; i < s_call_names; i++) {
+        if (strcmp(s_calls[i].name, name) == 0) {
+            s_calls[i].count++;
+            return;
+        }
+    }
+    assert(s_call_names < HOST_MAX_CALL_NAMES);
+    s_calls[s_call_names].name = name;
+    s_calls[s_call_names].count = 1;
+    s_call_names++;
+}
+
+uint32_t host_calls(const char *name)
+{
+    for (int i = 0; i < s_call_names; i++) {
+        if (strcmp(s_calls[i].name, name) == 0) {
+            return s_calls[i].count;
+        }
+    }
+    return 0;
+}
+
+void host_calls_clear(void)
+{
+    for (int i = 0; i < s_call_names; i++) {
+        s_calls[i].count = 0;
+    }
+}
+
+int host_mutexes_held(void)
+{
+    return s_mutexes_held;
+}
+
+void host_log(char level, const char *tag, const char *format, ...)
+{
+    if (level != 'E' && level != 'W') {
+        return;
+    }
+    va_list args;
+    va_start(args, format);
+    fprintf(stderr, "%c (%u) %s: ", level, (unsigned)s_tick, tag);
+    vfprintf(stderr, format, args);
+    fputc('\n', stderr);
+    va_end(args);
+}
+
+void host_enter_critical(portMUX_TYPE *mux)
+{
+    mux->nesting++;
+    s_critical_nesting++;
+}
+
+void host_exit_critical(portMUX_TYPE *mux)
+{
+    assert(mux->nesting > 0);
+    mux->nesting--;
+    s_critical_nesting--;
+}
+
+/**
+ * @brief Task-level kernel calls are not allowed inside a critical section
+ */
+static void host_check_task_call(void)
+{
+    assert(s_critical_nesting == 0 && "kernel call inside a critical section");
+}
+
+BaseType_t xPortGetCoreID(void)
+{
+    return 0;
+}
+
+/**
+ * @brief Run the timer service task: pended calls, then every due timer
+ */
+static void host_timer_task_run(void)
+{
+    TaskHandle_t previous = s_current_task;
+    s_current_task = &s_timer_task;
+
+    for (;;) {
+        if (s_pended_count > 0) {
+            PendedFunction_t function = s_pended[s_pended_head].function;
+            void *arg1 = s_pended[s_pended_head].arg1;
+            uint32_t arg2 = s_pended[s_pended_head].arg2;
+            s_pended_head = (s_pended_head + 1) % HOST_MAX_PENDED_CALLS;
+            s_pended_count--;
+            function(arg1, arg2);
+            continue;
+        }
+
+        struct tmrTimerControl *due = NULL;
+        for (struct tmrTimerControl *timer = s_timers; timer != NULL; timer = timer->next) {
+            if (!timer->active || (int32_t)(timer->expiry - s_tick) > 0) {
+                continue;
+            }
+            if (due == NULL || (int32_t)(timer->expiry - due->expiry) < 0 ||
+                (timer->expiry == due->expiry && timer->order < due->order)) {
+                due = timer;
+            }
+        }
+        if (due == NULL) {
+            break;
+        }
+        if (due->auto_reload) {
+            due->expiry += due->period;
+        } else {
+            due->active = false;
+        }
+        due->callback(due);
+    }
+
+    /* Deleted timers are freed by the timer service task */
+    struct tmrTimerControl **link = &s_timers;
+    while (*link != NULL) {
+        struct tmrTimerControl *timer = *link;
+        if (timer->deleted) {
+            *link = timer->next;
+            free(timer);
+        } else {
+            link = &timer->next;
+        }
+    }
+
+    s_current_task = previous;
+}
+
+/**
+ * @brief Advance to the next tick
+ */
+static void host_tick(void)
+{
+    s_tick++;
+    s_time_ms = s_tick * portTICK_PERIOD_MS;
+    host_timer_task_run();
+}
+
+void host_advance_ms(uint32_t ms)
+{
+    uint32_t target = s_time_ms + ms;
+
+    host_timer_task_run();
+    while ((s_tick + 1) * portTICK_PERIOD_MS <= target) {
+        host_tick();
+    }
+    s_time_ms = target;
+}
+
+void host_gpio_set_level(int gpio_num, int level)
+{
+    assert(gpio_num >= 0 && gpio_num < GPIO_NUM_MAX);
+    level = level ? 1 : 0;
+    if (s_pins[gpio_num].level == level) {
+        return;
+    }
+    s_pins[gpio_num].level = level;
+
+    gpio_int_type_t type = s_pins[gpio_num].intr_type;
+    bool edge = (type == GPIO_INTR_ANYEDGE) ||
+                (type == GPIO_INTR_POSEDGE && level == 1) ||
+                (type == GPIO_INTR_NEGEDGE && level == 0);
+    if (edge && s_pins[gpio_num].intr_enabled && s_pins[gpio_num].handler != NULL) {
+        s_pins[gpio_num].handler(s_pins[gpio_num].arg);
+    }
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    HOST_COUNT();
+    return s_tick;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    HOST_COUNT();
+    return s_current_task;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char *name, uint32_t stack_depth, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *created, BaseType_t core_id)
+{
+    HOST_COUNT();
+    /* The host kernel runs no other tasks */
+    return pdFAIL;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    HOST_COUNT();
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    HOST_COUNT();
+    host_check_task_call();
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higher_priority_task_woken)
+{
+    HOST_COUNT();
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait)
+{
+    HOST_COUNT();
+    host_check_task_call();
+    return 0;
+}
+
+/**
+ * @brief (Re)start a timer from the current tick
+ */
+static BaseType_t host_timer_start(TimerHandle_t timer)
+{
+    assert(timer != NULL && !timer->deleted);
+    timer->active = true;
+    timer->expiry = s_tick + timer->period;
+    timer->order = s_timer_order++;
+    return pdPASS;
+}
+
+TimerHandle_t xTimerCreate(const char *name, TickType_t period, UBaseType_t auto_reload, void *timer_id,
+                           TimerCallbackFunction_t callback)
+{
+    HOST_COUNT();
+    assert(period > 0);
+    struct tmrTimerControl *timer = calloc(1, sizeof(*timer));
+    if (timer == NULL) {
+        return NULL;
+    }
+    timer->name = name;
+    timer->period = period;
+    timer->auto_reload = auto_reload;
+    timer->timer_id = timer_id;
+    timer->callback = callback;
+    timer->next = s_timers;
+    s_timers = timer;
+    return timer;
+}
+
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t ticks_to_wait)
+{
+    HOST_COUNT();
+    host_check_task_call();
+    assert(timer != NULL && !timer->deleted);
+    timer->active = false;
+    return pdPASS;
+}
+
+BaseType_t xTimerReset(TimerHandle_t timer, TickType_t ticks_to_wait)
+{
+    HOST_COUNT();
+    host_check_task_call();
+    return host_timer_start(timer);
+}
+
+BaseType_t xTimerResetFromISR(TimerHandle_t timer, BaseType_t *higher_priority_task_woken)
+{
+    HOST_COUNT();
+    return host_timer_start(timer);
+}
+
+BaseType_t xTimerChangePeriod(TimerHandle_t timer, TickType_t period, TickType_t ticks_to_wait)
+{
+    HOST_COUNT();
+    host_check_task_call();
+    assert(period > 0);
+    timer->period = period;
+    return host_timer_start(timer);
+}
+
+BaseType_t xTimerDelete(TimerHandle_t timer, TickType_t ticks_to_wait)
+{
+    HOST_COUNT();
+    host_check_task_call();
+    assert(timer != NULL && !timer->deleted);
+    timer->active = false;
+    timer->deleted = true;
+    return pdPASS;
+}
+
+void *pvTimerGetTimerID(TimerHandle_t timer)
+{
+    HOST_COUNT();
+    return timer->timer_id;
+}
+
+BaseType_t xTimerPendFunctionCall(PendedFunction_t function, void *arg1, uint32_t arg2, TickType_t ticks_to_wait)
+{
+    HOST_COUNT();
+    host_check_task_call();
+    if (s_pended_count == HOST_MAX_PENDED_CALLS) {
+        return pdFAIL;
+    }
+    int tail = (s_pended_head + s_pended_count) % HOST_MAX_PENDED_CALLS;
+    s_pended[tail].function = function;
+    s_pended[tail].arg1 = arg1;
+    s_pended[tail].arg2 = arg2;
+    s_pended_count++;
+    return pdPASS;
+}
+
+TaskHandle_t xTimerGetTimerDaemonTaskHandle(void)
+{
+    HOST_COUNT();
+    return &s_timer_task;
+}
+
+static SemaphoreHandle_t host_sem_create(host_sem_kind_t kind)
+{
+    SemaphoreHandle_t sem = calloc(1, sizeof(*sem));
+    if (sem != NULL) {
+        sem->kind = kind;
+    }
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    HOST_COUNT();
+    return host_sem_create(HOST_SEM_MUTEX);
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void)
+{
+    HOST_COUNT();
+    return host_sem_create(HOST_SEM_RECURSIVE_MUTEX);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t *buffer)
+{
+    HOST_COUNT();
+    SemaphoreHandle_t sem = (SemaphoreHandle_t)buffer;
+    memset(sem, 0, sizeof(*sem));
+    sem->kind = HOST_SEM_BINARY;
+    sem->is_static = true;
+    return sem;
+}
+
+/**
+ * @brief Take a mutex, nested only if it is recursive
+ */
+static BaseType_t host_mutex_take(SemaphoreHandle_t mutex, TickType_t ticks_to_wait, bool recursive)
+{
+    if (mutex->count > 0 && !recursive) {
+        /* Only one task runs, so nobody else can give it back */
+        assert(ticks_to_wait == 0 && "task takes a mutex it already holds");
+        return pdFALSE;
+    }
+    if (mutex->count++ == 0) {
+        s_mutexes_held++;
+    }
+    return pdTRUE;
+}
+
+static BaseType_t host_mutex_give(SemaphoreHandle_t mutex)
+{
+    if (mutex->count == 0) {
+        return pdFALSE;
+    }
+    if (--mutex->count == 0) {
+        s_mutexes_held--;
+    }
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks_to_wait)
+{
+    HOST_COUNT();
+    host_check_task_call();
+    if (semaphore->kind != HOST_SEM_BINARY) {
+        return host_mutex_take(semaphore, ticks_to_wait, false);
+    }
+
+    /* Blocking lets the timer service task run until the semaphore is given */
+    TickType_t waited = 0;
+    while (semaphore->count == 0 && waited < ticks_to_wait) {
+        assert(s_current_task != &s_timer_task && "timer service task blocks");
+        assert(waited < HOST_MAX_BLOCK_TICKS && "semaphore never given");
+        host_tick();
+        waited++;
+    }
+    if (semaphore->count == 0) {
+        return pdFALSE;
+    }
+    semaphore->count = 0;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+    HOST_COUNT();
+    host_check_task_call();
+    if (semaphore->kind != HOST_SEM_BINARY) {
+        return host_mutex_give(semaphore);
+    }
+    if (semaphore->count == 1) {
+        return pdFALSE;
+    }
+    semaphore->count = 1;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t mutex, TickType_t ticks_to_wait)
+{
+    HOST_COUNT();
+    host_check_task_call();
+    assert(mutex->kind == HOST_SEM_RECURSIVE_MUTEX);
+    return host_mutex_take(mutex, ticks_to_wait, true);
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t mutex)
+{
+    HOST_COUNT();
+    host_check_task_call();
+    assert(mutex->kind == HOST_SEM_RECURSIVE_MUTEX);
+    return host_mutex_give(mutex);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore)
+{
+    HOST_COUNT();
+    if (semaphore->kind != HOST_SEM_BINARY && semaphore->count > 0) {
+        s_mutexes_held--;
+    }
+    if (!semaphore->is_static) {
+        free(semaphore);
+    }
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait)
+{
+    HOST_COUNT();
+    host_check_task_call();
+    return pdTRUE;
+}
+
+size_t xStreamBufferSend(StreamBufferHandle_t buffer, const void *data, size_t length, TickType_t ticks_to_wait)
+{
+    HOST_COUNT();
+    host_check_task_call();
+    return length;
+}
+
+size_t xStreamBufferSpacesAvailable(StreamBufferHandle_t buffer)
+{
+    HOST_COUNT();
+    return SIZE_MAX;
+}
+
+esp_err_t esp_event_post_to(esp_event_loop_handle_t event_loop, esp_event_base_t event_base, int32_t event_id,
+                            const void *event_data, size_t event_data_size, TickType_t ticks_to_wait)
+{
+    HOST_COUNT();
+    host_check_task_call();
+    return ESP_OK;
+}
+
+esp_err_t gpio_config(const gpio_config_t *config)
+{
+    HOST_COUNT();
+    for (int pin = 0; pin < GPIO_NUM_MAX; pin++) {
+        if (config->pin_bit_mask & (1ULL << pin)) {
+            s_pins[pin].intr_type = config->intr_type;
+            s_pins[pin].intr_enabled = (config->intr_type != GPIO_INTR_DISABLE);
+        }
+    }
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio_num)
+{
+    HOST_COUNT();
+    return s_pins[gpio_num].level;
+}
+
+esp_err_t gpio_set_pull_mode(gpio_num_t gpio_num, gpio_pull_mode_t pull)
+{
+    HOST_COUNT();
+    return ESP_OK;
+}
+
+esp_err_t gpio_install_isr_service(int intr_alloc_flags)
+{
+    HOST_COUNT();
+    if (s_isr_service_installed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_isr_service_installed = true;
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio_num, gpio_isr_t isr_handler, void *args)
+{
+    HOST_COUNT();
+    if (!s_isr_service_installed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_pins[gpio_num].handler = isr_handler;
+    s_pins[gpio_num].arg = args;
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio_num)
+{
+    HOST_COUNT();
+    s_pins[gpio_num].handler = NULL;
+    s_pins[gpio_num].arg = NULL;
+    return ESP_OK;
+}
+
+esp_err_t gpio_intr_enable(gpio_num_t gpio_num)
+{
+    HOST_COUNT();
+    s_pins[gpio_num].intr_enabled = true;
+    return ESP_OK;
+}
+
+esp_err_t gpio_intr_disable(gpio_num_t gpio_num)
+{
+    HOST_COUNT();
+    s_pins[gpio_num].intr_enabled = false;
+    return ESP_OK;
+}
@@ -0,0 +1,51 @@
+/**
+ * @file host_rtos.h
+ * @brief Control of the simulated kernel used to run the component on the host
+ *
+ * Every kernel and driver function the component calls is counted by name,
+ * so tests see the calls the real C code makes, not those of a model.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Let time pass, running the timer service task at every tick
+ *
+ * @param ms Time in milliseconds, rounded down to whole ticks
+ */
+void host_advance_ms(uint32_t ms);
+
+/**
+ * @brief Drive a pin, raising its interrupt on a level change
+ *
+ * @param gpio_num GPIO number
+ * @param level New level (0 or 1)
+ */
+void host_gpio_set_level(int gpio_num, int level);
+
+/**
+ * @brief Number of calls to a kernel or driver function since host_calls_clear()
+ *
+ * @param name Function name, e.g. "xTimerChangePeriod"
+ */
+uint32_t host_calls(const char *name);
+
+/**
+ * @brief Reset all call counters
+ */
+void host_calls_clear(void);
+
+/**
+ * @brief Number of mutexes currently taken
+ */
+int host_mutexes_held(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,9 @@
+/**
+ * @file esp_attr.h
+ * @brief Host stand-in for the ESP-IDF placement attributes
+ */
+
+#pragma once
+
+#define IRAM_ATTR
+#define DRAM_ATTR
@@ -0,0 +1,16 @@
+/**
+ * @file esp_heap_caps.h
+ * @brief Host stand-in for capability-based allocation
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define MALLOC_CAP_8BIT         (1 << 2)
+#define MALLOC_CAP_INTERNAL     (1 << 11)
+#define MALLOC_CAP_DEFAULT      (1 << 12)
+
+#define heap_caps_calloc(n, size, caps) calloc((n), (size))
@@ -0,0 +1,62 @@
+/**
+ * @file FreeRTOS.h
+ * @brief Host stand-in for the FreeRTOS kernel types and port macros
+ *
+ * The host kernel in host_rtos.c is single threaded: the main program plays
+ * the application task, host_gpio_set_level() raises the GPIO interrupt and
+ * host_advance_ms() runs the timer service task tick by tick.
+ */
+
+#pragma once
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_attr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE                 0
+#define pdTRUE                  1
+#define pdFAIL                  pdFALSE
+#define pdPASS                  pdTRUE
+
+#define configTICK_RATE_HZ      100
+#define portTICK_PERIOD_MS      (1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)       ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000))
+#define portMAX_DELAY           ((TickType_t)0xFFFFFFFFUL)
+#define tskNO_AFFINITY          0x7FFFFFFF
+#define portNUM_PROCESSORS      2
+
+#define configASSERT(x)         assert(x)
+
+/* Critical sections only count their nesting, to catch kernel calls made inside one */
+typedef struct {
+    int nesting;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED    { 0 }
+#define portMUX_INITIALIZE(mux)         ((mux)->nesting = 0)
+
+void host_enter_critical(portMUX_TYPE *mux);
+void host_exit_critical(portMUX_TYPE *mux);
+
+#define portENTER_CRITICAL(mux)         host_enter_critical(mux)
+#define portEXIT_CRITICAL(mux)          host_exit_critical(mux)
+#define portENTER_CRITICAL_ISR(mux)     host_enter_critical(mux)
+#define portEXIT_CRITICAL_ISR(mux)      host_exit_critical(mux)
+#define portENTER_CRITICAL_SAFE(mux)    host_enter_critical(mux)
+#define portEXIT_CRITICAL_SAFE(mux)     host_exit_critical(mux)
+#define portYIELD_FROM_ISR(...)         ((void)0)
+
+BaseType_t xPortGetCoreID(void);
+
+#ifdef __cplusplus
+}
+#endif
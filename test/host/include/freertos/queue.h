@@ -0,0 +1,20 @@
+/**
+ * @file queue.h
+ * @brief Host stand-in for FreeRTOS queues, sends always succeed
+ */
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct QueueDefinition *QueueHandle_t;
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,21 @@
+/**
+ * @file stream_buffer.h
+ * @brief Host stand-in for FreeRTOS stream buffers, sends always succeed
+ */
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct StreamBufferDef_t *StreamBufferHandle_t;
+
+size_t xStreamBufferSend(StreamBufferHandle_t buffer, const void *data, size_t length, TickType_t ticks_to_wait);
+size_t xStreamBufferSpacesAvailable(StreamBufferHandle_t buffer);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,32 @@
+/**
+ * @file timers.h
+ * @brief Host stand-in for FreeRTOS software timers, run by host_advance_ms()
+ */
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct tmrTimerControl *TimerHandle_t;
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t timer);
+typedef void (*PendedFunction_t)(void *arg1, uint32_t arg2);
+
+TimerHandle_t xTimerCreate(const char *name, TickType_t period, UBaseType_t auto_reload, void *timer_id,
+                           TimerCallbackFunction_t callback);
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t ticks_to_wait);
+BaseType_t xTimerReset(TimerHandle_t timer, TickType_t ticks_to_wait);
+BaseType_t xTimerResetFromISR(TimerHandle_t timer, BaseType_t *higher_priority_task_woken);
+BaseType_t xTimerChangePeriod(TimerHandle_t timer, TickType_t period, TickType_t ticks_to_wait);
+BaseType_t xTimerDelete(TimerHandle_t timer, TickType_t ticks_to_wait);
+void *pvTimerGetTimerID(TimerHandle_t timer);
+BaseType_t xTimerPendFunctionCall(PendedFunction_t function, void *arg1, uint32_t arg2, TickType_t ticks_to_wait);
+TaskHandle_t xTimerGetTimerDaemonTaskHandle(void);
+
+#ifdef __cplusplus
+}
+#endif
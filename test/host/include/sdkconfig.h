@@ -0,0 +1,24 @@
+/**
+ * @file sdkconfig.h
+ * @brief Host build configuration: the component's Kconfig defaults
+ *
+ * Any option can be overridden with -D on the compiler command line.
+ */
+
+#pragma once
+
+#ifndef CONFIG_BUTTON_LONGPRESS_DOUBLE_CLICK
+#define CONFIG_BUTTON_LONGPRESS_DOUBLE_CLICK 1
+#endif
+#ifndef CONFIG_BUTTON_LONGPRESS_LONG_PRESS
+#define CONFIG_BUTTON_LONGPRESS_LONG_PRESS 1
+#endif
+#ifndef CONFIG_BUTTON_LONGPRESS_ANTI_NOISE
+#define CONFIG_BUTTON_LONGPRESS_ANTI_NOISE 1
+#endif
+#ifndef CONFIG_BUTTON_LONGPRESS_STATS
+#define CONFIG_BUTTON_LONGPRESS_STATS 1
+#endif
+#ifndef CONFIG_BUTTON_LONGPRESS_LOG
+#define CONFIG_BUTTON_LONGPRESS_LOG 1
+#endif
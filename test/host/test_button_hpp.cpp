@@ -0,0 +1,113 @@
+/**
+ * @file test_button_hpp.cpp
+ * @brief Host test of the C++17 Button front-end on the real component
+ */
+
+#include <memory>
+#include <utility>
+#include "button_longpress.hpp"
+#include "host_check.h"
+#include "host_rtos.h"
+
+using button_longpress::ButtonEvent;
+using button_longpress::Timings;
+
+static void click(int gpio_num)
+{
+    host_gpio_set_level(gpio_num, 1);
+    host_advance_ms(50);
+    host_gpio_set_level(gpio_num, 0);
+    host_advance_ms(400);
+}
+
+/* One handler type for every Button made here, capturing its counter */
+static auto make_counting_button(int &clicks)
+{
+    return button_longpress::make_button<GPIO_NUM_4, true, Timings<20, 1000, 300>>([&clicks](ButtonEvent event) {
+        if (event == ButtonEvent::Click) {
+            clicks++;
+        }
+    });
+}
+
+using CountingButton = decltype(make_counting_button(std::declval<int &>()));
+
+static_assert(!std::is_copy_assignable_v<CountingButton>);
+static_assert(std::is_nothrow_move_assignable_v<CountingButton>);
+
+static void test_move_assign_capturing_lambda()
+{
+    int clicks = 0;
+    CountingButton first = make_counting_button(clicks);
+    CHECK(static_cast<bool>(first));
+
+    /* Move-construct, then move-assign back into the moved-from object;
+     * each move waits for the timer service task to finish a dispatch */
+    host_calls_clear();
+    CountingButton second = std::move(first);
+    CHECK(!first && second);
+    CHECK(host_calls("xTimerPendFunctionCall") >= 1);
+    first = std::move(second);
+    CHECK(first && !second);
+
+    click(4);
+    CHECK(clicks == 1);
+
+    /* Assigning an empty Button deletes the one held */
+    first = std::move(second);
+    CHECK(!first);
+    click(4);
+    CHECK(clicks == 1);
+}
+
+static void test_move_assign_replaces_handler()
+{
+    int old_clicks = 0;
+    int new_clicks = 0;
+    CountingButton target = make_counting_button(old_clicks);
+    {
+        /* Deletes the first button, target keeps a moved-from handler */
+        CountingButton dropped = std::move(target);
+    }
+
+    target = make_counting_button(new_clicks);
+    CHECK(static_cast<bool>(target));
+
+    click(4);
+    CHECK(old_clicks == 0);
+    CHECK(new_clicks == 1);
+}
+
+static void test_move_only_handler_with_info()
+{
+    auto state = std::make_unique<uint32_t>(0);
+    const uint32_t *hold_ms = state.get();
+    auto handler = [state = std::move(state)](const button_event_info_t &info) {
+        if (info.event == BUTTON_EVENT_LONG_PRESS) {
+            *state = info.hold_time_ms;
+        }
+    };
+    using Handler = decltype(handler);
+    using MoveOnlyButton = button_longpress::Button<GPIO_NUM_5, true, Timings<>, Handler>;
+
+    MoveOnlyButton btn(std::move(handler));
+    MoveOnlyButton other = std::move(btn);
+    btn = std::move(other);
+    CHECK(static_cast<bool>(btn));
+
+    host_gpio_set_level(5, 1);
+    host_advance_ms(1200);
+    CHECK(btn.is_pressed());
+    CHECK(btn.state() == BUTTON_STATE_LONG_PRESS);
+    CHECK(*hold_ms >= 1000);
+    host_gpio_set_level(5, 0);
+    host_advance_ms(50);
+}
+
+int main()
+{
+    test_move_assign_capturing_lambda();
+    test_move_assign_replaces_handler();
+    test_move_only_handler_with_info();
+    return HOST_CHECK_EXIT();
+}
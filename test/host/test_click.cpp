@@ -0,0 +1,172 @@
+/**
+ * @file test_click.cpp
+ * @brief Host test of click, double click and long press on the real component
+ */
+
+#include <vector>
+#include "button_longpress.h"
+#include "host_check.h"
+#include "host_rtos.h"
+
+static std::vector<int> s_events;
+
+static void on_event(button_event_t event)
+{
+    s_events.push_back(event);
+}
+
+static button_handle_t create_button(gpio_num_t gpio_num, bool double_click_on_press)
+{
+    button_config_t config = {};
+    config.gpio_num = gpio_num;
+    config.active_level = true;
+    config.debounce_time_ms = 20;
+    config.long_press_time_ms = 1000;
+    config.double_click_time_ms = 300;
+    config.callback = on_event;
+    config.double_click_on_press = double_click_on_press;
+    return button_create(&config);
+}
+
+static void tap(int gpio_num, uint32_t hold_ms)
+{
+    host_gpio_set_level(gpio_num, 1);
+    host_advance_ms(hold_ms);
+    host_gpio_set_level(gpio_num, 0);
+}
+
+static bool saw(int event)
+{
+    for (int e : s_events) {
+        if (e == event) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void test_click()
+{
+    button_handle_t btn = create_button(GPIO_NUM_4, false);
+    CHECK(btn != nullptr);
+    s_events.clear();
+
+    tap(4, 50);
+    host_advance_ms(50);
+    CHECK((s_events == std::vector<int>{BUTTON_EVENT_PRESSED, BUTTON_EVENT_RELEASED}));
+
+    /* Reported once the double click window closes */
+    host_advance_ms(400);
+    CHECK((s_events == std::vector<int>{BUTTON_EVENT_PRESSED, BUTTON_EVENT_RELEASED, BUTTON_EVENT_CLICK}));
+    CHECK(button_get_state(btn) == BUTTON_STATE_IDLE);
+
+    button_delete(btn);
+}
+
+static void test_bounce_is_one_press()
+{
+    button_handle_t btn = create_button(GPIO_NUM_4, false);
+    s_events.clear();
+
+    for (int edge = 0; edge < 20; edge++) {
+        host_gpio_set_level(4, (edge + 1) & 1);
+        host_advance_ms(1);
+    }
+    host_gpio_set_level(4, 1);
+    host_advance_ms(50);
+    CHECK((s_events == std::vector<int>{BUTTON_EVENT_PRESSED}));
+    CHECK(button_is_pressed(btn));
+
+    host_gpio_set_level(4, 0);
+    host_advance_ms(400);
+    button_delete(btn);
+}
+
+static void test_double_click()
+{
+    button_handle_t btn = create_button(GPIO_NUM_4, false);
+    s_events.clear();
+
+    tap(4, 50);
+    host_advance_ms(100);
+    tap(4, 50);
+    host_advance_ms(50);
+    CHECK(saw(BUTTON_EVENT_DOUBLE_CLICK));
+    host_advance_ms(400);
+    CHECK(!saw(BUTTON_EVENT_CLICK));
+
+    button_delete(btn);
+}
+
+static void test_double_click_on_press()
+{
+    button_handle_t btn = create_button(GPIO_NUM_4, true);
+    s_events.clear();
+
+    tap(4, 50);
+    host_advance_ms(100);
+
+    /* Reported as soon as the second press is debounced */
+    host_gpio_set_level(4, 1);
+    host_advance_ms(50);
+    CHECK(saw(BUTTON_EVENT_DOUBLE_CLICK));
+    host_gpio_set_level(4, 0);
+    host_advance_ms(400);
+    CHECK(!saw(BUTTON_EVENT_CLICK));
+
+    button_delete(btn);
+}
+
+static void test_long_press()
+{
+    button_handle_t btn = create_button(GPIO_NUM_4, false);
+    s_events.clear();
+
+    host_gpio_set_level(4, 1);
+    host_advance_ms(900);
+    CHECK(!saw(BUTTON_EVENT_LONG_PRESS));
+    host_advance_ms(200);
+    CHECK(saw(BUTTON_EVENT_LONG_PRESS));
+    CHECK(button_get_state(btn) == BUTTON_STATE_LONG_PRESS);
+
+    host_gpio_set_level(4, 0);
+    host_advance_ms(400);
+    CHECK(!saw(BUTTON_EVENT_CLICK));
+
+    button_delete(btn);
+}
+
+static void test_consume_events()
+{
+    button_handle_t btn = create_button(GPIO_NUM_4, false);
+    button_events_t events;
+    CHECK(button_consume_events(btn, &events) == ESP_OK);
+
+    /* Two clicks latched between polls are both counted */
+    tap(4, 50);
+    host_advance_ms(400);
+    tap(4, 50);
+    host_advance_ms(400);
+    CHECK(button_consume_events(btn, &events) == ESP_OK);
+    CHECK(events.mask == (BUTTON_EVENT_MASK(BUTTON_EVENT_PRESSED) | BUTTON_EVENT_MASK(BUTTON_EVENT_RELEASED) |
+                          BUTTON_EVENT_MASK(BUTTON_EVENT_CLICK)));
+    CHECK(events.counts[BUTTON_EVENT_CLICK] == 2);
+    CHECK(events.counts[BUTTON_EVENT_PRESSED] == 2);
+
+    /* Fetching clears them */
+    CHECK(button_consume_events(btn, &events) == ESP_OK);
+    CHECK(events.mask == 0 && events.counts[BUTTON_EVENT_CLICK] == 0);
+
+    button_delete(btn);
+}
+
+int main()
+{
+    test_click();
+    test_bounce_is_one_press();
+    test_double_click();
+    test_double_click_on_press();
+    test_long_press();
+    test_consume_events();
+    return HOST_CHECK_EXIT();
+}
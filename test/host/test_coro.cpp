@@ -0,0 +1,200 @@
+/**
+ * @file test_coro.cpp
+ * @brief Host test of the C++20 coroutine front-end on the real component
+ */
+
+#include <vector>
+#include "button_longpress_coro.hpp"
+#include "host_check.h"
+#include "host_rtos.h"
+
+using button_longpress::ButtonEvent;
+using button_longpress::Flow;
+
+static button_handle_t create_button(gpio_num_t gpio_num)
+{
+    button_config_t config = {};
+    config.gpio_num = gpio_num;
+    config.active_level = true;
+    config.debounce_time_ms = 20;
+    config.long_press_time_ms = 1000;
+    config.double_click_time_ms = 300;
+    return button_create(&config);
+}
+
+static void press(int gpio_num)
+{
+    host_gpio_set_level(gpio_num, 1);
+    host_advance_ms(50);
+}
+
+static void release(int gpio_num)
+{
+    host_gpio_set_level(gpio_num, 0);
+    host_advance_ms(50);
+}
+
+static Flow click_then_long_press(button_handle_t btn, std::vector<int> &log)
+{
+    auto click = co_await button_longpress::next(btn, ButtonEvent::Click);
+    log.push_back(click ? click->event : -1);
+    auto hold = co_await button_longpress::next(btn, ButtonEvent::LongPress);
+    log.push_back(hold ? hold->event : -1);
+}
+
+static void test_flow_follows_events()
+{
+    button_handle_t btn = create_button(GPIO_NUM_4);
+    CHECK(btn != nullptr);
+    std::vector<int> log;
+
+    click_then_long_press(btn, log);
+    CHECK(log.empty());
+
+    /* Press and release are not awaited */
+    press(4);
+    release(4);
+    CHECK(log.empty());
+
+    /* The click is reported once the double click window closes */
+    host_advance_ms(400);
+    CHECK(log.size() == 1 && log[0] == BUTTON_EVENT_CLICK);
+
+    press(4);
+    host_advance_ms(1000);
+    release(4);
+    CHECK(log.size() == 2 && log[1] == BUTTON_EVENT_LONG_PRESS);
+
+    button_delete(btn);
+}
+
+static Flow wait_with_timeout(button_handle_t btn, TickType_t timeout, int &result)
+{
+    auto event = co_await button_longpress::next(btn, ButtonEvent::DoubleClick, timeout);
+    result = event ? event->event : -1;
+}
+
+static void test_timeout_resumes_empty()
+{
+    button_handle_t btn = create_button(GPIO_NUM_5);
+    int result = -2;
+
+    wait_with_timeout(btn, pdMS_TO_TICKS(500), result);
+    host_advance_ms(400);
+    CHECK(result == -2);
+    host_advance_ms(200);
+    CHECK(result == -1);
+
+    button_delete(btn);
+}
+
+static Flow count_presses(button_handle_t btn, int &count)
+{
+    for (;;) {
+        auto event = co_await button_longpress::next(btn, ButtonEvent::Pressed, pdMS_TO_TICKS(1000));
+        if (!event) {
+            co_return;
+        }
+        count++;
+    }
+}
+
+static void test_event_completes_each_wait_once()
+{
+    /* More flows than completions the dispatch path used to batch: each
+     * flow re-registers from inside the wakeup and must not be completed
+     * again with the same press */
+    constexpr int flows = 12;
+    button_handle_t btn = create_button(GPIO_NUM_6);
+    int counts[flows] = {};
+
+    for (int i = 0; i < flows; i++) {
+        count_presses(btn, counts[i]);
+    }
+
+    press(6);
+    for (int i = 0; i < flows; i++) {
+        CHECK(counts[i] == 1);
+    }
+    release(6);
+
+    press(6);
+    for (int i = 0; i < flows; i++) {
+        CHECK(counts[i] == 2);
+    }
+    release(6);
+
+    /* Let every flow time out and return before the counters go away */
+    host_advance_ms(1500);
+    button_delete(btn);
+}
+
+static Flow button_next(button_longpress::Button<GPIO_NUM_7, true, button_longpress::Timings<>, void (*)(ButtonEvent)> &btn,
+                        int &result)
+{
+    auto event = co_await btn.next(ButtonEvent::Released);
+    result = event ? event->event : -1;
+}
+
+static void test_button_next()
+{
+    button_longpress::Button<GPIO_NUM_7, true, button_longpress::Timings<>, void (*)(ButtonEvent)> btn(
+        [](ButtonEvent) {});
+    CHECK(static_cast<bool>(btn));
+    int result = -2;
+
+    button_next(btn, result);
+    press(7);
+    CHECK(result == -2);
+    release(7);
+    CHECK(result == BUTTON_EVENT_RELEASED);
+}
+
+/* Coroutine that can be destroyed while suspended, unlike Flow */
+struct Task {
+    struct promise_type {
+        Task get_return_object() noexcept
+        {
+            return Task{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept {}
+    };
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+static Task await_click(button_handle_t btn, bool &resumed)
+{
+    co_await button_longpress::next(btn, ButtonEvent::Click, pdMS_TO_TICKS(1000));
+    resumed = true;
+}
+
+static void test_destroy_cancels_wait()
+{
+    button_handle_t btn = create_button(GPIO_NUM_8);
+    bool resumed = false;
+
+    Task task = await_click(btn, resumed);
+    task.handle.destroy();
+
+    /* Neither the event nor the timeout may touch the freed frame */
+    press(8);
+    release(8);
+    host_advance_ms(1500);
+    CHECK(!resumed);
+
+    button_delete(btn);
+}
+
+int main()
+{
+    test_flow_follows_events();
+    test_timeout_resumes_empty();
+    test_event_completes_each_wait_once();
+    test_button_next();
+    test_destroy_cancels_wait();
+    return HOST_CHECK_EXIT();
+}
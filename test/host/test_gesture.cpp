@@ -0,0 +1,98 @@
+/**
+ * @file test_gesture.cpp
+ * @brief Host test of gesture recognition on the real component
+ */
+
+#include <vector>
+#include "button_longpress.h"
+#include "host_check.h"
+#include "host_rtos.h"
+
+static std::vector<int> s_gestures;
+
+static void on_event(const button_event_info_t *info, void *user_ctx)
+{
+    if (info->event == BUTTON_EVENT_GESTURE) {
+        s_gestures.push_back(info->gesture);
+    }
+}
+
+static const button_gesture_token_t s_triple[] = {
+    BUTTON_GESTURE_GAP, BUTTON_GESTURE_SHORT, BUTTON_GESTURE_SHORT, BUTTON_GESTURE_SHORT, BUTTON_GESTURE_GAP,
+};
+static const button_gesture_token_t s_short_long[] = {BUTTON_GESTURE_SHORT, BUTTON_GESTURE_LONG};
+static const button_gesture_t s_patterns[] = {
+    {s_triple, 5},
+    {s_short_long, 2},
+};
+
+static button_handle_t create_button(gpio_num_t gpio_num)
+{
+    button_config_t config = {};
+    config.gpio_num = gpio_num;
+    config.active_level = true;
+    config.debounce_time_ms = 20;
+    config.long_press_time_ms = 1000;
+    config.double_click_time_ms = 300;
+    config.event_callback = on_event;
+    config.gestures = s_patterns;
+    config.gesture_count = 2;
+    return button_create(&config);
+}
+
+static void tap(int gpio_num, uint32_t hold_ms, uint32_t gap_ms)
+{
+    host_gpio_set_level(gpio_num, 1);
+    host_advance_ms(hold_ms);
+    host_gpio_set_level(gpio_num, 0);
+    host_advance_ms(gap_ms);
+}
+
+static void test_anchored_sequence()
+{
+    button_handle_t btn = create_button(GPIO_NUM_4);
+    CHECK(btn != nullptr);
+    s_gestures.clear();
+
+    /* Exactly three taps, recognized once the gap closes the sequence */
+    tap(4, 50, 100);
+    tap(4, 50, 100);
+    tap(4, 50, 100);
+    CHECK(s_gestures.empty());
+    host_advance_ms(400);
+    CHECK((s_gestures == std::vector<int>{0}));
+
+    /* Four taps do not match the anchored pattern */
+    s_gestures.clear();
+    for (int i = 0; i < 4; i++) {
+        tap(4, 50, 100);
+    }
+    host_advance_ms(400);
+    CHECK(s_gestures.empty());
+
+    button_delete(btn);
+}
+
+static void test_short_then_long()
+{
+    button_handle_t btn = create_button(GPIO_NUM_4);
+    s_gestures.clear();
+
+    tap(4, 50, 100);
+    host_gpio_set_level(4, 1);
+    host_advance_ms(1100);
+    CHECK((s_gestures == std::vector<int>{1}));
+
+    host_gpio_set_level(4, 0);
+    host_advance_ms(400);
+    CHECK((s_gestures == std::vector<int>{1}));
+
+    button_delete(btn);
+}
+
+int main()
+{
+    test_anchored_sequence();
+    test_short_then_long();
+    return HOST_CHECK_EXIT();
+}
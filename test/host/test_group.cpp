@@ -0,0 +1,165 @@
+/**
+ * @file test_group.cpp
+ * @brief Host test of button groups and chords on the real component
+ */
+
+#include "button_longpress.h"
+#include "host_check.h"
+#include "host_rtos.h"
+
+struct Counts {
+    int pressed = 0;
+    int released = 0;
+};
+
+static Counts s_counts[GPIO_NUM_MAX];
+static int s_chords[BUTTON_GROUP_MAX_CHORDS];
+
+static void on_event(const button_event_info_t *info, void *user_ctx)
+{
+    Counts *counts = static_cast<Counts *>(user_ctx);
+    if (info->event == BUTTON_EVENT_PRESSED) {
+        counts->pressed++;
+    } else if (info->event == BUTTON_EVENT_RELEASED) {
+        counts->released++;
+    }
+}
+
+static void on_chord(const button_event_info_t *info, void *user_ctx)
+{
+    CHECK(info->event == BUTTON_EVENT_CHORD);
+    s_chords[info->chord]++;
+}
+
+static void reset_counts()
+{
+    for (Counts &counts : s_counts) {
+        counts = Counts();
+    }
+    for (int &chord : s_chords) {
+        chord = 0;
+    }
+}
+
+static button_handle_t create_member(button_group_handle_t group, gpio_num_t gpio_num)
+{
+    button_config_t config = {};
+    config.gpio_num = gpio_num;
+    config.active_level = true;
+    config.debounce_time_ms = 20;
+    config.long_press_time_ms = 1000;
+    config.double_click_time_ms = 300;
+    config.event_callback = on_event;
+    config.user_ctx = &s_counts[gpio_num];
+    config.group = group;
+    return button_create(&config);
+}
+
+static void test_pressed_mask_near_simultaneous()
+{
+    button_group_handle_t group = button_group_create();
+    button_handle_t a = create_member(group, GPIO_NUM_4);
+    button_handle_t b = create_member(group, GPIO_NUM_5);
+    button_handle_t c = create_member(group, GPIO_NUM_6);
+    CHECK(button_group_get_pressed_mask(group) == 0);
+
+    /* The bitmap must follow the pins even when edges share a debounce window */
+    host_gpio_set_level(4, 1);
+    host_advance_ms(3);
+    host_gpio_set_level(5, 1);
+    host_advance_ms(4);
+    host_gpio_set_level(6, 1);
+    host_advance_ms(50);
+    CHECK(button_group_get_pressed_mask(group) == 0x7);
+
+    host_gpio_set_level(5, 0);
+    host_advance_ms(5);
+    host_gpio_set_level(6, 0);
+    host_advance_ms(50);
+    CHECK(button_group_get_pressed_mask(group) == 0x1);
+
+    host_gpio_set_level(4, 0);
+    host_advance_ms(400);
+    CHECK(button_group_get_pressed_mask(group) == 0);
+
+    button_delete(a);
+    button_delete(b);
+    button_delete(c);
+    CHECK(button_group_delete(group) == ESP_OK);
+}
+
+static void test_hold_chord_near_simultaneous()
+{
+    button_group_handle_t group = button_group_create();
+    button_handle_t a = create_member(group, GPIO_NUM_4);
+    button_handle_t b = create_member(group, GPIO_NUM_5);
+    CHECK(a != nullptr && b != nullptr);
+
+    button_chord_t chord = {};
+    chord.hold_mask = 0x3;
+    chord.window_ms = 100;
+    CHECK(button_group_set_chords(group, &chord, 1, on_chord, nullptr) == ESP_OK);
+
+    /* Second member pressed within the first one's debounce and anti-noise windows */
+    for (uint32_t gap_ms = 0; gap_ms <= 10; gap_ms += 5) {
+        reset_counts();
+        host_gpio_set_level(4, 1);
+        host_advance_ms(gap_ms);
+        host_gpio_set_level(5, 1);
+        host_advance_ms(50);
+
+        CHECK(s_counts[4].pressed == 1 && s_counts[5].pressed == 1);
+        CHECK(button_is_pressed(a) && button_is_pressed(b));
+        CHECK(button_group_get_pressed_mask(group) == 0x3);
+        CHECK(s_chords[0] == 1);
+
+        host_gpio_set_level(4, 0);
+        host_gpio_set_level(5, 0);
+        host_advance_ms(400);
+        CHECK(s_counts[4].released == 1 && s_counts[5].released == 1);
+        CHECK(s_chords[0] == 1);
+    }
+
+    button_delete(a);
+    button_delete(b);
+    CHECK(button_group_delete(group) == ESP_OK);
+}
+
+static void test_click_chord_near_simultaneous()
+{
+    button_group_handle_t group = button_group_create();
+    button_handle_t a = create_member(group, GPIO_NUM_4);
+    button_handle_t b = create_member(group, GPIO_NUM_5);
+
+    button_chord_t chord = {};
+    chord.hold_mask = 0x1;
+    chord.click_mask = 0x2;
+    chord.window_ms = 500;
+    CHECK(button_group_set_chords(group, &chord, 1, on_chord, nullptr) == ESP_OK);
+
+    /* Hold A, click B right after A's press settles */
+    reset_counts();
+    host_gpio_set_level(4, 1);
+    host_advance_ms(20);
+    host_gpio_set_level(5, 1);
+    host_advance_ms(50);
+    CHECK(s_counts[5].pressed == 1);
+    host_gpio_set_level(5, 0);
+    host_advance_ms(50);
+    CHECK(s_chords[0] == 1);
+
+    host_gpio_set_level(4, 0);
+    host_advance_ms(400);
+
+    button_delete(a);
+    button_delete(b);
+    CHECK(button_group_delete(group) == ESP_OK);
+}
+
+int main()
+{
+    test_pressed_mask_near_simultaneous();
+    test_hold_chord_near_simultaneous();
+    test_click_chord_near_simultaneous();
+    return HOST_CHECK_EXIT();
+}
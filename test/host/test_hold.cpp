@@ -0,0 +1,178 @@
+/**
+ * @file test_hold.cpp
+ * @brief Host test of hold events on the real component
+ */
+
+#include <vector>
+#include "button_longpress.h"
+#include "host_check.h"
+#include "host_rtos.h"
+
+static std::vector<button_event_info_t> s_events;
+
+static void on_event(const button_event_info_t *info, void *user_ctx)
+{
+    s_events.push_back(*info);
+}
+
+static button_config_t base_config(gpio_num_t gpio_num)
+{
+    button_config_t config = {};
+    config.gpio_num = gpio_num;
+    config.active_level = true;
+    config.debounce_time_ms = 20;
+    config.long_press_time_ms = 1000;
+    config.double_click_time_ms = 300;
+    config.event_callback = on_event;
+    return config;
+}
+
+static std::vector<button_event_info_t> events_of(button_event_t event)
+{
+    std::vector<button_event_info_t> found;
+    for (const button_event_info_t &info : s_events) {
+        if (info.event == event) {
+            found.push_back(info);
+        }
+    }
+    return found;
+}
+
+static void test_hold_stages()
+{
+    static const uint32_t stages[] = {500, 2000, 3000};
+    button_config_t config = base_config(GPIO_NUM_4);
+    config.hold_stages_ms = stages;
+    config.hold_stage_count = 3;
+    button_handle_t btn = button_create(&config);
+    CHECK(btn != nullptr);
+    s_events.clear();
+
+    host_gpio_set_level(4, 1);
+    host_advance_ms(20 + 600);
+    CHECK(events_of(BUTTON_EVENT_HOLD_STAGE).size() == 1);
+    CHECK(events_of(BUTTON_EVENT_LONG_PRESS).empty());
+
+    host_advance_ms(1600);
+    auto held = events_of(BUTTON_EVENT_HOLD_STAGE);
+    CHECK(held.size() == 2);
+    CHECK(events_of(BUTTON_EVENT_LONG_PRESS).size() == 1);
+
+    host_advance_ms(1000);
+    held = events_of(BUTTON_EVENT_HOLD_STAGE);
+    CHECK(held.size() == 3);
+    for (size_t i = 0; i < held.size(); i++) {
+        CHECK(held[i].stage == i);
+        CHECK(held[i].hold_time_ms >= stages[i]);
+    }
+
+    /* Each stage is reported once per hold, and again on the next hold */
+    host_gpio_set_level(4, 0);
+    host_advance_ms(400);
+    host_gpio_set_level(4, 1);
+    host_advance_ms(20 + 600);
+    CHECK(events_of(BUTTON_EVENT_HOLD_STAGE).size() == 4);
+
+    host_gpio_set_level(4, 0);
+    host_advance_ms(400);
+    button_delete(btn);
+}
+
+static void test_release_before_stage()
+{
+    static const uint32_t stages[] = {500};
+    button_config_t config = base_config(GPIO_NUM_4);
+    config.hold_stages_ms = stages;
+    config.hold_stage_count = 1;
+    button_handle_t btn = button_create(&config);
+    s_events.clear();
+
+    host_gpio_set_level(4, 1);
+    host_advance_ms(300);
+    host_gpio_set_level(4, 0);
+    host_advance_ms(1000);
+    CHECK(events_of(BUTTON_EVENT_HOLD_STAGE).empty());
+    CHECK(events_of(BUTTON_EVENT_CLICK).size() == 1);
+
+    button_delete(btn);
+}
+
+static void test_accelerated_repeat()
+{
+    button_config_t config = base_config(GPIO_NUM_4);
+    config.repeat_interval_ms = 200;
+    config.repeat_delay_ms = 500;
+    config.repeat_min_interval_ms = 50;
+    config.repeat_accel_percent = 50;
+    button_handle_t btn = button_create(&config);
+    s_events.clear();
+
+    host_gpio_set_level(4, 1);
+    host_advance_ms(20 + 480);
+    CHECK(events_of(BUTTON_EVENT_REPEAT).empty());
+
+    /* Repeats at 500, 700, 800, 850 and 900 ms: the interval halves down to 50 ms */
+    host_advance_ms(420);
+    auto repeats = events_of(BUTTON_EVENT_REPEAT);
+    CHECK(repeats.size() == 5);
+    static const uint32_t gaps[] = {200, 100, 50, 50};
+    for (size_t i = 0; i < repeats.size(); i++) {
+        CHECK(repeats[i].repeat_count == i + 1);
+        if (i > 0) {
+            CHECK(repeats[i].hold_time_ms - repeats[i - 1].hold_time_ms == gaps[i - 1]);
+        }
+    }
+
+    /* A repeating press is not a click, the next hold starts counting again */
+    host_gpio_set_level(4, 0);
+    host_advance_ms(400);
+    CHECK(events_of(BUTTON_EVENT_CLICK).empty());
+    s_events.clear();
+    host_gpio_set_level(4, 1);
+    host_advance_ms(20 + 510);
+    repeats = events_of(BUTTON_EVENT_REPEAT);
+    CHECK(repeats.size() == 1 && repeats[0].repeat_count == 1);
+
+    host_gpio_set_level(4, 0);
+    host_advance_ms(400);
+    button_delete(btn);
+}
+
+static void test_hold_progress()
+{
+    button_config_t config = base_config(GPIO_NUM_4);
+    config.hold_progress_interval_ms = 250;
+    button_handle_t btn = button_create(&config);
+    s_events.clear();
+
+    host_gpio_set_level(4, 1);
+    host_advance_ms(20 + 2000);
+    auto progress = events_of(BUTTON_EVENT_HOLD_PROGRESS);
+    CHECK(progress.size() == 3);
+    for (size_t i = 0; i < progress.size(); i++) {
+        CHECK(progress[i].hold_time_ms == 250 * (i + 1));
+        CHECK(progress[i].target_ms == 1000);
+    }
+    CHECK(events_of(BUTTON_EVENT_LONG_PRESS).size() == 1);
+
+    /* A short press stops the progress with the release */
+    host_gpio_set_level(4, 0);
+    host_advance_ms(400);
+    s_events.clear();
+    host_gpio_set_level(4, 1);
+    host_advance_ms(20 + 400);
+    host_gpio_set_level(4, 0);
+    host_advance_ms(1000);
+    CHECK(events_of(BUTTON_EVENT_HOLD_PROGRESS).size() == 1);
+
+    button_delete(btn);
+}
+
+int main()
+{
+    test_hold_stages();
+    test_release_before_stage();
+    test_accelerated_repeat();
+    test_hold_progress();
+    return HOST_CHECK_EXIT();
+}
@@ -0,0 +1,105 @@
+/**
+ * @file test_reconfig.cpp
+ * @brief Host test of runtime reconfiguration on the real component
+ */
+
+#include <vector>
+#include "button_longpress.h"
+#include "host_check.h"
+#include "host_rtos.h"
+
+static std::vector<int> s_first;
+static std::vector<int> s_second;
+
+static void on_first(button_event_t event)
+{
+    s_first.push_back(event);
+}
+
+static void on_second(button_event_t event)
+{
+    s_second.push_back(event);
+}
+
+static bool saw(const std::vector<int> &events, int event)
+{
+    for (int e : events) {
+        if (e == event) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static button_handle_t create_button(gpio_num_t gpio_num)
+{
+    button_config_t config = {};
+    config.gpio_num = gpio_num;
+    config.active_level = true;
+    config.debounce_time_ms = 20;
+    config.long_press_time_ms = 1000;
+    config.double_click_time_ms = 300;
+    config.callback = on_first;
+    return button_create(&config);
+}
+
+static void test_long_press_time_applies_to_held_press()
+{
+    button_handle_t btn = create_button(GPIO_NUM_4);
+    s_first.clear();
+
+    host_gpio_set_level(4, 1);
+    host_advance_ms(500);
+    CHECK(button_set_timings(btn, 20, 3000, 300) == ESP_OK);
+    host_advance_ms(1000);
+    CHECK(!saw(s_first, BUTTON_EVENT_LONG_PRESS));
+    host_advance_ms(1600);
+    CHECK(saw(s_first, BUTTON_EVENT_LONG_PRESS));
+
+    host_gpio_set_level(4, 0);
+    host_advance_ms(400);
+    button_delete(btn);
+}
+
+static void test_active_level_resamples()
+{
+    button_handle_t btn = create_button(GPIO_NUM_4);
+    s_first.clear();
+
+    /* A released active-high button reads as pressed once active low */
+    CHECK(button_set_active_level(btn, false) == ESP_OK);
+    host_advance_ms(50);
+    CHECK(saw(s_first, BUTTON_EVENT_PRESSED));
+    CHECK(button_is_pressed(btn));
+
+    host_gpio_set_level(4, 1);
+    host_advance_ms(50);
+    CHECK(!button_is_pressed(btn));
+    host_advance_ms(400);
+    button_delete(btn);
+}
+
+static void test_callback_replaced()
+{
+    button_handle_t btn = create_button(GPIO_NUM_4);
+    s_first.clear();
+    s_second.clear();
+
+    CHECK(button_set_callback(btn, on_second) == ESP_OK);
+    host_gpio_set_level(4, 1);
+    host_advance_ms(50);
+    host_gpio_set_level(4, 0);
+    host_advance_ms(400);
+    CHECK(s_first.empty());
+    CHECK(saw(s_second, BUTTON_EVENT_CLICK));
+
+    button_delete(btn);
+}
+
+int main()
+{
+    test_long_press_time_applies_to_held_press();
+    test_active_level_resamples();
+    test_callback_replaced();
+    return HOST_CHECK_EXIT();
+}
@@ -0,0 +1,139 @@
+/**
+ * @file test_suspend.cpp
+ * @brief Host test of suspend and resume on the real component
+ */
+
+#include <vector>
+#include "button_longpress.h"
+#include "host_check.h"
+#include "host_rtos.h"
+
+static std::vector<int> s_events;
+
+static void on_event(button_event_t event)
+{
+    s_events.push_back(event);
+}
+
+static button_handle_t create_button(gpio_num_t gpio_num, button_group_handle_t group = nullptr)
+{
+    button_config_t config = {};
+    config.gpio_num = gpio_num;
+    config.active_level = true;
+    config.debounce_time_ms = 20;
+    config.long_press_time_ms = 1000;
+    config.double_click_time_ms = 300;
+    config.callback = on_event;
+    config.group = group;
+    return button_create(&config);
+}
+
+static int count(int event)
+{
+    int n = 0;
+    for (int e : s_events) {
+        n += (e == event);
+    }
+    return n;
+}
+
+static void test_suspended_button_is_silent()
+{
+    button_handle_t btn = create_button(GPIO_NUM_4);
+    s_events.clear();
+
+    CHECK(button_suspend(btn) == ESP_OK);
+    host_gpio_set_level(4, 1);
+    host_advance_ms(50);
+    host_gpio_set_level(4, 0);
+    host_advance_ms(1500);
+    CHECK(s_events.empty());
+
+    /* Nothing changed meanwhile, so resuming reports nothing */
+    CHECK(button_resume(btn) == ESP_OK);
+    host_advance_ms(50);
+    CHECK(s_events.empty());
+
+    button_delete(btn);
+}
+
+static void test_resume_resamples()
+{
+    button_handle_t btn = create_button(GPIO_NUM_4);
+    s_events.clear();
+
+    CHECK(button_suspend(btn) == ESP_OK);
+    host_gpio_set_level(4, 1);
+    host_advance_ms(100);
+    CHECK(button_resume(btn) == ESP_OK);
+    host_advance_ms(50);
+    CHECK(count(BUTTON_EVENT_PRESSED) == 1);
+    CHECK(button_is_pressed(btn));
+
+    host_gpio_set_level(4, 0);
+    host_advance_ms(50);
+    CHECK(count(BUTTON_EVENT_RELEASED) == 1);
+    host_advance_ms(400);
+    button_delete(btn);
+}
+
+static void test_long_press_held_through_suspend()
+{
+    button_handle_t btn = create_button(GPIO_NUM_4);
+    s_events.clear();
+
+    host_gpio_set_level(4, 1);
+    host_advance_ms(200);
+    CHECK(count(BUTTON_EVENT_PRESSED) == 1);
+
+    CHECK(button_suspend(btn) == ESP_OK);
+    host_advance_ms(2000);
+    CHECK(count(BUTTON_EVENT_LONG_PRESS) == 0);
+
+    /* The suspended time counts towards the hold */
+    CHECK(button_resume(btn) == ESP_OK);
+    host_advance_ms(10);
+    CHECK(count(BUTTON_EVENT_LONG_PRESS) == 1);
+    CHECK(count(BUTTON_EVENT_PRESSED) == 1);
+
+    host_gpio_set_level(4, 0);
+    host_advance_ms(400);
+    CHECK(count(BUTTON_EVENT_CLICK) == 0);
+    button_delete(btn);
+}
+
+static void test_group_suspend()
+{
+    button_group_handle_t group = button_group_create();
+    button_handle_t a = create_button(GPIO_NUM_4, group);
+    button_handle_t b = create_button(GPIO_NUM_5, group);
+    s_events.clear();
+
+    CHECK(button_group_suspend(group) == ESP_OK);
+    host_gpio_set_level(4, 1);
+    host_gpio_set_level(5, 1);
+    host_advance_ms(100);
+    CHECK(s_events.empty());
+    CHECK(button_group_get_pressed_mask(group) == 0);
+
+    CHECK(button_group_resume(group) == ESP_OK);
+    host_advance_ms(50);
+    CHECK(count(BUTTON_EVENT_PRESSED) == 2);
+    CHECK(button_group_get_pressed_mask(group) == 0x3);
+
+    host_gpio_set_level(4, 0);
+    host_gpio_set_level(5, 0);
+    host_advance_ms(400);
+    button_delete(a);
+    button_delete(b);
+    CHECK(button_group_delete(group) == ESP_OK);
+}
+
+int main()
+{
+    test_suspended_button_is_silent();
+    test_resume_resamples();
+    test_long_press_held_through_suspend();
+    test_group_suspend();
+    return HOST_CHECK_EXIT();
+}
@@ -0,0 +1,149 @@
+/**
+ * @file test_wait.cpp
+ * @brief Host test of button_wait_event() and button_wait_event_async() on the real component
+ */
+
+#include "button_longpress.h"
+#include "freertos/timers.h"
+#include "host_check.h"
+#include "host_rtos.h"
+
+/* Pin levels applied by a timer while the test task is blocked */
+struct Step {
+    uint32_t after_ms;
+    int gpio_num;
+    int level;
+};
+
+static const Step *s_script;
+static size_t s_script_len;
+static size_t s_script_pos;
+static TimerHandle_t s_script_timer;
+
+static void script_cb(TimerHandle_t timer)
+{
+    const Step &step = s_script[s_script_pos++];
+    host_gpio_set_level(step.gpio_num, step.level);
+    if (s_script_pos < s_script_len) {
+        xTimerChangePeriod(timer, pdMS_TO_TICKS(s_script[s_script_pos].after_ms), 0);
+    }
+}
+
+static void play(const Step *script, size_t len)
+{
+    s_script = script;
+    s_script_len = len;
+    s_script_pos = 0;
+    xTimerChangePeriod(s_script_timer, pdMS_TO_TICKS(script[0].after_ms), 0);
+}
+
+static button_handle_t create_button(gpio_num_t gpio_num)
+{
+    button_config_t config = {};
+    config.gpio_num = gpio_num;
+    config.active_level = true;
+    config.debounce_time_ms = 20;
+    config.long_press_time_ms = 1000;
+    config.double_click_time_ms = 300;
+    return button_create(&config);
+}
+
+static void test_wait_for_click()
+{
+    button_handle_t a = create_button(GPIO_NUM_4);
+    button_handle_t b = create_button(GPIO_NUM_5);
+    static const Step click_b[] = {{50, 5, 1}, {50, 5, 0}};
+
+    /* Press and release go by while waiting, only the click completes the wait */
+    play(click_b, 2);
+    button_handle_t handles[] = {a, b};
+    button_event_info_t info = {};
+    TickType_t start = xTaskGetTickCount();
+    CHECK(button_wait_event(handles, 2, BUTTON_EVENT_MASK(BUTTON_EVENT_CLICK), pdMS_TO_TICKS(2000), &info) == ESP_OK);
+    CHECK(info.event == BUTTON_EVENT_CLICK && info.button == b);
+    CHECK(xTaskGetTickCount() - start < pdMS_TO_TICKS(1000));
+
+    button_delete(a);
+    button_delete(b);
+}
+
+static void test_wait_filters_buttons()
+{
+    button_handle_t a = create_button(GPIO_NUM_4);
+    button_handle_t b = create_button(GPIO_NUM_5);
+    static const Step press_b[] = {{50, 5, 1}, {100, 5, 0}};
+
+    play(press_b, 2);
+    button_event_info_t info = {};
+    TickType_t start = xTaskGetTickCount();
+    CHECK(button_wait_event(&a, 1, 0, pdMS_TO_TICKS(500), &info) == ESP_ERR_TIMEOUT);
+    CHECK(xTaskGetTickCount() - start == pdMS_TO_TICKS(500));
+
+    /* Events that occurred while nobody waited are not queued */
+    CHECK(button_wait_event(nullptr, 0, 0, pdMS_TO_TICKS(500), &info) == ESP_ERR_TIMEOUT);
+
+    host_advance_ms(400);
+    button_delete(a);
+    button_delete(b);
+}
+
+struct AsyncResult {
+    int calls = 0;
+    bool timed_out = false;
+    button_event_t event = BUTTON_EVENT_MAX;
+};
+
+static void on_async(const button_event_info_t *info, void *ctx)
+{
+    AsyncResult *result = static_cast<AsyncResult *>(ctx);
+    result->calls++;
+    result->timed_out = (info == nullptr);
+    if (info != nullptr) {
+        result->event = info->event;
+    }
+}
+
+static void test_async_wait()
+{
+    button_handle_t a = create_button(GPIO_NUM_4);
+    button_wait_t event_wait;
+    button_wait_t timed_wait;
+    button_wait_t cancelled_wait;
+    AsyncResult event_result;
+    AsyncResult timed_result;
+    AsyncResult cancelled_result;
+
+    CHECK(button_wait_event_async(&event_wait, &a, 1, BUTTON_EVENT_MASK(BUTTON_EVENT_PRESSED), portMAX_DELAY,
+                                  on_async, &event_result) == ESP_OK);
+    CHECK(button_wait_event_async(&timed_wait, &a, 1, BUTTON_EVENT_MASK(BUTTON_EVENT_LONG_PRESS),
+                                  pdMS_TO_TICKS(300), on_async, &timed_result) == ESP_OK);
+    CHECK(button_wait_event_async(&cancelled_wait, nullptr, 0, 0, pdMS_TO_TICKS(300), on_async,
+                                  &cancelled_result) == ESP_OK);
+    CHECK(button_wait_event_cancel(&cancelled_wait));
+
+    host_gpio_set_level(4, 1);
+    host_advance_ms(50);
+    CHECK(event_result.calls == 1 && event_result.event == BUTTON_EVENT_PRESSED);
+    CHECK(timed_result.calls == 0);
+    CHECK(!button_wait_event_cancel(&event_wait));
+
+    host_advance_ms(300);
+    CHECK(timed_result.calls == 1 && timed_result.timed_out);
+    CHECK(cancelled_result.calls == 0);
+
+    host_gpio_set_level(4, 0);
+    host_advance_ms(400);
+    CHECK(event_result.calls == 1);
+    button_delete(a);
+}
+
+int main()
+{
+    s_script_timer = xTimerCreate("script", 1, pdFALSE, nullptr, script_cb);
+    CHECK(s_script_timer != nullptr);
+
+    test_wait_for_click();
+    test_wait_filters_buttons();
+    test_async_wait();
+    return HOST_CHECK_EXIT();
+}
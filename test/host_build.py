@@ -0,0 +1,98 @@
+"""
+Host build of the real component sources against the simulated kernel in host/
+
+The mock in button_longpress.py models the component in Python. Tests that
+must exercise the C and C++ code itself compile it here with the system gcc
+and g++, linked with host/host_rtos.c instead of ESP-IDF and FreeRTOS. The
+tests are skipped when no compiler or no component sources are available
+(e.g. inside the test-only Docker image).
+"""
+import functools
+import os
+import shutil
+import subprocess
+import tempfile
+
+TEST_DIR = os.path.dirname(os.path.abspath(__file__))
+HOST_DIR = os.path.join(TEST_DIR, "host")
+COMPONENT_DIR = os.path.join(os.path.dirname(TEST_DIR), "button_longpress")
+
+C_SOURCES = (
+    os.path.join(COMPONENT_DIR, "button_longpress.c"),
+    os.path.join(COMPONENT_DIR, "button_gesture.c"),
+    os.path.join(HOST_DIR, "host_rtos.c"),
+)
+
+INCLUDE_DIRS = (
+    os.path.join(HOST_DIR, "include"),
+    HOST_DIR,
+    os.path.join(COMPONENT_DIR, "include"),
+    os.path.join(COMPONENT_DIR, "private_include"),
+)
+
+WARNINGS = ("-Wall", "-Wextra", "-Wno-unused-parameter")
+SANITIZERS = ("-fsanitize=address,undefined", "-fno-omit-frame-pointer")
+
+
+def unavailable():
+    """Reason the host build cannot run, or None"""
+    if shutil.which("gcc") is None or shutil.which("g++") is None:
+        return "gcc/g++ not found"
+    if not os.path.isfile(C_SOURCES[0]):
+        return "component sources not found"
+    return None
+
+
+@functools.lru_cache(maxsize=None)
+def _build_dir():
+    return tempfile.mkdtemp(prefix="button_longpress_host_")
+
+
+@functools.lru_cache(maxsize=None)
+def _sanitizers():
+    """Sanitizer flags if the toolchain supports them"""
+    probe = os.path.join(_build_dir(), "probe")
+    result = subprocess.run(["gcc", *SANITIZERS, "-x", "c", "-", "-o", probe],
+                            input="int main(void) { return 0; }", text=True, capture_output=True)
+    return SANITIZERS if result.returncode == 0 else ()
+
+
+def _compile(args):
+    result = subprocess.run(args, capture_output=True, text=True)
+    if result.returncode != 0:
+        raise RuntimeError("host build failed:\n" + " ".join(args) + "\n" + result.stderr)
+
+
+def _flags(defines):
+    return [*WARNINGS, "-g", *(f"-I{d}" for d in INCLUDE_DIRS), *(f"-D{d}" for d in defines)]
+
+
+@functools.lru_cache(maxsize=None)
+def build_program(source, std="c++20", defines=()):
+    """Compile a C++ test program from host/ with the component, returns its path"""
+    name = os.path.splitext(source)[0] + "".join("_" + d.split("=")[0] for d in defines)
+    out_dir = os.path.join(_build_dir(), name)
+    os.makedirs(out_dir, exist_ok=True)
+    objects = []
+    for c_source in C_SOURCES:
+        obj = os.path.join(out_dir, os.path.basename(c_source) + ".o")
+        _compile(["gcc", "-std=gnu17", *_flags(defines), *_sanitizers(), "-c", c_source, "-o", obj])
+        objects.append(obj)
+    program = os.path.join(out_dir, name)
+    _compile(["g++", f"-std={std}", *_flags(defines), *_sanitizers(),
+              os.path.join(HOST_DIR, source), *objects, "-o", program])
+    return program
+
+
+@functools.lru_cache(maxsize=None)
+def build_library(defines=()):
+    """Compile the component into a shared library for ctypes, returns its path"""
+    name = "libbutton_host" + "".join("_" + d.split("=")[0] for d in defines) + ".so"
+    library = os.path.join(_build_dir(), name)
+    _compile(["gcc", "-std=gnu17", *_flags(defines), "-shared", "-fPIC", *C_SOURCES, "-o", library])
+    return library
+
+
+def run_program(program, timeout=60):
+    """Run a host test program, returns the completed process"""
+    return subprocess.run([program], capture_output=True, text=True, timeout=timeout)
@@ -10,7 +10,7 @@ import os
 sys.path.insert(0, os.path.dirname(__file__))
 
 # Import the conftest module to access the mock objects
-from conftest import esp, gpio, freertos, ButtonConfig
+from conftest import esp, gpio, freertos, ButtonConfig, ButtonEvents
 
 # Import the button_longpress module
 import button_longpress
@@ -202,3 +202,80 @@ class TestButtonClick:
             button_longpress.next_button_id = 1
             gpio.reset()
             gpio.gpio_install_isr_service(0)
+    
+    def test_double_click_on_press(self, mock_button_component, button_config):
+        """Test that press mode reports double click before the second release"""
+        config = ButtonConfig(
+            gpio_num=button_config['gpio_num'],
+            active_level=True,
+            debounce_time_ms=20,
+            long_press_time_ms=1000,
+            double_click_time_ms=300,
+            callback=ctypes.cast(button_callback_func, ctypes.c_void_p),
+            double_click_on_press=True
+        )
+        
+        button = button_longpress.button_create(ctypes.byref(config))
+        assert button is not None
+        
+        callback_calls.clear()
+        
+        # First click
+        gpio.gpio_set_level(button_config['gpio_num'], 1)
+        freertos.advance_time(30)
+        gpio.gpio_set_level(button_config['gpio_num'], 0)
+        freertos.advance_time(100)
+        
+        # Second press only
+        gpio.gpio_set_level(button_config['gpio_num'], 1)
+        freertos.advance_time(30)
+        
+        # Double click is reported while the button is still held
+        assert callback_calls.count(esp.BUTTON_EVENT_DOUBLE_CLICK) == 1
+        assert button_longpress.button_get_state(button) == esp.BUTTON_STATE_DOUBLE_CLICK
+        
+        # Release must not report it again
+        gpio.gpio_set_level(button_config['gpio_num'], 0)
+        freertos.advance_time(400)
+        
+        assert callback_calls.count(esp.BUTTON_EVENT_DOUBLE_CLICK) == 1
+        assert esp.BUTTON_EVENT_CLICK not in callback_calls
+        
+        button_longpress.button_delete(button)
+    
+    def test_consume_events_latches_clicks(self, mock_button_component, button_config):
+        """Test that a slow poller sees clicks that the state no longer shows"""
+        config = ButtonConfig(
+            gpio_num=button_config['gpio_num'],
+            active_level=True,
+            debounce_time_ms=20,
+            long_press_time_ms=1000,
+            double_click_time_ms=300
+        )
+        
+        button = button_longpress.button_create(ctypes.byref(config))
+        assert button is not None
+        
+        # Two separate single clicks between polls
+        for _ in range(2):
+            gpio.gpio_set_level(button_config['gpio_num'], 1)
+            freertos.advance_time(30)
+            gpio.gpio_set_level(button_config['gpio_num'], 0)
+            freertos.advance_time(400)
+        
+        # State has already returned to idle
+        assert button_longpress.button_get_state(button) == esp.BUTTON_STATE_IDLE
+        
+        events = ButtonEvents()
+        assert button_longpress.button_consume_events(button, ctypes.byref(events)) == esp.ESP_OK
+        assert events.mask & (1 << esp.BUTTON_EVENT_CLICK)
+        assert events.counts[esp.BUTTON_EVENT_CLICK] == 2
+        assert events.counts[esp.BUTTON_EVENT_PRESSED] == 2
+        assert not events.mask & (1 << esp.BUTTON_EVENT_DOUBLE_CLICK)
+        
+        # Consuming clears the latch
+        assert button_longpress.button_consume_events(button, ctypes.byref(events)) == esp.ESP_OK
+        assert events.mask == 0
+        assert events.counts[esp.BUTTON_EVENT_CLICK] == 0
+        
+        button_longpress.button_delete(button)
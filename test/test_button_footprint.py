@@ -0,0 +1,47 @@
+"""
+Tests for the memory footprint benchmark
+"""
+import json
+import sys
+import os
+
+# Ensure proper imports
+sys.path.insert(0, os.path.dirname(__file__))
+
+from conftest import freertos
+
+import bench_footprint
+
+
+class TestButtonFootprint:
+    """Kernel objects and timer queue demand per button"""
+
+    def test_kernel_objects_scale_linearly(self, mock_button_component):
+        """Every button holds the same set of kernel objects"""
+        results = bench_footprint.run(4, 20)
+        per_button = results[0]["kernel_objects"]
+        # Three timers and one mutex
+        assert per_button == 4
+        for result in results:
+            assert result["kernel_objects"] == per_button * result["buttons"]
+
+    def test_bounce_storm_queue_demand(self, mock_button_component):
+        """Each bounce edge posts exactly one timer command"""
+        result = bench_footprint.measure(3, 20)
+        assert result["timer_queue_peak"] == 3 * 20
+
+    def test_objects_released_on_delete(self, mock_button_component):
+        """Deleting the buttons frees every kernel object"""
+        bench_footprint.measure(4, 20)
+        assert freertos.kernel_objects() == 0
+
+    def test_output_format(self, mock_button_component, tmp_path, capsys):
+        """Results are printed as BENCH lines and written as JSON"""
+        out = tmp_path / "footprint.json"
+        assert bench_footprint.main(["--max-buttons", "2", "--json", str(out)]) == 0
+
+        lines = [line for line in capsys.readouterr().out.splitlines() if line.startswith("BENCH ")]
+        assert len(lines) == 2
+        printed = [json.loads(line[len("BENCH "):]) for line in lines]
+        assert printed == json.loads(out.read_text())
+        assert printed[1]["buttons"] == 2
@@ -0,0 +1,138 @@
+"""
+Tests for button gesture recognition
+"""
+import pytest
+import ctypes
+import sys
+import os
+
+# Ensure proper imports
+sys.path.insert(0, os.path.dirname(__file__))
+
+# Import the conftest module to access the mock objects
+from conftest import esp, gpio, freertos, ButtonConfig, ButtonGesture, BUTTON_EVENT_CALLBACK
+
+# Import the button_longpress module
+import button_longpress
+
+SHORT = esp.BUTTON_GESTURE_SHORT
+LONG = esp.BUTTON_GESTURE_LONG
+GAP = esp.BUTTON_GESTURE_GAP
+
+# Global variable to track recognized gesture indices
+gesture_calls = []
+
+# C-compatible extended callback function that records gestures
+@BUTTON_EVENT_CALLBACK
+def button_event_callback_func(info, user_ctx):
+    if info.contents.event == esp.BUTTON_EVENT_GESTURE:
+        gesture_calls.append(info.contents.gesture)
+    return None
+
+def make_gestures(*patterns):
+    """Build a C array of gestures, keeping the token arrays alive"""
+    token_arrays = [(ctypes.c_int * len(p))(*p) for p in patterns]
+    gestures = (ButtonGesture * len(patterns))(
+        *[ButtonGesture(tokens=ctypes.cast(t, ctypes.POINTER(ctypes.c_int)), length=len(t)) for t in token_arrays])
+    gestures._token_arrays = token_arrays
+    return gestures
+
+class TestButtonGesture:
+    """Test class for button gesture recognition"""
+    
+    def setup_method(self):
+        """Setup method called before each test"""
+        # Clear the callback calls
+        gesture_calls.clear()
+        
+        # Reset mock state
+        gpio.reset()
+        freertos.timers = {}
+        freertos.timer_id = 0
+        freertos.current_time_ms = 0
+        
+        # Clear button instances
+        button_longpress.button_instances = {}
+        button_longpress.next_button_id = 1
+        
+        # Install ISR service
+        gpio.gpio_install_isr_service(0)
+    
+    def create_button(self, gestures, count):
+        """Create an active high button with gestures"""
+        config = ButtonConfig(
+            gpio_num=4,
+            active_level=True,
+            debounce_time_ms=20,
+            long_press_time_ms=500,
+            double_click_time_ms=300,
+            event_callback=ctypes.cast(button_event_callback_func, ctypes.c_void_p),
+            gestures=gestures,
+            gesture_count=count
+        )
+        return button_longpress.button_create(ctypes.byref(config))
+    
+    def press(self, hold_ms, gap_ms):
+        """Press for hold_ms, then stay released for gap_ms"""
+        gpio.gpio_set_level(4, 1)
+        freertos.advance_time(hold_ms)
+        gpio.gpio_set_level(4, 0)
+        freertos.advance_time(gap_ms)
+    
+    def test_short_short_long(self, mock_button_component):
+        """Test the service mode pattern short-short-long"""
+        gestures = make_gestures([SHORT, SHORT, LONG])
+        button = self.create_button(gestures, 1)
+        assert button is not None
+        
+        self.press(50, 100)
+        self.press(50, 100)
+        assert gesture_calls == []
+        
+        # Recognized as soon as the long press is reached
+        gpio.gpio_set_level(4, 1)
+        freertos.advance_time(600)
+        assert gesture_calls == [0]
+        
+        gpio.gpio_set_level(4, 0)
+        freertos.advance_time(500)
+        assert gesture_calls == [0]
+        
+        button_longpress.button_delete(button)
+    
+    def test_anchored_patterns(self, mock_button_component):
+        """Test that gaps anchor a pattern to a complete sequence"""
+        gestures = make_gestures([GAP, SHORT, SHORT, GAP], [GAP, SHORT, SHORT, SHORT, GAP], [SHORT, SHORT])
+        button = self.create_button(gestures, 3)
+        assert button is not None
+        
+        # Three shorts then a pause: unanchored pattern matches twice, triple once
+        self.press(50, 100)
+        self.press(50, 100)
+        self.press(50, 400)
+        assert gesture_calls == [2, 2, 1]
+        
+        # Two shorts then a pause
+        gesture_calls.clear()
+        self.press(50, 100)
+        self.press(50, 400)
+        assert gesture_calls == [2, 0]
+        
+        button_longpress.button_delete(button)
+    
+    def test_gesture_dfa_size(self, mock_button_component):
+        """Test that shared prefixes share states in the compiled table"""
+        gestures = make_gestures([SHORT, SHORT, LONG], [SHORT, SHORT, SHORT], [SHORT, LONG])
+        button = self.create_button(gestures, 3)
+        assert button is not None
+        
+        dfa = button_longpress.button_instances[button].gestures
+        assert len(dfa.next) == 6
+        assert all(len(row) == esp.BUTTON_GESTURE_TOKEN_MAX and None not in row for row in dfa.next)
+        
+        button_longpress.button_delete(button)
+    
+    def test_invalid_gestures(self, mock_button_component):
+        """Test that empty or oversized gestures are rejected"""
+        assert self.create_button(make_gestures([]), 1) is None
+        assert self.create_button(make_gestures([SHORT] * 64), 1) is None
@@ -0,0 +1,236 @@
+"""
+Tests for button group functionality
+"""
+import pytest
+import ctypes
+import sys
+import os
+
+# Ensure proper imports
+sys.path.insert(0, os.path.dirname(__file__))
+
+# Import the conftest module to access the mock objects
+from conftest import esp, gpio, freertos, ButtonConfig, ButtonChord, BUTTON_EVENT_CALLBACK
+
+# Import the button_longpress module
+import button_longpress
+
+# Define a C-compatible callback function type
+BUTTON_CALLBACK = ctypes.CFUNCTYPE(None, ctypes.c_int)
+
+# Global variables to track callback calls
+callback_calls = []
+chord_calls = []
+
+# C-compatible callback function that records calls
+@BUTTON_CALLBACK
+def button_callback_func(event):
+    callback_calls.append(event)
+    return None
+
+# C-compatible chord callback function that records (chord, button) pairs
+@BUTTON_EVENT_CALLBACK
+def chord_callback_func(info, user_ctx):
+    chord_calls.append((info.contents.chord, info.contents.button))
+    return None
+
+def make_chords(*chords):
+    """Build a C array of chord definitions"""
+    return (ButtonChord * len(chords))(*chords)
+
+class TestButtonGroup:
+    """Test class for button group functionality"""
+    
+    def setup_method(self):
+        """Setup method called before each test"""
+        # Clear the callback calls
+        callback_calls.clear()
+        chord_calls.clear()
+        
+        # Reset mock state
+        gpio.reset()
+        freertos.timers = {}
+        freertos.timer_id = 0
+        freertos.current_time_ms = 0
+        
+        # Clear button and group instances
+        button_longpress.button_instances = {}
+        button_longpress.next_button_id = 1
+        button_longpress.group_instances = {}
+        button_longpress.next_group_id = 1
+        
+        # Install ISR service
+        gpio.gpio_install_isr_service(0)
+    
+    def create_button(self, group, gpio_num):
+        """Create an active high button in a group"""
+        config = ButtonConfig(
+            gpio_num=gpio_num,
+            active_level=True,
+            debounce_time_ms=20,
+            long_press_time_ms=1000,
+            double_click_time_ms=300,
+            callback=ctypes.cast(button_callback_func, ctypes.c_void_p),
+            group=group
+        )
+        return button_longpress.button_create(ctypes.byref(config))
+    
+    def test_group_pressed_mask(self, mock_button_component):
+        """Test that the group bitmap follows debounced presses"""
+        group = button_longpress.button_group_create()
+        assert group is not None
+        
+        button_a = self.create_button(group, 4)
+        button_b = self.create_button(group, 5)
+        assert button_longpress.button_get_group_index(button_a) == 0
+        assert button_longpress.button_get_group_index(button_b) == 1
+        assert button_longpress.button_group_get_pressed_mask(group) == 0
+        
+        # Press B only
+        gpio.gpio_set_level(5, 1)
+        freertos.advance_time(30)
+        assert button_longpress.button_group_get_pressed_mask(group) == 0b10
+        
+        # Press A as well
+        gpio.gpio_set_level(4, 1)
+        freertos.advance_time(30)
+        assert button_longpress.button_group_get_pressed_mask(group) == 0b11
+        
+        # Bounce on A shorter than debounce does not change the bitmap
+        gpio.gpio_set_level(4, 0)
+        freertos.advance_time(5)
+        gpio.gpio_set_level(4, 1)
+        freertos.advance_time(30)
+        assert button_longpress.button_group_get_pressed_mask(group) == 0b11
+        
+        # Release both
+        gpio.gpio_set_level(4, 0)
+        freertos.advance_time(30)
+        assert button_longpress.button_group_get_pressed_mask(group) == 0b10
+        gpio.gpio_set_level(5, 0)
+        freertos.advance_time(30)
+        assert button_longpress.button_group_get_pressed_mask(group) == 0
+        
+        assert button_longpress.button_delete(button_a) == esp.ESP_OK
+        assert button_longpress.button_delete(button_b) == esp.ESP_OK
+        assert button_longpress.button_group_delete(group) == esp.ESP_OK
+    
+    def test_group_index_reused_after_delete(self, mock_button_component):
+        """Test that a deleted button frees its bit and pressed state"""
+        group = button_longpress.button_group_create()
+        button_a = self.create_button(group, 4)
+        button_b = self.create_button(group, 5)
+        
+        gpio.gpio_set_level(4, 1)
+        freertos.advance_time(30)
+        assert button_longpress.button_group_get_pressed_mask(group) == 0b01
+        
+        assert button_longpress.button_delete(button_a) == esp.ESP_OK
+        assert button_longpress.button_group_get_pressed_mask(group) == 0
+        
+        button_c = self.create_button(group, 6)
+        assert button_longpress.button_get_group_index(button_c) == 0
+        
+        button_longpress.button_delete(button_b)
+        button_longpress.button_delete(button_c)
+    
+    def test_group_delete_with_members(self, mock_button_component):
+        """Test that a group with members cannot be deleted"""
+        group = button_longpress.button_group_create()
+        button = self.create_button(group, 4)
+        
+        assert button_longpress.button_group_delete(group) == esp.ESP_ERR_INVALID_STATE
+        
+        button_longpress.button_delete(button)
+        assert button_longpress.button_group_delete(group) == esp.ESP_OK
+    
+    def test_button_without_group(self, mock_button_component):
+        """Test that ungrouped buttons have no group index"""
+        button = self.create_button(None, 4)
+        assert button_longpress.button_get_group_index(button) == -1
+        assert button_longpress.button_group_get_pressed_mask(None) == 0
+        
+        button_longpress.button_delete(button)
+    
+    def test_hold_chord_within_window(self, mock_button_component):
+        """Test that a hold chord needs all presses inside the window"""
+        group = button_longpress.button_group_create()
+        button_a = self.create_button(group, 4)
+        button_b = self.create_button(group, 5)
+        chords = make_chords(ButtonChord(hold_mask=0b11, window_ms=100))
+        assert button_longpress.button_group_set_chords(
+            group, chords, 1, ctypes.cast(chord_callback_func, ctypes.c_void_p), None) == esp.ESP_OK
+        
+        # A then B within the window
+        gpio.gpio_set_level(4, 1)
+        freertos.advance_time(50)
+        gpio.gpio_set_level(5, 1)
+        freertos.advance_time(30)
+        assert chord_calls == [(0, button_b)]
+        
+        # Reported once per hold
+        freertos.advance_time(500)
+        assert len(chord_calls) == 1
+        
+        gpio.gpio_set_level(4, 0)
+        freertos.advance_time(30)
+        gpio.gpio_set_level(5, 0)
+        freertos.advance_time(30)
+        
+        # A then B too late
+        gpio.gpio_set_level(4, 1)
+        freertos.advance_time(300)
+        gpio.gpio_set_level(5, 1)
+        freertos.advance_time(30)
+        assert len(chord_calls) == 1
+        
+        button_longpress.button_delete(button_a)
+        button_longpress.button_delete(button_b)
+    
+    def test_click_chord_suppresses_member_events(self, mock_button_component):
+        """Test hold A, click B with suppression of the individual events"""
+        group = button_longpress.button_group_create()
+        button_a = self.create_button(group, 4)
+        button_b = self.create_button(group, 5)
+        chords = make_chords(ButtonChord(hold_mask=0b01, click_mask=0b10, suppress=True))
+        assert button_longpress.button_group_set_chords(
+            group, chords, 1, ctypes.cast(chord_callback_func, ctypes.c_void_p), None) == esp.ESP_OK
+        
+        # Hold A, click B, release A
+        gpio.gpio_set_level(4, 1)
+        freertos.advance_time(100)
+        gpio.gpio_set_level(5, 1)
+        freertos.advance_time(100)
+        assert chord_calls == []
+        gpio.gpio_set_level(5, 0)
+        freertos.advance_time(30)
+        assert chord_calls == [(0, button_b)]
+        
+        # Holding A past the long press threshold stays quiet
+        freertos.advance_time(1500)
+        gpio.gpio_set_level(4, 0)
+        freertos.advance_time(500)
+        
+        assert esp.BUTTON_EVENT_LONG_PRESS not in callback_calls
+        assert esp.BUTTON_EVENT_CLICK not in callback_calls
+        assert callback_calls.count(esp.BUTTON_EVENT_PRESSED) == 2
+        assert callback_calls.count(esp.BUTTON_EVENT_RELEASED) == 2
+        
+        # Suppression ends with the release
+        callback_calls.clear()
+        gpio.gpio_set_level(5, 1)
+        freertos.advance_time(30)
+        gpio.gpio_set_level(5, 0)
+        freertos.advance_time(400)
+        assert esp.BUTTON_EVENT_CLICK in callback_calls
+        assert len(chord_calls) == 1
+        
+        button_longpress.button_delete(button_a)
+        button_longpress.button_delete(button_b)
+    
+    def test_set_chords_invalid(self, mock_button_component):
+        """Test that overlapping hold and click masks are rejected"""
+        group = button_longpress.button_group_create()
+        chords = make_chords(ButtonChord(hold_mask=0b11, click_mask=0b10))
+        assert button_longpress.button_group_set_chords(group, chords, 1, None, None) == esp.ESP_ERR_INVALID_ARG
+        assert button_longpress.button_group_set_chords(None, None, 0, None, None) == esp.ESP_ERR_INVALID_ARG
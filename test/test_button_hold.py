@@ -0,0 +1,279 @@
+"""
+Tests for button hold functionality (hold stages, auto-repeat, progress)
+"""
+import pytest
+import ctypes
+import sys
+import os
+
+# Ensure proper imports
+sys.path.insert(0, os.path.dirname(__file__))
+
+# Import the conftest module to access the mock objects
+from conftest import esp, gpio, freertos, ButtonConfig, BUTTON_EVENT_CALLBACK
+
+# Import the button_longpress module
+import button_longpress
+
+# Global variable to track extended callback calls as (event, stage, hold_time_ms, repeat_count, target_ms)
+event_calls = []
+
+# C-compatible extended callback function that records calls
+@BUTTON_EVENT_CALLBACK
+def button_event_callback_func(info, user_ctx):
+    event_calls.append((info.contents.event, info.contents.stage,
+                        info.contents.hold_time_ms, info.contents.repeat_count,
+                        info.contents.target_ms))
+    return None
+
+def make_stages(*stages_ms):
+    """Build a C array of hold stage thresholds"""
+    return (ctypes.c_uint32 * len(stages_ms))(*stages_ms)
+
+class TestButtonHold:
+    """Test class for button hold functionality"""
+    
+    def setup_method(self):
+        """Setup method called before each test"""
+        # Clear the callback calls
+        event_calls.clear()
+        
+        # Reset mock state
+        gpio.reset()
+        freertos.timers = {}
+        freertos.timer_id = 0
+        freertos.current_time_ms = 0
+        
+        # Clear button instances
+        button_longpress.button_instances = {}
+        button_longpress.next_button_id = 1
+        
+        # Install ISR service
+        gpio.gpio_install_isr_service(0)
+    
+    def test_hold_stages_reported_in_order(self, mock_button_component, button_config):
+        """Test that every hold stage is reported once with its index"""
+        stages = make_stages(1000, 3000, 10000)
+        config = ButtonConfig(
+            gpio_num=button_config['gpio_num'],
+            active_level=True,
+            debounce_time_ms=20,
+            long_press_time_ms=1000,
+            double_click_time_ms=300,
+            hold_stages_ms=stages,
+            hold_stage_count=3,
+            event_callback=ctypes.cast(button_event_callback_func, ctypes.c_void_p)
+        )
+        
+        button = button_longpress.button_create(ctypes.byref(config))
+        assert button is not None
+        
+        # Press and hold past the second stage only
+        gpio.gpio_set_level(button_config['gpio_num'], 1)
+        freertos.advance_time(30)
+        freertos.advance_time(3100)
+        
+        stage_calls = [c for c in event_calls if c[0] == esp.BUTTON_EVENT_HOLD_STAGE]
+        assert [c[1] for c in stage_calls] == [0, 1]
+        assert stage_calls[0][2] >= 1000
+        assert stage_calls[1][2] >= 3000
+        assert [c[0] for c in event_calls].count(esp.BUTTON_EVENT_LONG_PRESS) == 1
+        
+        # Release stops further stages
+        gpio.gpio_set_level(button_config['gpio_num'], 0)
+        freertos.advance_time(10000)
+        
+        stage_calls = [c for c in event_calls if c[0] == esp.BUTTON_EVENT_HOLD_STAGE]
+        assert len(stage_calls) == 2
+        
+        button_longpress.button_delete(button)
+    
+    def test_hold_stages_share_one_timer(self, mock_button_component, button_config):
+        """Test that hold stages do not create extra timers"""
+        stages = make_stages(500, 2000)
+        config = ButtonConfig(
+            gpio_num=button_config['gpio_num'],
+            active_level=True,
+            hold_stages_ms=stages,
+            hold_stage_count=2,
+            event_callback=ctypes.cast(button_event_callback_func, ctypes.c_void_p)
+        )
+        
+        button = button_longpress.button_create(ctypes.byref(config))
+        assert button is not None
+        assert len(freertos.timers) == 3
+        
+        button_longpress.button_delete(button)
+    
+    def test_hold_stages_invalid_order(self, mock_button_component, button_config):
+        """Test that non-ascending hold stages are rejected"""
+        stages = make_stages(3000, 1000)
+        config = ButtonConfig(
+            gpio_num=button_config['gpio_num'],
+            active_level=True,
+            hold_stages_ms=stages,
+            hold_stage_count=2
+        )
+        
+        button = button_longpress.button_create(ctypes.byref(config))
+        assert button is None
+    
+    def test_hold_survives_short_glitch(self, mock_button_component, button_config):
+        """Test that a glitch shorter than the debounce time at a hold deadline delays it only"""
+        stages = make_stages(2000)
+        config = ButtonConfig(
+            gpio_num=button_config['gpio_num'],
+            active_level=True,
+            debounce_time_ms=20,
+            long_press_time_ms=1000,
+            hold_stages_ms=stages,
+            hold_stage_count=1,
+            event_callback=ctypes.cast(button_event_callback_func, ctypes.c_void_p)
+        )
+        
+        button = button_longpress.button_create(ctypes.byref(config))
+        assert button is not None
+        
+        gpio.gpio_set_level(button_config['gpio_num'], 1)
+        freertos.advance_time(1015)
+        
+        # The pin reads released when the long press deadline expires
+        gpio.gpio_set_level(button_config['gpio_num'], 0)
+        freertos.advance_time(7)
+        gpio.gpio_set_level(button_config['gpio_num'], 1)
+        assert esp.BUTTON_EVENT_LONG_PRESS not in [c[0] for c in event_calls]
+        
+        freertos.advance_time(100)
+        events = [c[0] for c in event_calls]
+        assert esp.BUTTON_EVENT_RELEASED not in events
+        assert events.count(esp.BUTTON_EVENT_LONG_PRESS) == 1
+        
+        # Later deadlines of the same hold still fire
+        freertos.advance_time(1000)
+        assert [c[1] for c in event_calls if c[0] == esp.BUTTON_EVENT_HOLD_STAGE] == [0]
+        
+        button_longpress.button_delete(button)
+    
+    def test_auto_repeat_with_acceleration(self, mock_button_component, button_config):
+        """Test auto-repeat timing, acceleration and stop on release"""
+        config = ButtonConfig(
+            gpio_num=button_config['gpio_num'],
+            active_level=True,
+            debounce_time_ms=20,
+            long_press_time_ms=1000,
+            double_click_time_ms=300,
+            event_callback=ctypes.cast(button_event_callback_func, ctypes.c_void_p),
+            repeat_interval_ms=200,
+            repeat_delay_ms=500,
+            repeat_min_interval_ms=100,
+            repeat_accel_percent=50
+        )
+        
+        button = button_longpress.button_create(ctypes.byref(config))
+        assert button is not None
+        assert len(freertos.timers) == 3
+        
+        gpio.gpio_set_level(button_config['gpio_num'], 1)
+        freertos.advance_time(30)
+        
+        # Nothing before the initial delay
+        freertos.advance_time(450)
+        assert not [c for c in event_calls if c[0] == esp.BUTTON_EVENT_REPEAT]
+        
+        # Repeats at 500, 700 (200 ms), then 800, 900 (accelerated to 100 ms)
+        freertos.advance_time(450)
+        repeats = [c for c in event_calls if c[0] == esp.BUTTON_EVENT_REPEAT]
+        assert [c[3] for c in repeats] == [1, 2, 3, 4]
+        assert [c[2] for c in repeats] == [500, 700, 800, 900]
+        
+        # Release stops repeating immediately and suppresses click
+        gpio.gpio_set_level(button_config['gpio_num'], 0)
+        freertos.advance_time(30)
+        count = len([c for c in event_calls if c[0] == esp.BUTTON_EVENT_REPEAT])
+        freertos.advance_time(1000)
+        
+        assert len([c for c in event_calls if c[0] == esp.BUTTON_EVENT_REPEAT]) == count
+        assert esp.BUTTON_EVENT_CLICK not in [c[0] for c in event_calls]
+        
+        button_longpress.button_delete(button)
+    
+    def test_auto_repeat_defaults_to_long_press_delay(self, mock_button_component, button_config):
+        """Test that auto-repeat starts at long_press_time_ms without a delay"""
+        config = ButtonConfig(
+            gpio_num=button_config['gpio_num'],
+            active_level=True,
+            long_press_time_ms=1000,
+            event_callback=ctypes.cast(button_event_callback_func, ctypes.c_void_p),
+            repeat_interval_ms=100
+        )
+        
+        button = button_longpress.button_create(ctypes.byref(config))
+        assert button is not None
+        
+        gpio.gpio_set_level(button_config['gpio_num'], 1)
+        freertos.advance_time(30)
+        freertos.advance_time(950)
+        assert not [c for c in event_calls if c[0] == esp.BUTTON_EVENT_REPEAT]
+        
+        freertos.advance_time(100)
+        repeats = [c for c in event_calls if c[0] == esp.BUTTON_EVENT_REPEAT]
+        assert len(repeats) == 1
+        
+        button_longpress.button_delete(button)
+    
+    def test_hold_progress_until_long_press(self, mock_button_component, button_config):
+        """Test that progress events stream until the long press completes them"""
+        config = ButtonConfig(
+            gpio_num=button_config['gpio_num'],
+            active_level=True,
+            debounce_time_ms=20,
+            long_press_time_ms=1000,
+            double_click_time_ms=300,
+            event_callback=ctypes.cast(button_event_callback_func, ctypes.c_void_p),
+            hold_progress_interval_ms=250
+        )
+        
+        button = button_longpress.button_create(ctypes.byref(config))
+        assert button is not None
+        
+        gpio.gpio_set_level(button_config['gpio_num'], 1)
+        freertos.advance_time(30)
+        freertos.advance_time(2000)
+        
+        progress = [c for c in event_calls if c[0] == esp.BUTTON_EVENT_HOLD_PROGRESS]
+        assert [c[2] for c in progress] == [250, 500, 750]
+        assert all(c[4] == 1000 for c in progress)
+        
+        # Long press comes after the last progress event
+        events = [c[0] for c in event_calls]
+        assert events.index(esp.BUTTON_EVENT_LONG_PRESS) > events.index(esp.BUTTON_EVENT_HOLD_PROGRESS)
+        
+        button_longpress.button_delete(button)
+    
+    def test_hold_progress_stops_on_release(self, mock_button_component, button_config):
+        """Test that releasing early ends the progress stream"""
+        config = ButtonConfig(
+            gpio_num=button_config['gpio_num'],
+            active_level=True,
+            long_press_time_ms=1000,
+            event_callback=ctypes.cast(button_event_callback_func, ctypes.c_void_p),
+            hold_progress_interval_ms=100
+        )
+        
+        button = button_longpress.button_create(ctypes.byref(config))
+        assert button is not None
+        
+        gpio.gpio_set_level(button_config['gpio_num'], 1)
+        freertos.advance_time(30)
+        freertos.advance_time(300)
+        gpio.gpio_set_level(button_config['gpio_num'], 0)
+        freertos.advance_time(30)
+        
+        count = len([c for c in event_calls if c[0] == esp.BUTTON_EVENT_HOLD_PROGRESS])
+        assert count == 3
+        
+        freertos.advance_time(2000)
+        assert len([c for c in event_calls if c[0] == esp.BUTTON_EVENT_HOLD_PROGRESS]) == count
+        assert esp.BUTTON_EVENT_LONG_PRESS not in [c[0] for c in event_calls]
+        
+        button_longpress.button_delete(button)
@@ -0,0 +1,75 @@
+"""
+Tests compiled against the real component sources (see host_build.py)
+"""
+import sys
+import os
+
+import pytest
+
+# Ensure proper imports
+sys.path.insert(0, os.path.dirname(__file__))
+
+import host_build
+
+pytestmark = pytest.mark.skipif(host_build.unavailable() is not None,
+                                reason=f"host build unavailable: {host_build.unavailable()}")
+
+
+def run(source, **kwargs):
+    result = host_build.run_program(host_build.build_program(source, **kwargs))
+    assert result.returncode == 0, result.stderr
+
+
+# Per-button lock variants
+LOCKS = {
+    "mutex": (),
+    "spinlock": ("CONFIG_BUTTON_LONGPRESS_SPINLOCK=1",),
+}
+
+
+class TestButtonHost:
+    """C++ front-ends on the real component and a simulated kernel"""
+
+    def test_button_move_assignment(self):
+        """Buttons with capturing and move-only lambdas are move-assigned in C++17"""
+        run("test_button_hpp.cpp", std="c++17")
+
+    @pytest.mark.parametrize("lock", sorted(LOCKS))
+    def test_coroutine_flows(self, lock):
+        """EventAwaiter and Flow resume, time out, cancel and re-register correctly"""
+        run("test_coro.cpp", defines=LOCKS[lock])
+
+    @pytest.mark.parametrize("lock", sorted(LOCKS))
+    def test_group_chords(self, lock):
+        """The pressed bitmap and chords follow members pressed 0-10 ms apart"""
+        run("test_group.cpp", std="c++17", defines=LOCKS[lock])
+
+    @pytest.mark.parametrize("lock", sorted(LOCKS))
+    def test_click_flows(self, lock):
+        """Click, bounce, double click (on release and on press), long press and latched events"""
+        run("test_click.cpp", std="c++17", defines=LOCKS[lock])
+
+    @pytest.mark.parametrize("lock", sorted(LOCKS))
+    def test_hold_flows(self, lock):
+        """Hold events reported from the single re-armed hold deadline"""
+        run("test_hold.cpp", std="c++17", defines=LOCKS[lock])
+
+    @pytest.mark.parametrize("lock", sorted(LOCKS))
+    def test_wait_flows(self, lock):
+        """Blocking and asynchronous waits complete on matching events and time out otherwise"""
+        run("test_wait.cpp", std="c++17", defines=LOCKS[lock])
+
+    @pytest.mark.parametrize("lock", sorted(LOCKS))
+    def test_suspend_flows(self, lock):
+        """Suspended buttons stay silent, resume resamples the pin and counts the suspended hold"""
+        run("test_suspend.cpp", std="c++17", defines=LOCKS[lock])
+
+    @pytest.mark.parametrize("lock", sorted(LOCKS))
+    def test_gesture_flows(self, lock):
+        """Anchored and open gesture patterns on press token sequences"""
+        run("test_gesture.cpp", std="c++17", defines=LOCKS[lock])
+
+    @pytest.mark.parametrize("lock", sorted(LOCKS))
+    def test_reconfig_flows(self, lock):
+        """Timings, active level and callback changed on a live button"""
+        run("test_reconfig.cpp", std="c++17", defines=LOCKS[lock])
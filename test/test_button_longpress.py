@@ -10,7 +10,7 @@ import os
 sys.path.insert(0, os.path.dirname(__file__))
 
 # Import the conftest module to access the mock objects
-from conftest import esp, gpio, freertos, ButtonConfig
+from conftest import esp, gpio, freertos, ButtonConfig, BUTTON_EVENT_CALLBACK
 
 # Import the button_longpress module
 import button_longpress
@@ -27,6 +27,14 @@ def button_callback_func(event):
     callback_calls.append(event)
     return None
 
+# Extended callback calls as (event, user_ctx)
+event_calls = []
+
+@BUTTON_EVENT_CALLBACK
+def button_event_callback_func(info, user_ctx):
+    event_calls.append((info.contents.event, user_ctx))
+    return None
+
 class TestButtonLongPress:
     """Test class for button_longpress component"""
     
@@ -213,6 +221,38 @@ class TestButtonLongPress:
         
         button_longpress.button_delete(button)
     
+    def test_long_press_release_returns_to_idle(self, mock_button_component, button_config):
+        """Test that releasing a long press neither clicks nor leaves a stale state"""
+        config = ButtonConfig(
+            gpio_num=button_config['gpio_num'],
+            active_level=True,
+            debounce_time_ms=20,
+            long_press_time_ms=500,
+            double_click_time_ms=300,
+            callback=ctypes.cast(button_callback_func, ctypes.c_void_p)
+        )
+        
+        button = button_longpress.button_create(ctypes.byref(config))
+        assert button is not None
+        
+        callback_calls.clear()
+        
+        # Long press and release
+        gpio.gpio_set_level(button_config['gpio_num'], 1)
+        freertos.advance_time(600)
+        gpio.gpio_set_level(button_config['gpio_num'], 0)
+        freertos.advance_time(30)
+        
+        # State is idle right after the release
+        assert button_longpress.button_get_state(button) == esp.BUTTON_STATE_IDLE
+        
+        # No click follows the long press
+        freertos.advance_time(400)
+        assert callback_calls == [esp.BUTTON_EVENT_PRESSED, esp.BUTTON_EVENT_LONG_PRESS,
+                                  esp.BUTTON_EVENT_RELEASED]
+        
+        button_longpress.button_delete(button)
+    
     def test_double_click_detection(self, mock_button_component, button_config):
         """Test double click detection with proper timing"""
         double_click_time_ms = 300
@@ -388,6 +428,37 @@ class TestButtonLongPress:
         assert button_longpress.button_delete(button1) == esp.ESP_OK
         assert button_longpress.button_delete(button2) == esp.ESP_OK
     
+    def test_set_event_callback(self, mock_button_component, button_config):
+        """Test that replacing the extended callback re-targets later events"""
+        config = ButtonConfig(
+            gpio_num=button_config['gpio_num'],
+            active_level=True,
+            debounce_time_ms=20,
+            long_press_time_ms=1000,
+            double_click_time_ms=300
+        )
+        
+        button = button_longpress.button_create(ctypes.byref(config))
+        assert button is not None
+        
+        event_calls.clear()
+        
+        # No extended callback yet
+        gpio.gpio_set_level(button_config['gpio_num'], 1)
+        freertos.advance_time(30)
+        assert event_calls == []
+        
+        assert button_longpress.button_set_event_callback(
+            button, ctypes.cast(button_event_callback_func, ctypes.c_void_p), 42) == esp.ESP_OK
+        
+        gpio.gpio_set_level(button_config['gpio_num'], 0)
+        freertos.advance_time(30)
+        assert event_calls == [(esp.BUTTON_EVENT_RELEASED, 42)]
+        
+        assert button_longpress.button_set_event_callback(None, None, None) == esp.ESP_ERR_INVALID_ARG
+        
+        button_longpress.button_delete(button)
+    
     def test_get_state_null_handle(self, mock_button_component):
         """Test get_state with null handle"""
         state = button_longpress.button_get_state(None)
@@ -0,0 +1,161 @@
+"""
+Tests for the no-light-sleep lock and GPIO wakeup of idle buttons
+"""
+import pytest
+import ctypes
+import sys
+import os
+
+# Ensure proper imports
+sys.path.insert(0, os.path.dirname(__file__))
+
+# Import the conftest module to access the mock objects
+from conftest import esp, gpio, freertos, pm, ButtonConfig
+
+# Import the button_longpress module
+import button_longpress
+
+# Define a C-compatible callback function type
+BUTTON_CALLBACK = ctypes.CFUNCTYPE(None, ctypes.c_int)
+
+# Global variable to track callback calls
+callback_calls = []
+
+@BUTTON_CALLBACK
+def button_callback_func(event):
+    callback_calls.append(event)
+    return None
+
+GPIO_NUM = 4
+
+def create_button(gpio_num=GPIO_NUM, active_level=True):
+    config = ButtonConfig(
+        gpio_num=gpio_num,
+        active_level=active_level,
+        debounce_time_ms=20,
+        long_press_time_ms=1000,
+        double_click_time_ms=300,
+        callback=ctypes.cast(button_callback_func, ctypes.c_void_p)
+    )
+    button = button_longpress.button_create(ctypes.byref(config))
+    assert button is not None
+    return button
+
+def press(gpio_num=GPIO_NUM):
+    gpio.gpio_set_level(gpio_num, 1)
+
+def release(gpio_num=GPIO_NUM):
+    gpio.gpio_set_level(gpio_num, 0)
+
+class TestButtonPM:
+    """Test class for power management integration"""
+
+    def setup_method(self):
+        callback_calls.clear()
+
+    def test_idle_button_allows_light_sleep(self, mock_button_component):
+        """An idle button holds no lock and wakes the chip on its active level"""
+        create_button()
+
+        assert pm.light_sleep_allowed()
+        assert pm.gpio_wakeup_source
+        assert gpio.wakeup[GPIO_NUM] == esp.GPIO_INTR_HIGH_LEVEL
+
+    def test_active_low_wakes_on_low_level(self, mock_button_component):
+        """The wakeup level follows the active level"""
+        button = create_button(active_level=False)
+
+        assert gpio.wakeup[GPIO_NUM] == esp.GPIO_INTR_LOW_LEVEL
+
+        # The high idle level now reads as a press, held until it is released
+        assert button_longpress.button_set_active_level(button, True) == esp.ESP_OK
+        assert not pm.light_sleep_allowed()
+        freertos.advance_time(1100)
+        assert button_longpress.button_is_pressed(button)
+        assert pm.light_sleep_allowed()
+        assert gpio.wakeup[GPIO_NUM] == esp.GPIO_INTR_LOW_LEVEL
+
+    def test_lock_held_while_deadlines_pending(self, mock_button_component):
+        """A click keeps the lock through debounce and the double click window only"""
+        create_button()
+
+        press()
+        assert not pm.light_sleep_allowed()
+        assert GPIO_NUM not in gpio.wakeup
+        freertos.advance_time(50)
+        release()
+        freertos.advance_time(50)
+
+        # Waiting for a second click
+        assert not pm.light_sleep_allowed()
+
+        freertos.advance_time(300)
+        assert esp.BUTTON_EVENT_CLICK in callback_calls
+        assert pm.light_sleep_allowed()
+        assert gpio.wakeup[GPIO_NUM] == esp.GPIO_INTR_HIGH_LEVEL
+
+    def test_held_button_wakes_on_release(self, mock_button_component):
+        """After the long press nothing is pending, so a held button waits for its release level"""
+        create_button()
+
+        press()
+        freertos.advance_time(500)
+        assert not pm.light_sleep_allowed()
+        freertos.advance_time(600)
+        assert esp.BUTTON_EVENT_LONG_PRESS in callback_calls
+
+        assert pm.light_sleep_allowed()
+        assert gpio.wakeup[GPIO_NUM] == esp.GPIO_INTR_LOW_LEVEL
+
+        release()
+        assert not pm.light_sleep_allowed()
+        freertos.advance_time(50)
+        assert esp.BUTTON_EVENT_RELEASED in callback_calls
+        assert pm.light_sleep_allowed()
+
+    def test_one_reference_per_button(self, mock_button_component):
+        """The lock is held while any button is active, once per button"""
+        create_button(4)
+        create_button(5)
+
+        press(4)
+        press(5)
+        gpio.gpio_set_level(5, 0)
+        gpio.gpio_set_level(5, 1)
+        assert pm.locks[button_longpress.pm_lock]['count'] == 2
+
+        freertos.advance_time(50)
+        release(4)
+        freertos.advance_time(400)
+
+        # Button 5 is still holding towards its long press
+        assert pm.locks[button_longpress.pm_lock]['count'] == 1
+        freertos.advance_time(1000)
+        assert pm.light_sleep_allowed()
+
+    def test_suspend_releases_lock_and_wakeup(self, mock_button_component):
+        """A suspended button neither blocks light sleep nor wakes the chip"""
+        button = create_button()
+
+        press()
+        freertos.advance_time(50)
+        assert not pm.light_sleep_allowed()
+
+        assert button_longpress.button_suspend(button) == esp.ESP_OK
+        assert pm.light_sleep_allowed()
+        assert GPIO_NUM not in gpio.wakeup
+
+        # Resuming resamples the pin under the lock
+        assert button_longpress.button_resume(button) == esp.ESP_OK
+        assert not pm.light_sleep_allowed()
+
+    def test_delete_releases_lock(self, mock_button_component):
+        """Deleting an active button drops its reference and wakeup pin"""
+        button = create_button()
+
+        press()
+        assert not pm.light_sleep_allowed()
+
+        assert button_longpress.button_delete(button) == esp.ESP_OK
+        assert pm.light_sleep_allowed()
+        assert GPIO_NUM not in gpio.wakeup
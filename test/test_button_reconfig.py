@@ -0,0 +1,171 @@
+"""
+Tests for runtime reconfiguration of a live button
+"""
+import pytest
+import ctypes
+import sys
+import os
+
+# Ensure proper imports
+sys.path.insert(0, os.path.dirname(__file__))
+
+# Import the conftest module to access the mock objects
+from conftest import esp, gpio, freertos, ButtonConfig
+
+# Import the button_longpress module
+import button_longpress
+
+# Define a C-compatible callback function type
+BUTTON_CALLBACK = ctypes.CFUNCTYPE(None, ctypes.c_int)
+
+# Global variables to track callback calls
+callback_calls = []
+other_calls = []
+
+@BUTTON_CALLBACK
+def button_callback_func(event):
+    callback_calls.append((event, freertos.current_time_ms))
+    return None
+
+@BUTTON_CALLBACK
+def other_callback_func(event):
+    other_calls.append(event)
+    return None
+
+GPIO_NUM = 4
+
+def create_button(active_level=True):
+    config = ButtonConfig(
+        gpio_num=GPIO_NUM,
+        active_level=active_level,
+        debounce_time_ms=20,
+        long_press_time_ms=1000,
+        double_click_time_ms=300,
+        callback=ctypes.cast(button_callback_func, ctypes.c_void_p)
+    )
+    button = button_longpress.button_create(ctypes.byref(config))
+    assert button is not None
+    return button
+
+def events():
+    return [event for event, _ in callback_calls]
+
+def event_time(event):
+    return next(t for e, t in callback_calls if e == event)
+
+class TestButtonReconfig:
+    """Test class for runtime setters"""
+    
+    def setup_method(self):
+        callback_calls.clear()
+        other_calls.clear()
+    
+    def test_set_timings_long_press(self, mock_button_component):
+        """A shorter long press time applies to the next press"""
+        button = create_button()
+        assert button_longpress.button_set_timings(button, 20, 400, 300) == esp.ESP_OK
+        
+        gpio.gpio_set_level(GPIO_NUM, 1)
+        freertos.advance_time(500)
+        assert esp.BUTTON_EVENT_LONG_PRESS in events()
+        assert event_time(esp.BUTTON_EVENT_LONG_PRESS) - event_time(esp.BUTTON_EVENT_PRESSED) == 400
+    
+    def test_set_timings_during_press(self, mock_button_component):
+        """A press in progress is held against the new long press time"""
+        button = create_button()
+        gpio.gpio_set_level(GPIO_NUM, 1)
+        freertos.advance_time(300)
+        assert esp.BUTTON_EVENT_PRESSED in events()
+        
+        assert button_longpress.button_set_timings(button, 20, 500, 300) == esp.ESP_OK
+        freertos.advance_time(300)
+        assert esp.BUTTON_EVENT_LONG_PRESS in events()
+        assert event_time(esp.BUTTON_EVENT_LONG_PRESS) - event_time(esp.BUTTON_EVENT_PRESSED) == 500
+        # The press survives reconfiguration
+        assert button_longpress.button_is_pressed(button)
+    
+    def test_set_timings_moves_default_repeat_delay(self, mock_button_component):
+        """Auto-repeat without its own delay starts at the new long press time"""
+        config = ButtonConfig(
+            gpio_num=GPIO_NUM,
+            active_level=True,
+            long_press_time_ms=1000,
+            callback=ctypes.cast(button_callback_func, ctypes.c_void_p),
+            repeat_interval_ms=100
+        )
+        button = button_longpress.button_create(ctypes.byref(config))
+        assert button is not None
+        assert button_longpress.button_set_timings(button, 20, 2000, 300) == esp.ESP_OK
+        
+        gpio.gpio_set_level(GPIO_NUM, 1)
+        freertos.advance_time(1500)
+        assert esp.BUTTON_EVENT_REPEAT not in events()
+        
+        freertos.advance_time(600)
+        assert event_time(esp.BUTTON_EVENT_REPEAT) - event_time(esp.BUTTON_EVENT_PRESSED) == 2000
+        assert events().index(esp.BUTTON_EVENT_LONG_PRESS) < events().index(esp.BUTTON_EVENT_REPEAT)
+    
+    def test_set_timings_double_click_window(self, mock_button_component):
+        """The click is confirmed after the new double click time"""
+        button = create_button()
+        assert button_longpress.button_set_timings(button, 20, 1000, 100) == esp.ESP_OK
+        
+        gpio.gpio_set_level(GPIO_NUM, 1)
+        freertos.advance_time(50)
+        gpio.gpio_set_level(GPIO_NUM, 0)
+        freertos.advance_time(150)
+        assert esp.BUTTON_EVENT_CLICK in events()
+        assert event_time(esp.BUTTON_EVENT_CLICK) - event_time(esp.BUTTON_EVENT_RELEASED) == 100
+    
+    def test_set_timings_defaults(self, mock_button_component):
+        """Zero selects the default timings"""
+        button = create_button()
+        assert button_longpress.button_set_timings(button, 0, 0, 0) == esp.ESP_OK
+        instance = button_longpress.button_instances[button]
+        assert (instance.debounce_time_ms, instance.long_press_time_ms, instance.double_click_time_ms) == (20, 1000, 300)
+    
+    def test_set_timings_without_recreate(self, mock_button_component):
+        """Reconfiguration creates and deletes no kernel objects"""
+        button = create_button()
+        objects = freertos.kernel_objects()
+        freertos.calls.clear()
+        
+        assert button_longpress.button_set_timings(button, 30, 800, 200) == esp.ESP_OK
+        assert button_longpress.button_set_active_level(button, False) == esp.ESP_OK
+        assert freertos.kernel_objects() == objects
+        for primitive in ("xTimerCreate", "xTimerDelete", "xSemaphoreCreateMutex", "vSemaphoreDelete"):
+            assert freertos.calls[primitive] == 0
+    
+    def test_set_active_level_resamples(self, mock_button_component):
+        """The pin is resampled with the new active level"""
+        button = create_button(active_level=True)
+        freertos.advance_time(50)
+        assert not button_longpress.button_is_pressed(button)
+        
+        # The idle low level now reads as pressed
+        assert button_longpress.button_set_active_level(button, False) == esp.ESP_OK
+        freertos.advance_time(50)
+        assert button_longpress.button_is_pressed(button)
+        assert events() == [esp.BUTTON_EVENT_PRESSED]
+        assert gpio.pins[GPIO_NUM]['pull_up_en'] == esp.GPIO_PULLUP_ENABLE
+        
+        gpio.gpio_set_level(GPIO_NUM, 1)
+        freertos.advance_time(50)
+        assert not button_longpress.button_is_pressed(button)
+    
+    def test_set_callback(self, mock_button_component):
+        """Events after the call go to the new callback"""
+        button = create_button()
+        assert button_longpress.button_set_callback(
+            button, ctypes.cast(other_callback_func, ctypes.c_void_p)) == esp.ESP_OK
+        
+        gpio.gpio_set_level(GPIO_NUM, 1)
+        freertos.advance_time(50)
+        assert callback_calls == []
+        assert other_calls == [esp.BUTTON_EVENT_PRESSED]
+    
+    def test_invalid_handle(self, mock_button_component):
+        """Setters reject an invalid handle"""
+        assert button_longpress.button_set_timings(None, 20, 1000, 300) == esp.ESP_ERR_INVALID_ARG
+        assert button_longpress.button_set_active_level(None, True) == esp.ESP_ERR_INVALID_ARG
+        assert button_longpress.button_set_callback(None, None) == esp.ESP_ERR_INVALID_ARG
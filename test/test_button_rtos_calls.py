@@ -0,0 +1,53 @@
+"""
+Regression gate for the kernel calls made per interaction
+
+Counts the calls of the real C code built for the host (see
+bench_rtos_calls.py) and fails when an interaction needs more FreeRTOS calls
+than recorded in rtos_calls_baseline.json. Re-record with
+`python3 bench_rtos_calls.py --record` when a change intentionally adds
+kernel round-trips. Skipped without a host compiler.
+"""
+import sys
+import os
+
+import pytest
+
+# Ensure proper imports
+sys.path.insert(0, os.path.dirname(__file__))
+
+import bench_rtos_calls
+import host_build
+
+pytestmark = pytest.mark.skipif(host_build.unavailable() is not None,
+                                reason=f"host build unavailable: {host_build.unavailable()}")
+
+BASELINE = bench_rtos_calls.load_baseline()
+
+
+class TestButtonRtosCalls:
+    """Kernel calls per scripted interaction"""
+
+    @pytest.mark.parametrize("interaction", sorted(bench_rtos_calls.INTERACTIONS))
+    def test_calls_within_baseline(self, interaction):
+        """No primitive is called more often than in the baseline"""
+        assert interaction in BASELINE, f"no baseline for {interaction}, re-record it"
+        calls = bench_rtos_calls.measure(interaction)
+        baseline = BASELINE[interaction]
+        exceeded = {
+            primitive: (count, baseline.get(primitive, 0))
+            for primitive, count in calls.items()
+            if count > baseline.get(primitive, 0)
+        }
+        assert not exceeded, f"{interaction}: (calls, baseline) {exceeded}"
+
+    def test_bounce_costs_one_isr_command_per_edge(self):
+        """A bounce storm only restarts the debounce deadline from the ISR"""
+        calls = bench_rtos_calls.measure("bounce_20")
+        assert calls["xTimerResetFromISR"] == 20
+        assert calls["xSemaphoreTake"] == 1
+
+    def test_lock_balanced(self):
+        """Every mutex take on the hot path is paired with a give"""
+        for interaction in bench_rtos_calls.INTERACTIONS:
+            calls = bench_rtos_calls.measure(interaction)
+            assert calls["xSemaphoreTake"] == calls["xSemaphoreGive"], interaction
@@ -0,0 +1,148 @@
+"""
+Tests for event sinks: queues, stream buffers and event loops
+"""
+import pytest
+import ctypes
+import sys
+import os
+
+# Ensure proper imports
+sys.path.insert(0, os.path.dirname(__file__))
+
+# Import the conftest module to access the mock objects
+from conftest import esp, gpio, freertos, events, ButtonConfig, ButtonSink, ButtonEventInfo
+
+# Import the button_longpress module
+import button_longpress
+
+GPIO_NUM = 4
+RECORD_SIZE = ctypes.sizeof(ButtonEventInfo)
+
+def create_button(sink_type, sink_handle, gpio_num=GPIO_NUM, engine=None):
+    config = ButtonConfig(
+        gpio_num=gpio_num,
+        active_level=True,
+        debounce_time_ms=20,
+        long_press_time_ms=1000,
+        double_click_time_ms=300,
+        sink=ButtonSink(type=sink_type, handle=sink_handle),
+        engine=engine
+    )
+    return button_longpress.button_create(ctypes.byref(config))
+
+def click(gpio_num=GPIO_NUM):
+    gpio.gpio_set_level(gpio_num, 1)
+    freertos.advance_time(50)
+    gpio.gpio_set_level(gpio_num, 0)
+    freertos.advance_time(50)
+
+def records(data):
+    """Split raw sink bytes into event records"""
+    return [ButtonEventInfo.from_buffer_copy(bytes(data[i:i + RECORD_SIZE]))
+            for i in range(0, len(data), RECORD_SIZE)]
+
+class TestButtonSink:
+    """Test class for event sinks"""
+
+    def test_queue_receives_records(self, mock_button_component):
+        """Every event is copied to the queue as a whole record"""
+        queue = freertos.xQueueCreate(8, RECORD_SIZE)
+        button = create_button(esp.BUTTON_SINK_QUEUE, queue)
+        assert button is not None
+
+        click()
+        freertos.advance_time(400)
+
+        posted = [records(item)[0] for item in freertos.queues[queue]['items']]
+        assert [info.event for info in posted] == [
+            esp.BUTTON_EVENT_PRESSED, esp.BUTTON_EVENT_RELEASED, esp.BUTTON_EVENT_CLICK]
+        assert all(info.button == button for info in posted)
+        assert button_longpress.button_get_dropped_events(button) == 0
+
+    def test_full_queue_counts_drops(self, mock_button_component):
+        """Records that do not fit are dropped without blocking and counted"""
+        queue = freertos.xQueueCreate(2, RECORD_SIZE)
+        button = create_button(esp.BUTTON_SINK_QUEUE, queue)
+
+        click()
+        freertos.advance_time(400)
+
+        assert len(freertos.queues[queue]['items']) == 2
+        assert button_longpress.button_get_dropped_events(button) == 1
+
+    def test_stream_buffer_writes_whole_records(self, mock_button_component):
+        """A record is written whole or dropped, never cut"""
+        buffer = freertos.xStreamBufferCreate(2 * RECORD_SIZE + RECORD_SIZE // 2, 1)
+        button = create_button(esp.BUTTON_SINK_STREAM_BUFFER, buffer)
+        assert button is not None
+
+        click()
+        freertos.advance_time(400)
+
+        data = freertos.stream_buffers[buffer]['data']
+        assert len(data) == 2 * RECORD_SIZE
+        assert [info.event for info in records(data)] == [
+            esp.BUTTON_EVENT_PRESSED, esp.BUTTON_EVENT_RELEASED]
+        assert button_longpress.button_get_dropped_events(button) == 1
+
+    def test_event_loop_posts_event_id(self, mock_button_component):
+        """Events are posted under the component base with the event type as id"""
+        loop = events.esp_event_loop_create(1)
+        button = create_button(esp.BUTTON_SINK_EVENT_LOOP, loop)
+        assert button is not None
+
+        gpio.gpio_set_level(GPIO_NUM, 1)
+        freertos.advance_time(50)
+
+        base, event_id, data = events.loops[loop]['posted'][0]
+        assert base == "BUTTON_LONGPRESS_EVENT"
+        assert event_id == esp.BUTTON_EVENT_PRESSED
+        assert records(data)[0].event == esp.BUTTON_EVENT_PRESSED
+
+        # The loop queue is full now
+        gpio.gpio_set_level(GPIO_NUM, 0)
+        freertos.advance_time(50)
+        assert button_longpress.button_get_dropped_events(button) == 1
+
+    def test_shared_queue_counts_drops_per_button(self, mock_button_component):
+        """Buttons sharing a sink each count their own drops"""
+        queue = freertos.xQueueCreate(3, RECORD_SIZE)
+        first = create_button(esp.BUTTON_SINK_QUEUE, queue, gpio_num=4)
+        second = create_button(esp.BUTTON_SINK_QUEUE, queue, gpio_num=5)
+
+        click(4)
+        click(5)
+
+        assert len(freertos.queues[queue]['items']) == 3
+        assert button_longpress.button_get_dropped_events(first) == 0
+        assert button_longpress.button_get_dropped_events(second) == 1
+
+    def test_invalid_sink_rejected(self, mock_button_component):
+        """A sink without a handle or of an unknown type is rejected"""
+        assert create_button(esp.BUTTON_SINK_QUEUE, None) is None
+        assert create_button(esp.BUTTON_SINK_EVENT_LOOP + 1, 1) is None
+
+    def test_stream_buffer_single_writer(self, mock_button_component):
+        """A stream buffer may be shared only by buttons dispatched from the same task"""
+        buffer = freertos.xStreamBufferCreate(4 * RECORD_SIZE, 1)
+
+        first = create_button(esp.BUTTON_SINK_STREAM_BUFFER, buffer, gpio_num=4)
+        assert first is not None
+        assert create_button(esp.BUTTON_SINK_STREAM_BUFFER, buffer, gpio_num=5) is not None
+
+        # A button on an engine would write from the engine task
+        assert create_button(esp.BUTTON_SINK_STREAM_BUFFER, buffer, gpio_num=6, engine=0x1000) is None
+
+        # Once the timer service buttons are gone, an engine may take the buffer over
+        for handle in list(button_longpress.button_instances):
+            assert button_longpress.button_delete(handle) == esp.ESP_OK
+        assert create_button(esp.BUTTON_SINK_STREAM_BUFFER, buffer, gpio_num=6, engine=0x1000) is not None
+
+    def test_stream_buffer_table_limit(self, mock_button_component):
+        """At most BUTTON_MAX_STREAM_SINKS distinct stream buffers are tracked"""
+        for i in range(esp.BUTTON_MAX_STREAM_SINKS):
+            buffer = freertos.xStreamBufferCreate(RECORD_SIZE, 1)
+            assert create_button(esp.BUTTON_SINK_STREAM_BUFFER, buffer, gpio_num=i) is not None
+
+        buffer = freertos.xStreamBufferCreate(RECORD_SIZE, 1)
+        assert create_button(esp.BUTTON_SINK_STREAM_BUFFER, buffer, gpio_num=20) is None
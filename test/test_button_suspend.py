@@ -0,0 +1,159 @@
+"""
+Tests for suspending and resuming buttons around low-power modes
+"""
+import pytest
+import ctypes
+import sys
+import os
+
+# Ensure proper imports
+sys.path.insert(0, os.path.dirname(__file__))
+
+# Import the conftest module to access the mock objects
+from conftest import esp, gpio, freertos, ButtonConfig
+
+# Import the button_longpress module
+import button_longpress
+
+# Define a C-compatible callback function type
+BUTTON_CALLBACK = ctypes.CFUNCTYPE(None, ctypes.c_int)
+
+# Global variable to track callback calls as (event, time)
+callback_calls = []
+
+@BUTTON_CALLBACK
+def button_callback_func(event):
+    callback_calls.append((event, freertos.current_time_ms))
+    return None
+
+GPIO_NUM = 4
+
+def create_button(gpio_num=GPIO_NUM, group=None):
+    config = ButtonConfig(
+        gpio_num=gpio_num,
+        active_level=True,
+        debounce_time_ms=20,
+        long_press_time_ms=1000,
+        double_click_time_ms=300,
+        callback=ctypes.cast(button_callback_func, ctypes.c_void_p),
+        group=group
+    )
+    button = button_longpress.button_create(ctypes.byref(config))
+    assert button is not None
+    return button
+
+def events():
+    return [event for event, _ in callback_calls]
+
+def event_time(event):
+    return next(t for e, t in callback_calls if e == event)
+
+class TestButtonSuspend:
+    """Test class for button_suspend() and button_resume()"""
+    
+    def setup_method(self):
+        callback_calls.clear()
+    
+    def test_suspend_stops_events(self, mock_button_component):
+        """A suspended button reports nothing and runs no timer"""
+        button = create_button()
+        assert button_longpress.button_suspend(button) == esp.ESP_OK
+        
+        gpio.gpio_set_level(GPIO_NUM, 1)
+        freertos.advance_time(2000)
+        assert callback_calls == []
+        assert not any(timer['running'] for timer in freertos.timers.values())
+    
+    def test_resume_reports_press_during_suspend(self, mock_button_component):
+        """Resume resamples the pin"""
+        button = create_button()
+        button_longpress.button_suspend(button)
+        gpio.gpio_set_level(GPIO_NUM, 1)
+        freertos.advance_time(100)
+        
+        assert button_longpress.button_resume(button) == esp.ESP_OK
+        freertos.advance_time(50)
+        assert events() == [esp.BUTTON_EVENT_PRESSED]
+        assert button_longpress.button_is_pressed(button)
+    
+    def test_resume_reports_release_during_suspend(self, mock_button_component):
+        """A press released while suspended completes as a click"""
+        button = create_button()
+        gpio.gpio_set_level(GPIO_NUM, 1)
+        freertos.advance_time(50)
+        button_longpress.button_suspend(button)
+        gpio.gpio_set_level(GPIO_NUM, 0)
+        freertos.advance_time(500)
+        assert events() == [esp.BUTTON_EVENT_PRESSED]
+        
+        button_longpress.button_resume(button)
+        freertos.advance_time(400)
+        assert events() == [esp.BUTTON_EVENT_PRESSED, esp.BUTTON_EVENT_RELEASED, esp.BUTTON_EVENT_CLICK]
+    
+    def test_long_press_held_through_suspend(self, mock_button_component):
+        """A long press threshold passed while suspended is reported on resume"""
+        button = create_button()
+        gpio.gpio_set_level(GPIO_NUM, 1)
+        freertos.advance_time(200)
+        button_longpress.button_suspend(button)
+        freertos.advance_time(2000)
+        assert esp.BUTTON_EVENT_LONG_PRESS not in events()
+        
+        resume_time = freertos.current_time_ms
+        button_longpress.button_resume(button)
+        freertos.advance_time(50)
+        assert esp.BUTTON_EVENT_LONG_PRESS in events()
+        assert event_time(esp.BUTTON_EVENT_LONG_PRESS) - resume_time <= 10
+    
+    def test_pending_click_window_restarts(self, mock_button_component):
+        """An open double click window is restarted on resume"""
+        button = create_button()
+        gpio.gpio_set_level(GPIO_NUM, 1)
+        freertos.advance_time(50)
+        gpio.gpio_set_level(GPIO_NUM, 0)
+        freertos.advance_time(100)
+        button_longpress.button_suspend(button)
+        freertos.advance_time(1000)
+        assert esp.BUTTON_EVENT_CLICK not in events()
+        
+        resume_time = freertos.current_time_ms
+        button_longpress.button_resume(button)
+        freertos.advance_time(400)
+        assert esp.BUTTON_EVENT_CLICK in events()
+        assert event_time(esp.BUTTON_EVENT_CLICK) - resume_time == 300
+    
+    def test_no_resource_churn(self, mock_button_component):
+        """Suspend and resume neither free nor allocate kernel objects"""
+        button = create_button()
+        objects = freertos.kernel_objects()
+        freertos.calls.clear()
+        
+        button_longpress.button_suspend(button)
+        button_longpress.button_resume(button)
+        assert freertos.kernel_objects() == objects
+        for primitive in ("xTimerCreate", "xTimerDelete", "xSemaphoreCreateMutex", "vSemaphoreDelete"):
+            assert freertos.calls[primitive] == 0
+    
+    def test_group_suspend_resume(self, mock_button_component):
+        """Group calls apply to every member"""
+        group = button_longpress.button_group_create()
+        create_button(4, group)
+        create_button(5, group)
+        
+        assert button_longpress.button_group_suspend(group) == esp.ESP_OK
+        gpio.gpio_set_level(4, 1)
+        gpio.gpio_set_level(5, 1)
+        freertos.advance_time(100)
+        assert callback_calls == []
+        
+        assert button_longpress.button_group_resume(group) == esp.ESP_OK
+        freertos.advance_time(50)
+        assert events() == [esp.BUTTON_EVENT_PRESSED, esp.BUTTON_EVENT_PRESSED]
+        assert button_longpress.button_group_get_pressed_mask(group) == 0b11
+    
+    def test_invalid_handle(self, mock_button_component):
+        """Invalid handles are rejected"""
+        assert button_longpress.button_suspend(None) == esp.ESP_ERR_INVALID_ARG
+        assert button_longpress.button_resume(None) == esp.ESP_ERR_INVALID_ARG
+        assert button_longpress.button_group_suspend(None) == esp.ESP_ERR_INVALID_ARG
+        assert button_longpress.button_group_resume(None) == esp.ESP_ERR_INVALID_ARG
@@ -0,0 +1,234 @@
+"""
+Tests for asynchronous event waits (the layer under the coroutine front-end)
+"""
+import pytest
+import ctypes
+import sys
+import os
+
+# Ensure proper imports
+sys.path.insert(0, os.path.dirname(__file__))
+
+# Import the conftest module to access the mock objects
+from conftest import esp, gpio, freertos, ButtonConfig, ButtonEventInfo, ButtonWait, BUTTON_WAIT_CALLBACK
+
+# Import the button_longpress module
+import button_longpress
+
+# Completions as event, or None on timeout
+completions = []
+
+# C-compatible completion callback that records results
+@BUTTON_WAIT_CALLBACK
+def wait_callback_func(info, ctx):
+    completions.append(info.contents.event if info else None)
+    return None
+
+def event_mask(*events):
+    """Build a BUTTON_EVENT_MASK() value"""
+    mask = 0
+    for event in events:
+        mask |= 1 << event
+    return mask
+
+class Flow:
+    """Generator-based flow resumed from the dispatch path, like the C++ awaiter"""
+    def __init__(self, generator):
+        self.generator = generator
+        self.wait = ButtonWait()
+        self.results = []
+        self.finished = False
+        # Keep the callback alive while registered
+        self.callback = BUTTON_WAIT_CALLBACK(self._complete)
+        self._step(None)
+    
+    def _complete(self, info, ctx):
+        self._step(info.contents.event if info else None)
+    
+    def _step(self, value):
+        try:
+            handle, mask, timeout = self.generator.send(value)
+        except StopIteration:
+            self.finished = True
+            return
+        handles = (ctypes.c_void_p * 1)(handle)
+        self.handles = handles
+        assert button_longpress.button_wait_event_async(
+            self.wait, handles, 1, mask, timeout, self.callback, None) == esp.ESP_OK
+
+class TestButtonWait:
+    """Test class for asynchronous event waits"""
+    
+    def setup_method(self):
+        """Setup method called before each test"""
+        completions.clear()
+    
+    def make_button(self, gpio_num):
+        config = ButtonConfig(
+            gpio_num=gpio_num,
+            active_level=True,
+            debounce_time_ms=20,
+            long_press_time_ms=500,
+            double_click_time_ms=200
+        )
+        button = button_longpress.button_create(ctypes.byref(config))
+        assert button is not None
+        return button
+    
+    def click(self, gpio_num):
+        gpio.gpio_set_level(gpio_num, 1)
+        freertos.advance_time(30)
+        gpio.gpio_set_level(gpio_num, 0)
+        freertos.advance_time(30)
+    
+    def schedule(self, delay_ms, action):
+        """Run action from a one-shot timer, as another task would while the caller blocks"""
+        timer = freertos.xTimerCreate("test", delay_ms // 10, False, None, lambda timer_id: action())
+        freertos.xTimerStart(timer, 0)
+    
+    def test_blocking_wait_wakes_on_event(self, mock_button_component, button_config):
+        """Test that a blocking wait returns the first matching event of its buttons"""
+        button = self.make_button(button_config['gpio_num'])
+        other = self.make_button(5)
+        
+        self.schedule(50, lambda: gpio.gpio_set_level(5, 1))
+        self.schedule(100, lambda: gpio.gpio_set_level(button_config['gpio_num'], 1))
+        
+        out = ButtonEventInfo()
+        handles = (ctypes.c_void_p * 1)(button)
+        assert button_longpress.button_wait_event(
+            handles, 1, event_mask(esp.BUTTON_EVENT_PRESSED), 50, out) == esp.ESP_OK
+        assert out.event == esp.BUTTON_EVENT_PRESSED
+        assert out.button == button
+        assert freertos.current_time_ms == 120
+        
+        # Nothing is left registered and the semaphore is gone
+        assert button_longpress.waiters == []
+        assert freertos.binary_sems == {}
+        
+        button_longpress.button_delete(button)
+        button_longpress.button_delete(other)
+    
+    def test_blocking_wait_timeout(self, mock_button_component, button_config):
+        """Test that a blocking wait times out and unregisters itself"""
+        button = self.make_button(button_config['gpio_num'])
+        
+        out = ButtonEventInfo()
+        assert button_longpress.button_wait_event(
+            None, 0, event_mask(esp.BUTTON_EVENT_LONG_PRESS), 30, out) == esp.ESP_ERR_TIMEOUT
+        assert freertos.current_time_ms == 300
+        assert button_longpress.waiters == []
+        assert freertos.binary_sems == {}
+        
+        # Later events find no stale waiter
+        self.click(button_config['gpio_num'])
+        freertos.advance_time(300)
+        
+        assert button_longpress.button_wait_event(None, 0, 0, 10, None) == esp.ESP_ERR_INVALID_ARG
+        
+        button_longpress.button_delete(button)
+    
+    def test_wait_completes_on_matching_event(self, mock_button_component, button_config):
+        """Test that only a matching event of the awaited button completes the wait"""
+        button = self.make_button(button_config['gpio_num'])
+        other = self.make_button(5)
+        
+        wait = ButtonWait()
+        handles = (ctypes.c_void_p * 1)(button)
+        assert button_longpress.button_wait_event_async(
+            wait, handles, 1, event_mask(esp.BUTTON_EVENT_CLICK),
+            freertos.portMAX_DELAY, wait_callback_func, None) == esp.ESP_OK
+        
+        # Other button and other events do not complete it
+        self.click(5)
+        freertos.advance_time(300)
+        gpio.gpio_set_level(button_config['gpio_num'], 1)
+        freertos.advance_time(30)
+        assert completions == []
+        
+        gpio.gpio_set_level(button_config['gpio_num'], 0)
+        freertos.advance_time(300)
+        assert completions == [esp.BUTTON_EVENT_CLICK]
+        
+        # Completed exactly once
+        self.click(button_config['gpio_num'])
+        freertos.advance_time(300)
+        assert completions == [esp.BUTTON_EVENT_CLICK]
+        assert not button_longpress.button_wait_event_cancel(wait)
+        
+        button_longpress.button_delete(button)
+        button_longpress.button_delete(other)
+    
+    def test_wait_timeout(self, mock_button_component, button_config):
+        """Test that timeouts complete with no event, nearest deadline first"""
+        button = self.make_button(button_config['gpio_num'])
+        
+        short_wait = ButtonWait()
+        long_wait = ButtonWait()
+        assert button_longpress.button_wait_event_async(
+            long_wait, None, 0, 0, 50, wait_callback_func, None) == esp.ESP_OK
+        assert button_longpress.button_wait_event_async(
+            short_wait, None, 0, event_mask(esp.BUTTON_EVENT_LONG_PRESS), 20,
+            wait_callback_func, None) == esp.ESP_OK
+        
+        freertos.advance_time(190)
+        assert completions == []
+        freertos.advance_time(20)
+        assert completions == [None]
+        freertos.advance_time(300)
+        assert completions == [None, None]
+        
+        button_longpress.button_delete(button)
+    
+    def test_wait_cancel(self, mock_button_component, button_config):
+        """Test that a cancelled wait never completes"""
+        button = self.make_button(button_config['gpio_num'])
+        
+        wait = ButtonWait()
+        assert button_longpress.button_wait_event_async(
+            wait, None, 0, 0, 10, wait_callback_func, None) == esp.ESP_OK
+        assert button_longpress.button_wait_event_cancel(wait)
+        assert not button_longpress.button_wait_event_cancel(wait)
+        
+        self.click(button_config['gpio_num'])
+        freertos.advance_time(300)
+        assert completions == []
+        
+        button_longpress.button_delete(button)
+    
+    def test_wait_invalid_args(self, mock_button_component):
+        """Test invalid asynchronous wait arguments"""
+        wait = ButtonWait()
+        assert button_longpress.button_wait_event_async(
+            None, None, 0, 0, 10, wait_callback_func, None) == esp.ESP_ERR_INVALID_ARG
+        assert button_longpress.button_wait_event_async(
+            wait, None, 0, 0, 10, None, None) == esp.ESP_ERR_INVALID_ARG
+    
+    def test_flow_without_task(self, mock_button_component, button_config):
+        """Test a multi-step flow driven entirely from the dispatch path"""
+        button = self.make_button(button_config['gpio_num'])
+        steps = []
+        
+        def unlock_flow():
+            event = yield (button, event_mask(esp.BUTTON_EVENT_LONG_PRESS), freertos.portMAX_DELAY)
+            steps.append(event)
+            event = yield (button, event_mask(esp.BUTTON_EVENT_DOUBLE_CLICK), 100)
+            steps.append(event)
+        
+        flow = Flow(unlock_flow())
+        
+        # Long press resumes the flow
+        gpio.gpio_set_level(button_config['gpio_num'], 1)
+        freertos.advance_time(600)
+        gpio.gpio_set_level(button_config['gpio_num'], 0)
+        freertos.advance_time(30)
+        assert steps == [esp.BUTTON_EVENT_LONG_PRESS]
+        
+        # Double click within the timeout completes it
+        self.click(button_config['gpio_num'])
+        freertos.advance_time(50)
+        self.click(button_config['gpio_num'])
+        assert steps == [esp.BUTTON_EVENT_LONG_PRESS, esp.BUTTON_EVENT_DOUBLE_CLICK]
+        assert flow.finished
+        
+        button_longpress.button_delete(button)